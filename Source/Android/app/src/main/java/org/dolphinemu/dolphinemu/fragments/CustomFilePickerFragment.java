@@ -19,7 +19,7 @@ import java.util.Set;
 public class CustomFilePickerFragment extends FilePickerFragment
 {
   private static final Set<String> extensions = new HashSet<>(Arrays.asList(
-          "gcm", "tgc", "iso", "ciso", "gcz", "wbfs", "wad", "dol", "elf", "dff"));
+          "gcm", "tgc", "iso", "ciso", "gcz", "bcz", "wbfs", "wad", "dol", "elf", "dff"));
 
   @NonNull
   @Override
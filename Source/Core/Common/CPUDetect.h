@@ -54,13 +54,13 @@ struct CPUInfo
   bool bLAHFSAHF64 = false;
   bool bLongMode = false;
   bool bAtom = false;
+  bool bSHA1 = false;
+  bool bSHA2 = false;
 
   // ARMv8 specific
   bool bFP = false;
   bool bASIMD = false;
   bool bCRC32 = false;
-  bool bSHA1 = false;
-  bool bSHA2 = false;
 
   // Call Detect()
   explicit CPUInfo();
@@ -68,6 +68,7 @@
 #define WFSROOT_DIR "WFS"
 #define BACKUP_DIR "Backup"
 #define RESOURCEPACK_DIR "ResourcePacks"
+#define REDUMP_DIR "Redump"
 
 // This one is only used to remove it if it was present
 #define SHADERCACHE_LEGACY_DIR "ShaderCache"
@@ -88,6 +89,9 @@
 // Files in the directory returned by GetUserPath(D_LOGS_IDX)
 #define MAIN_LOG "dolphin.log"
 
+// Files in the directory returned by GetUserPath(D_DUMPFRAMES_IDX)
+#define FRAME_CHECKSUM_LOG "framechecksums.txt"
+
 // Files in the directory returned by GetUserPath(D_WIISYSCONF_IDX)
 #define WII_SYSCONF "SYSCONF"
 
@@ -2,25 +2,220 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
 #include <mbedtls/aes.h>
 
+#include "Common/CPUDetect.h"
 #include "Common/Crypto/AES.h"
+#include "Common/Intrinsics.h"
 
 namespace Common::AES
 {
-std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size, Mode mode)
+namespace
 {
-  mbedtls_aes_context aes_ctx;
-  std::vector<u8> buffer(size);
+constexpr size_t BLOCK_SIZE = 16;
+
+class ContextGeneric final : public Context
+{
+public:
+  ContextGeneric(Mode mode, const u8* key) : m_mode(mode)
+  {
+    mbedtls_aes_init(&m_ctx);
+    if (mode == Mode::Encrypt)
+      mbedtls_aes_setkey_enc(&m_ctx, key, 128);
+    else
+      mbedtls_aes_setkey_dec(&m_ctx, key, 128);
+  }
+
+  ~ContextGeneric() override { mbedtls_aes_free(&m_ctx); }
+
+  bool Crypt(const u8* iv, u8* iv_out, const u8* buf_in, u8* buf_out, size_t len) const override
+  {
+    std::array<u8, BLOCK_SIZE> iv_tmp;
+    std::memcpy(iv_tmp.data(), iv, BLOCK_SIZE);
+
+    // mbedtls_aes_crypt_cbc doesn't modify the context, it just isn't declared as const
+    const int mbed_mode = m_mode == Mode::Encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+    if (mbedtls_aes_crypt_cbc(const_cast<mbedtls_aes_context*>(&m_ctx), mbed_mode, len,
+                              iv_tmp.data(), buf_in, buf_out) != 0)
+    {
+      return false;
+    }
+
+    if (iv_out)
+      std::memcpy(iv_out, iv_tmp.data(), BLOCK_SIZE);
+    return true;
+  }
+
+private:
+  Mode m_mode;
+  mbedtls_aes_context m_ctx;
+};
+
+#ifdef _M_X86_64
+
+constexpr size_t NUM_ROUND_KEYS = 11;
+
+template <int rcon>
+FUNCTION_TARGET_AES static inline __m128i ExpandKey(__m128i key)
+{
+  __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(key, rcon), 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+class ContextAESNI final : public Context
+{
+public:
+  FUNCTION_TARGET_AES ContextAESNI(Mode mode, const u8* key) : m_mode(mode)
+  {
+    __m128i enc[NUM_ROUND_KEYS];
+    enc[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    enc[1] = ExpandKey<0x01>(enc[0]);
+    enc[2] = ExpandKey<0x02>(enc[1]);
+    enc[3] = ExpandKey<0x04>(enc[2]);
+    enc[4] = ExpandKey<0x08>(enc[3]);
+    enc[5] = ExpandKey<0x10>(enc[4]);
+    enc[6] = ExpandKey<0x20>(enc[5]);
+    enc[7] = ExpandKey<0x40>(enc[6]);
+    enc[8] = ExpandKey<0x80>(enc[7]);
+    enc[9] = ExpandKey<0x1b>(enc[8]);
+    enc[10] = ExpandKey<0x36>(enc[9]);
+
+    if (mode == Mode::Encrypt)
+    {
+      std::copy(std::begin(enc), std::end(enc), std::begin(m_round_keys));
+      return;
+    }
+
+    // The equivalent inverse cipher uses the round keys in reverse order, with InvMixColumns
+    // applied to all but the first and last ones
+    m_round_keys[0] = enc[10];
+    for (size_t i = 1; i < NUM_ROUND_KEYS - 1; ++i)
+      m_round_keys[i] = _mm_aesimc_si128(enc[NUM_ROUND_KEYS - 1 - i]);
+    m_round_keys[10] = enc[0];
+  }
+
+  FUNCTION_TARGET_AES bool Crypt(const u8* iv, u8* iv_out, const u8* buf_in, u8* buf_out,
+                                 size_t len) const override
+  {
+    if (len % BLOCK_SIZE != 0)
+      return false;
+
+    const __m128i* in = reinterpret_cast<const __m128i*>(buf_in);
+    __m128i* out = reinterpret_cast<__m128i*>(buf_out);
+    const size_t num_blocks = len / BLOCK_SIZE;
 
-  if (mode == Mode::Encrypt)
-    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-  else
-    mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
+    __m128i chain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    if (m_mode == Mode::Encrypt)
+      chain = EncryptCBC(chain, in, out, num_blocks);
+    else
+      chain = DecryptCBC(chain, in, out, num_blocks);
 
-  mbedtls_aes_crypt_cbc(&aes_ctx, mode == Mode::Encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT,
-                        size, iv, src, buffer.data());
+    if (iv_out)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(iv_out), chain);
+    return true;
+  }
 
+private:
+  // Each block depends on the previous one, so encryption can't be interleaved
+  FUNCTION_TARGET_AES __m128i EncryptCBC(__m128i chain, const __m128i* in, __m128i* out,
+                                         size_t num_blocks) const
+  {
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+      __m128i block = _mm_xor_si128(_mm_loadu_si128(in + i), chain);
+      block = _mm_xor_si128(block, m_round_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        block = _mm_aesenc_si128(block, m_round_keys[round]);
+      chain = _mm_aesenclast_si128(block, m_round_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(out + i, chain);
+    }
+    return chain;
+  }
+
+  // Decrypting a block only depends on the ciphertext, so several blocks are decrypted at once to
+  // hide the latency of the AES instructions
+  FUNCTION_TARGET_AES __m128i DecryptCBC(__m128i chain, const __m128i* in, __m128i* out,
+                                         size_t num_blocks) const
+  {
+    constexpr size_t PARALLEL_BLOCKS = 8;
+
+    size_t i = 0;
+    for (; i + PARALLEL_BLOCKS <= num_blocks; i += PARALLEL_BLOCKS)
+    {
+      __m128i cipher[PARALLEL_BLOCKS];
+      __m128i block[PARALLEL_BLOCKS];
+      for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+      {
+        cipher[j] = _mm_loadu_si128(in + i + j);
+        block[j] = _mm_xor_si128(cipher[j], m_round_keys[0]);
+      }
+
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+      {
+        for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+          block[j] = _mm_aesdec_si128(block[j], m_round_keys[round]);
+      }
+
+      for (size_t j = 0; j < PARALLEL_BLOCKS; ++j)
+      {
+        block[j] = _mm_aesdeclast_si128(block[j], m_round_keys[NUM_ROUND_KEYS - 1]);
+        _mm_storeu_si128(out + i + j, _mm_xor_si128(block[j], chain));
+        chain = cipher[j];
+      }
+    }
+
+    for (; i < num_blocks; ++i)
+    {
+      const __m128i cipher = _mm_loadu_si128(in + i);
+      __m128i block = _mm_xor_si128(cipher, m_round_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        block = _mm_aesdec_si128(block, m_round_keys[round]);
+      block = _mm_aesdeclast_si128(block, m_round_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(out + i, _mm_xor_si128(block, chain));
+      chain = cipher;
+    }
+
+    return chain;
+  }
+
+  Mode m_mode;
+  __m128i m_round_keys[NUM_ROUND_KEYS];
+};
+
+#endif
+
+std::unique_ptr<Context> CreateContext(Mode mode, const u8* key)
+{
+#ifdef _M_X86_64
+  if (cpu_info.bAES && cpu_info.bSSE4_1)
+    return std::make_unique<ContextAESNI>(mode, key);
+#endif
+  return std::make_unique<ContextGeneric>(mode, key);
+}
+}  // Anonymous namespace
+
+std::unique_ptr<Context> CreateContextEncrypt(const u8* key)
+{
+  return CreateContext(Mode::Encrypt, key);
+}
+
+std::unique_ptr<Context> CreateContextDecrypt(const u8* key)
+{
+  return CreateContext(Mode::Decrypt, key);
+}
+
+std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size, Mode mode)
+{
+  std::vector<u8> buffer(size);
+  CreateContext(mode, key)->Crypt(iv, iv, src, buffer.data(), size);
   return buffer;
 }
 
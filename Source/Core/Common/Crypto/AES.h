@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -16,6 +17,30 @@ enum class Mode
   Decrypt,
   Encrypt,
 };
+
+// An AES-128 key that is set up for either encryption or decryption. Uses the AES instructions of
+// the host CPU when they are available. Crypt doesn't modify the context, so one context can be
+// used by several threads at the same time.
+class Context
+{
+public:
+  virtual ~Context() = default;
+
+  // Encrypts or decrypts len bytes in CBC mode. len must be a multiple of 16, and buf_in and
+  // buf_out may point to the same buffer. If iv_out isn't nullptr, the IV that continues the
+  // chain after the last block is written to it (iv_out may point to iv).
+  virtual bool Crypt(const u8* iv, u8* iv_out, const u8* buf_in, u8* buf_out,
+                     size_t len) const = 0;
+
+  bool Crypt(const u8* iv, const u8* buf_in, u8* buf_out, size_t len) const
+  {
+    return Crypt(iv, nullptr, buf_in, buf_out, len);
+  }
+};
+
+std::unique_ptr<Context> CreateContextEncrypt(const u8* key);
+std::unique_ptr<Context> CreateContextDecrypt(const u8* key);
+
 std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size, Mode mode);
 
 // Convenience functions
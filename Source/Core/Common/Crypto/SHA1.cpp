@@ -0,0 +1,234 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/Crypto/SHA1.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+#include <mbedtls/sha1.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+#include "Common/Swap.h"
+
+namespace Common::SHA1
+{
+namespace
+{
+class ContextGeneric final : public Context
+{
+public:
+  ContextGeneric()
+  {
+    mbedtls_sha1_init(&m_ctx);
+    mbedtls_sha1_starts_ret(&m_ctx);
+  }
+
+  ~ContextGeneric() override { mbedtls_sha1_free(&m_ctx); }
+
+  void Update(const u8* msg, size_t len) override { mbedtls_sha1_update_ret(&m_ctx, msg, len); }
+
+  Digest Finish() override
+  {
+    Digest digest;
+    mbedtls_sha1_finish_ret(&m_ctx, digest.data());
+    return digest;
+  }
+
+private:
+  mbedtls_sha1_context m_ctx;
+};
+
+#ifdef _M_X86_64
+
+constexpr size_t BLOCK_SIZE = 64;
+
+// Computes the next four message schedule words from the previous sixteen
+FUNCTION_TARGET_SHA static inline __m128i NextMessage(__m128i w0, __m128i w1, __m128i w2,
+                                                      __m128i w3)
+{
+  return _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w0, w1), w2), w3);
+}
+
+// Performs four rounds. prev_abcd is the state from before the previous four rounds, which the
+// value of E for these rounds is derived from.
+template <int func>
+FUNCTION_TARGET_SHA static inline void FourRounds(__m128i* abcd, __m128i* prev_abcd, __m128i w)
+{
+  const __m128i e = _mm_sha1nexte_epu32(*prev_abcd, w);
+  *prev_abcd = *abcd;
+  *abcd = _mm_sha1rnds4_epu32(*abcd, e, func);
+}
+
+class ContextSHANI final : public Context
+{
+public:
+  void Update(const u8* msg, size_t len) override
+  {
+    m_length += len;
+
+    if (m_buffer_used != 0)
+    {
+      const size_t to_copy = std::min(len, BLOCK_SIZE - m_buffer_used);
+      std::memcpy(m_buffer.data() + m_buffer_used, msg, to_copy);
+      m_buffer_used += to_copy;
+      msg += to_copy;
+      len -= to_copy;
+      if (m_buffer_used != BLOCK_SIZE)
+        return;
+
+      ProcessBlocks(m_buffer.data(), 1);
+      m_buffer_used = 0;
+    }
+
+    ProcessBlocks(msg, len / BLOCK_SIZE);
+    msg += len / BLOCK_SIZE * BLOCK_SIZE;
+    len %= BLOCK_SIZE;
+
+    std::memcpy(m_buffer.data(), msg, len);
+    m_buffer_used = len;
+  }
+
+  Digest Finish() override
+  {
+    const u64 length_in_bits = Common::swap64(m_length * 8);
+
+    // Pad with a one bit and zeroes so that the length fits at the end of the last block
+    m_buffer[m_buffer_used++] = 0x80;
+    if (m_buffer_used > BLOCK_SIZE - sizeof(length_in_bits))
+    {
+      std::fill(m_buffer.begin() + m_buffer_used, m_buffer.end(), 0);
+      ProcessBlocks(m_buffer.data(), 1);
+      m_buffer_used = 0;
+    }
+    std::fill(m_buffer.begin() + m_buffer_used, m_buffer.end() - sizeof(length_in_bits), 0);
+    std::memcpy(m_buffer.data() + BLOCK_SIZE - sizeof(length_in_bits), &length_in_bits,
+                sizeof(length_in_bits));
+    ProcessBlocks(m_buffer.data(), 1);
+
+    Digest digest;
+    for (size_t i = 0; i < m_state.size(); ++i)
+    {
+      const u32 word = Common::swap32(m_state[i]);
+      std::memcpy(digest.data() + i * sizeof(word), &word, sizeof(word));
+    }
+    return digest;
+  }
+
+private:
+  FUNCTION_TARGET_SHA void ProcessBlocks(const u8* data, size_t num_blocks)
+  {
+    // The message words are big endian
+    const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607, 0x08090a0b0c0d0e0f);
+
+    // The instructions keep A in the highest lane and E on its own
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i*>(m_state.data())),
+                                     0x1b);
+    __m128i e = _mm_set_epi32(m_state[4], 0, 0, 0);
+
+    for (size_t block = 0; block < num_blocks; ++block, data += BLOCK_SIZE)
+    {
+      const __m128i abcd_save = abcd;
+      const __m128i e_save = e;
+
+      const __m128i* in = reinterpret_cast<const __m128i*>(data);
+      __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128(in + 0), byte_swap);
+      __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), byte_swap);
+      __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), byte_swap);
+      __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), byte_swap);
+
+      // Rounds 0-3 use the E from the previous block
+      __m128i prev_abcd = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, _mm_add_epi32(e, w0), 0);
+
+      FourRounds<0>(&abcd, &prev_abcd, w1);
+      FourRounds<0>(&abcd, &prev_abcd, w2);
+      FourRounds<0>(&abcd, &prev_abcd, w3);
+      w0 = NextMessage(w0, w1, w2, w3);
+      FourRounds<0>(&abcd, &prev_abcd, w0);
+
+      w1 = NextMessage(w1, w2, w3, w0);
+      FourRounds<1>(&abcd, &prev_abcd, w1);
+      w2 = NextMessage(w2, w3, w0, w1);
+      FourRounds<1>(&abcd, &prev_abcd, w2);
+      w3 = NextMessage(w3, w0, w1, w2);
+      FourRounds<1>(&abcd, &prev_abcd, w3);
+      w0 = NextMessage(w0, w1, w2, w3);
+      FourRounds<1>(&abcd, &prev_abcd, w0);
+      w1 = NextMessage(w1, w2, w3, w0);
+      FourRounds<1>(&abcd, &prev_abcd, w1);
+
+      w2 = NextMessage(w2, w3, w0, w1);
+      FourRounds<2>(&abcd, &prev_abcd, w2);
+      w3 = NextMessage(w3, w0, w1, w2);
+      FourRounds<2>(&abcd, &prev_abcd, w3);
+      w0 = NextMessage(w0, w1, w2, w3);
+      FourRounds<2>(&abcd, &prev_abcd, w0);
+      w1 = NextMessage(w1, w2, w3, w0);
+      FourRounds<2>(&abcd, &prev_abcd, w1);
+      w2 = NextMessage(w2, w3, w0, w1);
+      FourRounds<2>(&abcd, &prev_abcd, w2);
+
+      w3 = NextMessage(w3, w0, w1, w2);
+      FourRounds<3>(&abcd, &prev_abcd, w3);
+      w0 = NextMessage(w0, w1, w2, w3);
+      FourRounds<3>(&abcd, &prev_abcd, w0);
+      w1 = NextMessage(w1, w2, w3, w0);
+      FourRounds<3>(&abcd, &prev_abcd, w1);
+      w2 = NextMessage(w2, w3, w0, w1);
+      FourRounds<3>(&abcd, &prev_abcd, w2);
+      w3 = NextMessage(w3, w0, w1, w2);
+      FourRounds<3>(&abcd, &prev_abcd, w3);
+
+      e = _mm_sha1nexte_epu32(prev_abcd, e_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m_state.data()), _mm_shuffle_epi32(abcd, 0x1b));
+    m_state[4] = static_cast<u32>(_mm_extract_epi32(e, 3));
+  }
+
+  std::array<u32, 5> m_state{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+  std::array<u8, BLOCK_SIZE> m_buffer;
+  size_t m_buffer_used = 0;
+  u64 m_length = 0;
+};
+
+bool HasSHANI()
+{
+  return cpu_info.bSHA1 && cpu_info.bSSE4_1;
+}
+
+#endif
+}  // Anonymous namespace
+
+std::unique_ptr<Context> CreateContext()
+{
+#ifdef _M_X86_64
+  if (HasSHANI())
+    return std::make_unique<ContextSHANI>();
+#endif
+  return std::make_unique<ContextGeneric>();
+}
+
+Digest CalculateDigest(const u8* msg, size_t len)
+{
+#ifdef _M_X86_64
+  if (HasSHANI())
+  {
+    ContextSHANI ctx;
+    ctx.Update(msg, len);
+    return ctx.Finish();
+  }
+#endif
+
+  Digest digest;
+  mbedtls_sha1_ret(msg, len, digest.data());
+  return digest;
+}
+}  // namespace Common::SHA1
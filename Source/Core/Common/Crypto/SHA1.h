@@ -0,0 +1,50 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common::SHA1
+{
+using Digest = std::array<u8, 20>;
+static constexpr size_t DIGEST_LEN = 20;
+
+// Uses the SHA instructions of the host CPU when they are available
+class Context
+{
+public:
+  virtual ~Context() = default;
+  virtual void Update(const u8* msg, size_t len) = 0;
+  void Update(const std::vector<u8>& msg) { Update(msg.data(), msg.size()); }
+  virtual Digest Finish() = 0;
+};
+
+std::unique_ptr<Context> CreateContext();
+
+Digest CalculateDigest(const u8* msg, size_t len);
+
+template <typename T>
+inline Digest CalculateDigest(const std::vector<T>& msg)
+{
+  return CalculateDigest(reinterpret_cast<const u8*>(msg.data()), sizeof(T) * msg.size());
+}
+
+inline Digest CalculateDigest(const std::string_view& msg)
+{
+  return CalculateDigest(reinterpret_cast<const u8*>(msg.data()), msg.size());
+}
+
+template <typename T, size_t Size>
+inline Digest CalculateDigest(const std::array<T, Size>& msg)
+{
+  return CalculateDigest(reinterpret_cast<const u8*>(msg.data()), sizeof(msg));
+}
+}  // namespace Common::SHA1
@@ -53,6 +53,8 @@ enum
   D_WFSROOT_IDX,
   D_BACKUP_IDX,
   D_RESOURCEPACK_IDX,
+  D_REDUMP_IDX,
+  D_REDUMPCACHE_IDX,
   F_DOLPHINCONFIG_IDX,
   F_GCPADCONFIG_IDX,
   F_WIIPADCONFIG_IDX,
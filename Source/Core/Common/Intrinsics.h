@@ -40,6 +40,12 @@
 #ifndef __SSE3__
 #define FUNCTION_TARGET_SSE3 [[gnu::target("sse3")]]
 #endif
+#if !defined(__AES__) || !defined(__SSE4_1__)
+#define FUNCTION_TARGET_AES [[gnu::target("aes,sse4.1")]]
+#endif
+#if !defined(__SHA__) || !defined(__SSE4_1__)
+#define FUNCTION_TARGET_SHA [[gnu::target("sha,sse4.1")]]
+#endif
 
 #elif defined(_MSC_VER) || defined(__INTEL_COMPILER)
 
@@ -70,3 +76,9 @@
 #ifndef FUNCTION_TARGET_SSE3
 #define FUNCTION_TARGET_SSE3
 #endif
+#ifndef FUNCTION_TARGET_AES
+#define FUNCTION_TARGET_AES
+#endif
+#ifndef FUNCTION_TARGET_SHA
+#define FUNCTION_TARGET_SHA
+#endif
@@ -5,8 +5,10 @@
 #pragma once
 
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <thread>
+#include <utility>
 
 #include "Common/Event.h"
 #include "Common/Flag.h"
@@ -64,7 +66,7 @@ private:
           std::unique_lock<std::mutex> lg(m_lock);
           if (m_items.empty())
             break;
-          item = m_items.front();
+          item = std::move(m_items.front());
           m_items.pop();
         }
         m_function(std::move(item));
@@ -53,6 +53,13 @@ const ConfigInfo<std::string> GFX_DUMP_PATH{{System::GFX, "Settings", "DumpPath"
 const ConfigInfo<int> GFX_BITRATE_KBPS{{System::GFX, "Settings", "BitrateKbps"}, 25000};
 const ConfigInfo<bool> GFX_INTERNAL_RESOLUTION_FRAME_DUMPS{
     {System::GFX, "Settings", "InternalResolutionFrameDumps"}, false};
+const ConfigInfo<int> GFX_FRAME_DUMP_QUEUE_SIZE{{System::GFX, "Settings", "FrameDumpQueueSize"}, 8};
+const ConfigInfo<bool> GFX_LOG_FRAME_CHECKSUMS{
+    {System::GFX, "Settings", "LogFrameChecksums"}, false};
+const ConfigInfo<int> GFX_TIMELINE_CAPTURE_FIRST_FRAME{
+    {System::GFX, "Settings", "TimelineCaptureFirstFrame"}, 0};
+const ConfigInfo<int> GFX_TIMELINE_CAPTURE_FRAMES{
+    {System::GFX, "Settings", "TimelineCaptureFrames"}, 0};
 const ConfigInfo<bool> GFX_ENABLE_GPU_TEXTURE_DECODING{
     {System::GFX, "Settings", "EnableGPUTextureDecoding"}, false};
 const ConfigInfo<bool> GFX_ENABLE_PIXEL_LIGHTING{{System::GFX, "Settings", "EnablePixelLighting"},
@@ -82,6 +89,8 @@ const ConfigInfo<bool> GFX_BACKEND_MULTITHREADING{
 
 const ConfigInfo<int> GFX_COMMAND_BUFFER_EXECUTE_INTERVAL{
     {System::GFX, "Settings", "CommandBufferExecuteInterval"}, 100};
+const ConfigInfo<bool> GFX_PARALLEL_COMMAND_RECORDING{
+    {System::GFX, "Settings", "ParallelCommandRecording"}, false};
 const ConfigInfo<bool> GFX_SHADER_CACHE{{System::GFX, "Settings", "ShaderCache"}, true};
 const ConfigInfo<bool> GFX_WAIT_FOR_SHADERS_BEFORE_STARTING{
     {System::GFX, "Settings", "WaitForShadersBeforeStarting"}, false};
@@ -91,6 +100,8 @@ const ConfigInfo<int> GFX_SHADER_COMPILER_THREADS{
     {System::GFX, "Settings", "ShaderCompilerThreads"}, 1};
 const ConfigInfo<int> GFX_SHADER_PRECOMPILER_THREADS{
     {System::GFX, "Settings", "ShaderPrecompilerThreads"}, 1};
+const ConfigInfo<bool> GFX_PREDICT_PIPELINES{{System::GFX, "Settings", "PredictPipelines"}, false};
+const ConfigInfo<bool> GFX_CPU_CULL{{System::GFX, "Settings", "CPUCull"}, false};
 const ConfigInfo<bool> GFX_SAVE_TEXTURE_CACHE_TO_STATE{
     {System::GFX, "Settings", "SaveTextureCacheToState"}, true};
 
@@ -140,9 +151,13 @@ const ConfigInfo<int> GFX_STEREO_DEPTH_PERCENTAGE{
 const ConfigInfo<bool> GFX_HACK_EFB_ACCESS_ENABLE{{System::GFX, "Hacks", "EFBAccessEnable"}, true};
 const ConfigInfo<bool> GFX_HACK_EFB_DEFER_INVALIDATION{
     {System::GFX, "Hacks", "EFBAccessDeferInvalidation"}, false};
+const ConfigInfo<bool> GFX_HACK_EFB_ACCESS_PREFETCH_TILES{
+    {System::GFX, "Hacks", "EFBAccessPrefetchTiles"}, false};
 const ConfigInfo<int> GFX_HACK_EFB_ACCESS_TILE_SIZE{{System::GFX, "Hacks", "EFBAccessTileSize"},
                                                     64};
 const ConfigInfo<bool> GFX_HACK_BBOX_ENABLE{{System::GFX, "Hacks", "BBoxEnable"}, false};
+const ConfigInfo<bool> GFX_HACK_BBOX_ASYNC_READBACK{
+    {System::GFX, "Hacks", "BBoxAsyncReadback"}, false};
 const ConfigInfo<bool> GFX_HACK_FORCE_PROGRESSIVE{{System::GFX, "Hacks", "ForceProgressive"}, true};
 const ConfigInfo<bool> GFX_HACK_SKIP_EFB_COPY_TO_RAM{{System::GFX, "Hacks", "EFBToTextureEnable"},
                                                      true};
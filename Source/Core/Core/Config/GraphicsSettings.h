@@ -48,6 +48,10 @@ extern const ConfigInfo<std::string> GFX_DUMP_ENCODER;
 extern const ConfigInfo<std::string> GFX_DUMP_PATH;
 extern const ConfigInfo<int> GFX_BITRATE_KBPS;
 extern const ConfigInfo<bool> GFX_INTERNAL_RESOLUTION_FRAME_DUMPS;
+extern const ConfigInfo<int> GFX_FRAME_DUMP_QUEUE_SIZE;
+extern const ConfigInfo<bool> GFX_LOG_FRAME_CHECKSUMS;
+extern const ConfigInfo<int> GFX_TIMELINE_CAPTURE_FIRST_FRAME;
+extern const ConfigInfo<int> GFX_TIMELINE_CAPTURE_FRAMES;
 extern const ConfigInfo<bool> GFX_ENABLE_GPU_TEXTURE_DECODING;
 extern const ConfigInfo<bool> GFX_ENABLE_PIXEL_LIGHTING;
 extern const ConfigInfo<bool> GFX_FAST_DEPTH_CALC;
@@ -62,11 +66,14 @@ extern const ConfigInfo<bool> GFX_BORDERLESS_FULLSCREEN;
 extern const ConfigInfo<bool> GFX_ENABLE_VALIDATION_LAYER;
 extern const ConfigInfo<bool> GFX_BACKEND_MULTITHREADING;
 extern const ConfigInfo<int> GFX_COMMAND_BUFFER_EXECUTE_INTERVAL;
+extern const ConfigInfo<bool> GFX_PARALLEL_COMMAND_RECORDING;
 extern const ConfigInfo<bool> GFX_SHADER_CACHE;
 extern const ConfigInfo<bool> GFX_WAIT_FOR_SHADERS_BEFORE_STARTING;
 extern const ConfigInfo<ShaderCompilationMode> GFX_SHADER_COMPILATION_MODE;
 extern const ConfigInfo<int> GFX_SHADER_COMPILER_THREADS;
 extern const ConfigInfo<int> GFX_SHADER_PRECOMPILER_THREADS;
+extern const ConfigInfo<bool> GFX_PREDICT_PIPELINES;
+extern const ConfigInfo<bool> GFX_CPU_CULL;
 extern const ConfigInfo<bool> GFX_SAVE_TEXTURE_CACHE_TO_STATE;
 
 extern const ConfigInfo<bool> GFX_SW_ZCOMPLOC;
@@ -103,8 +110,10 @@ extern const ConfigInfo<int> GFX_STEREO_DEPTH_PERCENTAGE;
 
 extern const ConfigInfo<bool> GFX_HACK_EFB_ACCESS_ENABLE;
 extern const ConfigInfo<bool> GFX_HACK_EFB_DEFER_INVALIDATION;
+extern const ConfigInfo<bool> GFX_HACK_EFB_ACCESS_PREFETCH_TILES;
 extern const ConfigInfo<int> GFX_HACK_EFB_ACCESS_TILE_SIZE;
 extern const ConfigInfo<bool> GFX_HACK_BBOX_ENABLE;
+extern const ConfigInfo<bool> GFX_HACK_BBOX_ASYNC_READBACK;
 extern const ConfigInfo<bool> GFX_HACK_FORCE_PROGRESSIVE;
 extern const ConfigInfo<bool> GFX_HACK_SKIP_EFB_COPY_TO_RAM;
 extern const ConfigInfo<bool> GFX_HACK_SKIP_XFB_COPY_TO_RAM;
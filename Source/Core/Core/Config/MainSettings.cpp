@@ -103,6 +103,9 @@ const ConfigInfo<bool> MAIN_CUSTOM_RTC_ENABLE{{System::Main, "Core", "EnableCust
 // Default to seconds between 1.1.1970 and 1.1.2000
 const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE{{System::Main, "Core", "CustomRTCValue"}, 946684800};
 const ConfigInfo<bool> MAIN_AUTO_DISC_CHANGE{{System::Main, "Core", "AutoDiscChange"}, false};
+const ConfigInfo<int> MAIN_DISC_CACHE_SIZE{{System::Main, "Core", "DiscCacheSize"}, 8192};
+const ConfigInfo<int> MAIN_DISC_READ_AHEAD_SIZE{{System::Main, "Core", "DiscReadAheadSize"}, 1024};
+const ConfigInfo<bool> MAIN_MAP_DISC_IMAGES{{System::Main, "Core", "MapDiscImages"}, false};
 
 // Main.Display
 
@@ -138,4 +141,11 @@ const ConfigInfo<std::string> MAIN_DUMP_PATH{{System::Main, "General", "DumpPath
 const ConfigInfo<std::string> MAIN_FS_PATH{{System::Main, "General", "NANDRootPath"}, ""};
 const ConfigInfo<std::string> MAIN_SD_PATH{{System::Main, "General", "WiiSDCardPath"}, ""};
 
+// Main.FifoPlayer
+
+const ConfigInfo<int> MAIN_FIFOPLAYER_BENCHMARK_LOOPS{
+    {System::Main, "FifoPlayer", "BenchmarkLoops"}, 0};
+const ConfigInfo<bool> MAIN_FIFOPLAYER_BENCHMARK_OBJECT_TIMINGS{
+    {System::Main, "FifoPlayer", "BenchmarkObjectTimings"}, false};
+
 }  // namespace Config
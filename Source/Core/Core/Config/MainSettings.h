@@ -77,6 +77,11 @@ extern const ConfigInfo<std::string> MAIN_PERF_MAP_DIR;
 extern const ConfigInfo<bool> MAIN_CUSTOM_RTC_ENABLE;
 extern const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE;
 extern const ConfigInfo<bool> MAIN_AUTO_DISC_CHANGE;
+// In KiB. Used by disc image formats that have to be decompressed.
+extern const ConfigInfo<int> MAIN_DISC_CACHE_SIZE;
+extern const ConfigInfo<int> MAIN_DISC_READ_AHEAD_SIZE;
+// Memory-maps uncompressed disc images. Crashes if the storage fails, so off by default.
+extern const ConfigInfo<bool> MAIN_MAP_DISC_IMAGES;
 
 // Main.DSP
 
@@ -107,4 +112,12 @@ extern const ConfigInfo<std::string> MAIN_DUMP_PATH;
 extern const ConfigInfo<std::string> MAIN_FS_PATH;
 extern const ConfigInfo<std::string> MAIN_SD_PATH;
 
+// Main.FifoPlayer
+
+// Number of times to replay the frame range as fast as possible before reporting timings and
+// stopping. Zero plays the FIFO log normally.
+extern const ConfigInfo<int> MAIN_FIFOPLAYER_BENCHMARK_LOOPS;
+// Waits for the GPU thread after each object to time it, which slows down the benchmark.
+extern const ConfigInfo<bool> MAIN_FIFOPLAYER_BENCHMARK_OBJECT_TIMINGS;
+
 }  // namespace Config
@@ -71,6 +71,10 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
       Config::GFX_DUMP_PATH.location,
       Config::GFX_BITRATE_KBPS.location,
       Config::GFX_INTERNAL_RESOLUTION_FRAME_DUMPS.location,
+      Config::GFX_FRAME_DUMP_QUEUE_SIZE.location,
+      Config::GFX_LOG_FRAME_CHECKSUMS.location,
+      Config::GFX_TIMELINE_CAPTURE_FIRST_FRAME.location,
+      Config::GFX_TIMELINE_CAPTURE_FRAMES.location,
       Config::GFX_ENABLE_GPU_TEXTURE_DECODING.location,
       Config::GFX_ENABLE_PIXEL_LIGHTING.location,
       Config::GFX_FAST_DEPTH_CALC.location,
@@ -85,11 +89,14 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
       Config::GFX_ENABLE_VALIDATION_LAYER.location,
       Config::GFX_BACKEND_MULTITHREADING.location,
       Config::GFX_COMMAND_BUFFER_EXECUTE_INTERVAL.location,
+      Config::GFX_PARALLEL_COMMAND_RECORDING.location,
       Config::GFX_SHADER_CACHE.location,
       Config::GFX_WAIT_FOR_SHADERS_BEFORE_STARTING.location,
       Config::GFX_SHADER_COMPILATION_MODE.location,
       Config::GFX_SHADER_COMPILER_THREADS.location,
       Config::GFX_SHADER_PRECOMPILER_THREADS.location,
+      Config::GFX_PREDICT_PIPELINES.location,
+      Config::GFX_CPU_CULL.location,
       Config::GFX_SAVE_TEXTURE_CACHE_TO_STATE.location,
 
       Config::GFX_SW_ZCOMPLOC.location,
@@ -123,8 +130,10 @@ bool IsSettingSaveable(const Config::ConfigLocation& config_location)
 
       Config::GFX_HACK_EFB_ACCESS_ENABLE.location,
       Config::GFX_HACK_EFB_DEFER_INVALIDATION.location,
+      Config::GFX_HACK_EFB_ACCESS_PREFETCH_TILES.location,
       Config::GFX_HACK_EFB_ACCESS_TILE_SIZE.location,
       Config::GFX_HACK_BBOX_ENABLE.location,
+      Config::GFX_HACK_BBOX_ASYNC_READBACK.location,
       Config::GFX_HACK_FORCE_PROGRESSIVE.location,
       Config::GFX_HACK_SKIP_EFB_COPY_TO_RAM.location,
       Config::GFX_HACK_SKIP_XFB_COPY_TO_RAM.location,
@@ -42,6 +42,8 @@ public:
     layer->Set(Config::SYSCONF_PAL60, m_settings.m_PAL60);
     layer->Set(Config::GFX_HACK_EFB_ACCESS_ENABLE, m_settings.m_EFBAccessEnable);
     layer->Set(Config::GFX_HACK_BBOX_ENABLE, m_settings.m_BBoxEnable);
+    // Asynchronous readback depends on timing, so it would desync.
+    layer->Set(Config::GFX_HACK_BBOX_ASYNC_READBACK, false);
     layer->Set(Config::GFX_HACK_FORCE_PROGRESSIVE, m_settings.m_ForceProgressive);
     layer->Set(Config::GFX_HACK_SKIP_EFB_COPY_TO_RAM, m_settings.m_EFBToTextureEnable);
     layer->Set(Config::GFX_HACK_SKIP_XFB_COPY_TO_RAM, m_settings.m_XFBToTextureEnable);
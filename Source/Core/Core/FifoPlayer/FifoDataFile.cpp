@@ -7,16 +7,25 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <xxhash.h>
+#include <zlib.h>
+
 #include "Common/File.h"
+#include "Common/Logging/Log.h"
 
+// Version 5 compresses all of the data and stores repeated memory updates once, which older
+// versions of Dolphin can't read.
 enum
 {
   FILE_ID = 0x0d01f1f0,
-  VERSION_NUMBER = 4,
-  MIN_LOADER_VERSION = 1,
+  VERSION_NUMBER = 5,
+  MIN_LOADER_VERSION = 5,
+  FIRST_COMPRESSED_VERSION = 5,
 };
 
 #pragma pack(push, 1)
@@ -66,6 +75,14 @@ struct FileMemoryUpdate
 };
 static_assert(sizeof(FileMemoryUpdate) == 24, "FileMemoryUpdate should be 24 bytes");
 
+// Precedes each block of data in compressed files, which is stored with zlib.
+struct FileDataHeader
+{
+  u32 compressedSize;
+  u32 uncompressedSize;
+};
+static_assert(sizeof(FileDataHeader) == 8, "FileDataHeader should be 8 bytes");
+
 #pragma pack(pop)
 
 FifoDataFile::FifoDataFile() = default;
@@ -92,9 +109,43 @@ bool FifoDataFile::GetIsWii() const
   return GetFlag(FLAG_IS_WII);
 }
 
-void FifoDataFile::AddFrame(const FifoFrameInfo& frameInfo)
+void FifoDataFile::AddFrame(FifoFrameInfo frameInfo)
+{
+  m_Frames.push_back(std::make_shared<FifoFrameInfo>(std::move(frameInfo)));
+}
+
+std::shared_ptr<const FifoFrameInfo> FifoDataFile::GetFrame(u32 frame) const
+{
+  if (!m_LoadedFile)
+    return m_Frames[frame];
+
+  std::lock_guard<std::mutex> lock(m_LoadedFileMutex);
+  const auto cached = std::find_if(m_FrameCache.begin(), m_FrameCache.end(),
+                                   [frame](const auto& entry) { return entry.first == frame; });
+  if (cached != m_FrameCache.end())
+  {
+    auto entry = std::move(*cached);
+    m_FrameCache.erase(cached);
+    m_FrameCache.push_back(std::move(entry));
+    return m_FrameCache.back().second;
+  }
+
+  std::shared_ptr<const FifoFrameInfo> frameInfo = ReadFrame(m_FrameLocations[frame]);
+  if (!frameInfo)
+  {
+    ERROR_LOG(VIDEO, "Failed to read frame %u of the FIFO log", frame);
+    frameInfo = std::make_shared<FifoFrameInfo>();
+  }
+
+  if (m_FrameCache.size() >= FRAME_CACHE_SIZE)
+    m_FrameCache.pop_front();
+  m_FrameCache.emplace_back(frame, frameInfo);
+  return frameInfo;
+}
+
+u32 FifoDataFile::GetFrameCount() const
 {
-  m_Frames.push_back(frameInfo);
+  return static_cast<u32>(m_LoadedFile ? m_FrameLocations.size() : m_Frames.size());
 }
 
 bool FifoDataFile::Save(const std::string& filename)
@@ -110,20 +161,11 @@ bool FifoDataFile::Save(const std::string& filename)
   u64 frameListOffset = file.Tell();
   PadFile(m_Frames.size() * sizeof(FileFrameInfo), file);
 
-  u64 bpMemOffset = file.Tell();
-  file.WriteArray(m_BPMem, BP_MEM_SIZE);
-
-  u64 cpMemOffset = file.Tell();
-  file.WriteArray(m_CPMem, CP_MEM_SIZE);
-
-  u64 xfMemOffset = file.Tell();
-  file.WriteArray(m_XFMem, XF_MEM_SIZE);
-
-  u64 xfRegsOffset = file.Tell();
-  file.WriteArray(m_XFRegs, XF_REGS_SIZE);
-
-  u64 texMemOffset = file.Tell();
-  file.WriteArray(m_TexMem, TEX_MEM_SIZE);
+  u64 bpMemOffset = WriteData(m_BPMem, sizeof(m_BPMem), file);
+  u64 cpMemOffset = WriteData(m_CPMem, sizeof(m_CPMem), file);
+  u64 xfMemOffset = WriteData(m_XFMem, sizeof(m_XFMem), file);
+  u64 xfRegsOffset = WriteData(m_XFRegs, sizeof(m_XFRegs), file);
+  u64 texMemOffset = WriteData(m_TexMem, sizeof(m_TexMem), file);
 
   // Write header
   FileHeader header;
@@ -154,17 +196,22 @@ bool FifoDataFile::Save(const std::string& filename)
   file.Seek(0, SEEK_SET);
   file.WriteBytes(&header, sizeof(FileHeader));
 
+  // Memory updates which have already been written, so that repeated ones can be stored once.
+  // The frames are held so that their contents can be compared.
+  std::vector<std::shared_ptr<const FifoFrameInfo>> frames(GetFrameCount());
+  StoredMemoryUpdates storedUpdates;
+
   // Write frames list
-  for (unsigned int i = 0; i < m_Frames.size(); ++i)
+  for (u32 i = 0; i < static_cast<u32>(frames.size()); ++i)
   {
-    const FifoFrameInfo& srcFrame = m_Frames[i];
+    frames[i] = GetFrame(i);
+    const FifoFrameInfo& srcFrame = *frames[i];
 
     // Write FIFO data
     file.Seek(0, SEEK_END);
-    u64 dataOffset = file.Tell();
-    file.WriteBytes(srcFrame.fifoData.data(), srcFrame.fifoData.size());
+    u64 dataOffset = WriteData(srcFrame.fifoData.data(), srcFrame.fifoData.size(), file);
 
-    u64 memoryUpdatesOffset = WriteMemoryUpdates(srcFrame.memoryUpdates, file);
+    u64 memoryUpdatesOffset = WriteMemoryUpdates(srcFrame.memoryUpdates, storedUpdates, file);
 
     FileFrameInfo dstFrame;
     dstFrame.fifoDataSize = static_cast<u32>(srcFrame.fifoData.size());
@@ -213,56 +260,73 @@ std::unique_ptr<FifoDataFile> FifoDataFile::Load(const std::string& filename, bo
     return dataFile;
   }
 
-  u32 size = std::min<u32>(BP_MEM_SIZE, header.bpMemSize);
-  file.Seek(header.bpMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_BPMem, size);
-
-  size = std::min<u32>(CP_MEM_SIZE, header.cpMemSize);
-  file.Seek(header.cpMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_CPMem, size);
+  const bool compressed = dataFile->m_Version >= FIRST_COMPRESSED_VERSION;
 
-  size = std::min<u32>(XF_MEM_SIZE, header.xfMemSize);
-  file.Seek(header.xfMemOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_XFMem, size);
-
-  size = std::min<u32>(XF_REGS_SIZE, header.xfRegsSize);
-  file.Seek(header.xfRegsOffset, SEEK_SET);
-  file.ReadArray(dataFile->m_XFRegs, size);
+  // The sizes in the header may differ from the current ones, so the whole block is read before
+  // the part that fits is copied.
+  const auto read_memory = [&file, compressed](u64 offset, size_t size, void* dst,
+                                               size_t dst_size) {
+    std::vector<u8> data(size);
+    if (!ReadData(offset, size, compressed, data.data(), file))
+      return false;
+    std::memcpy(dst, data.data(), std::min(size, dst_size));
+    return true;
+  };
 
   // Texture memory saving was added in version 4.
   std::memset(dataFile->m_TexMem, 0, TEX_MEM_SIZE);
-  if (dataFile->m_Version >= 4)
+  if (!read_memory(header.bpMemOffset, header.bpMemSize * sizeof(u32), dataFile->m_BPMem,
+                   sizeof(dataFile->m_BPMem)) ||
+      !read_memory(header.cpMemOffset, header.cpMemSize * sizeof(u32), dataFile->m_CPMem,
+                   sizeof(dataFile->m_CPMem)) ||
+      !read_memory(header.xfMemOffset, header.xfMemSize * sizeof(u32), dataFile->m_XFMem,
+                   sizeof(dataFile->m_XFMem)) ||
+      !read_memory(header.xfRegsOffset, header.xfRegsSize * sizeof(u32), dataFile->m_XFRegs,
+                   sizeof(dataFile->m_XFRegs)) ||
+      (dataFile->m_Version >= 4 && !read_memory(header.texMemOffset, header.texMemSize,
+                                                 dataFile->m_TexMem, sizeof(dataFile->m_TexMem))))
   {
-    size = std::min<u32>(TEX_MEM_SIZE, header.texMemSize);
-    file.Seek(header.texMemOffset, SEEK_SET);
-    file.ReadArray(dataFile->m_TexMem, size);
+    return nullptr;
   }
 
-  // Read frames
-  for (u32 i = 0; i < header.frameCount; ++i)
+  // Only the frame list is read now. The frames themselves are read when they are needed.
+  std::vector<FileFrameInfo> frameList(header.frameCount);
+  file.Seek(header.frameListOffset, SEEK_SET);
+  if (!file.ReadArray(frameList.data(), frameList.size()))
+    return nullptr;
+
+  dataFile->m_FrameLocations.reserve(frameList.size());
+  for (const FileFrameInfo& srcFrame : frameList)
   {
-    u64 frameOffset = header.frameListOffset + (i * sizeof(FileFrameInfo));
-    file.Seek(frameOffset, SEEK_SET);
-    FileFrameInfo srcFrame;
-    file.ReadBytes(&srcFrame, sizeof(FileFrameInfo));
+    dataFile->m_FrameLocations.push_back({srcFrame.fifoDataOffset, srcFrame.fifoDataSize,
+                                          srcFrame.fifoStart, srcFrame.fifoEnd,
+                                          srcFrame.memoryUpdatesOffset,
+                                          srcFrame.numMemoryUpdates});
+  }
 
-    FifoFrameInfo dstFrame;
-    dstFrame.fifoData.resize(srcFrame.fifoDataSize);
-    dstFrame.fifoStart = srcFrame.fifoStart;
-    dstFrame.fifoEnd = srcFrame.fifoEnd;
+  dataFile->m_LoadedFile = std::make_unique<File::IOFile>(std::move(file));
+
+  return dataFile;
+}
 
-    file.Seek(srcFrame.fifoDataOffset, SEEK_SET);
-    file.ReadBytes(dstFrame.fifoData.data(), srcFrame.fifoDataSize);
+std::shared_ptr<const FifoFrameInfo> FifoDataFile::ReadFrame(const FrameLocation& location) const
+{
+  const bool compressed = m_Version >= FIRST_COMPRESSED_VERSION;
 
-    ReadMemoryUpdates(srcFrame.memoryUpdatesOffset, srcFrame.numMemoryUpdates,
-                      dstFrame.memoryUpdates, file);
+  auto frame = std::make_shared<FifoFrameInfo>();
+  frame->fifoData.resize(location.fifoDataSize);
+  frame->fifoStart = location.fifoStart;
+  frame->fifoEnd = location.fifoEnd;
 
-    dataFile->AddFrame(dstFrame);
+  if (!ReadData(location.fifoDataOffset, location.fifoDataSize, compressed,
+                frame->fifoData.data(), *m_LoadedFile) ||
+      !ReadMemoryUpdates(location.memoryUpdatesOffset, location.numMemoryUpdates, compressed,
+                         frame->memoryUpdates, *m_LoadedFile))
+  {
+    return nullptr;
   }
 
-  file.Close();
-
-  return dataFile;
+  return frame;
 }
 
 void FifoDataFile::PadFile(size_t numBytes, File::IOFile& file)
@@ -285,6 +349,7 @@ bool FifoDataFile::GetFlag(u32 flag) const
 }
 
 u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates,
+                                     StoredMemoryUpdates& storedUpdates,
                                      File::IOFile& file)
 {
   // Add space for memory update list
@@ -295,10 +360,23 @@ u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates
   {
     const MemoryUpdate& srcUpdate = memUpdates[i];
 
-    // Write memory
-    file.Seek(0, SEEK_END);
-    u64 dataOffset = file.Tell();
-    file.WriteBytes(srcUpdate.data.data(), srcUpdate.data.size());
+    // Write memory, unless the same data has been written before
+    const u64 hash = XXH64(srcUpdate.data.data(), srcUpdate.data.size(), 0);
+    const auto range = storedUpdates.equal_range(hash);
+    const auto stored = std::find_if(range.first, range.second, [&srcUpdate](const auto& entry) {
+      return *entry.second.data == srcUpdate.data;
+    });
+    u64 dataOffset;
+    if (stored != range.second)
+    {
+      dataOffset = stored->second.dataOffset;
+    }
+    else
+    {
+      file.Seek(0, SEEK_END);
+      dataOffset = WriteData(srcUpdate.data.data(), srcUpdate.data.size(), file);
+      storedUpdates.emplace(hash, StoredMemoryUpdate{&srcUpdate.data, dataOffset});
+    }
 
     FileMemoryUpdate dstUpdate;
     dstUpdate.address = srcUpdate.address;
@@ -315,17 +393,19 @@ u64 FifoDataFile::WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates
   return updateListOffset;
 }
 
-void FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates,
+bool FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, bool compressed,
                                      std::vector<MemoryUpdate>& memUpdates, File::IOFile& file)
 {
+  std::vector<FileMemoryUpdate> updateList(numUpdates);
+  file.Seek(fileOffset, SEEK_SET);
+  if (!file.ReadArray(updateList.data(), updateList.size()))
+    return false;
+
   memUpdates.resize(numUpdates);
 
   for (u32 i = 0; i < numUpdates; ++i)
   {
-    u64 updateOffset = fileOffset + (i * sizeof(FileMemoryUpdate));
-    file.Seek(updateOffset, SEEK_SET);
-    FileMemoryUpdate srcUpdate;
-    file.ReadBytes(&srcUpdate, sizeof(FileMemoryUpdate));
+    const FileMemoryUpdate& srcUpdate = updateList[i];
 
     MemoryUpdate& dstUpdate = memUpdates[i];
     dstUpdate.address = srcUpdate.address;
@@ -333,7 +413,53 @@ void FifoDataFile::ReadMemoryUpdates(u64 fileOffset, u32 numUpdates,
     dstUpdate.data.resize(srcUpdate.dataSize);
     dstUpdate.type = static_cast<MemoryUpdate::Type>(srcUpdate.type);
 
-    file.Seek(srcUpdate.dataOffset, SEEK_SET);
-    file.ReadBytes(dstUpdate.data.data(), srcUpdate.dataSize);
+    if (!ReadData(srcUpdate.dataOffset, srcUpdate.dataSize, compressed, dstUpdate.data.data(),
+                  file))
+    {
+      return false;
+    }
   }
+
+  return true;
+}
+
+u64 FifoDataFile::WriteData(const void* data, size_t size, File::IOFile& file)
+{
+  const u64 offset = file.Tell();
+
+  uLongf compressedSize = compressBound(static_cast<uLong>(size));
+  std::vector<u8> compressed(sizeof(FileDataHeader) + compressedSize);
+  compress2(compressed.data() + sizeof(FileDataHeader), &compressedSize,
+            static_cast<const Bytef*>(data), static_cast<uLong>(size), Z_DEFAULT_COMPRESSION);
+
+  FileDataHeader header;
+  header.compressedSize = static_cast<u32>(compressedSize);
+  header.uncompressedSize = static_cast<u32>(size);
+  std::memcpy(compressed.data(), &header, sizeof(FileDataHeader));
+
+  file.WriteBytes(compressed.data(), sizeof(FileDataHeader) + compressedSize);
+  return offset;
+}
+
+bool FifoDataFile::ReadData(u64 offset, size_t size, bool compressed, void* data,
+                            File::IOFile& file)
+{
+  file.Seek(offset, SEEK_SET);
+  if (!compressed)
+    return file.ReadBytes(data, size);
+
+  FileDataHeader header;
+  if (!file.ReadBytes(&header, sizeof(FileDataHeader)) || header.uncompressedSize != size)
+    return false;
+  if (size == 0)
+    return true;
+
+  std::vector<u8> compressedData(header.compressedSize);
+  if (!file.ReadBytes(compressedData.data(), compressedData.size()))
+    return false;
+
+  uLongf uncompressedSize = static_cast<uLongf>(size);
+  return uncompress(static_cast<Bytef*>(data), &uncompressedSize, compressedData.data(),
+                    static_cast<uLong>(compressedData.size())) == Z_OK &&
+         uncompressedSize == size;
 }
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -69,9 +73,12 @@ public:
   u32* GetXFMem() { return m_XFMem; }
   u32* GetXFRegs() { return m_XFRegs; }
   u8* GetTexMem() { return m_TexMem; }
-  void AddFrame(const FifoFrameInfo& frameInfo);
-  const FifoFrameInfo& GetFrame(u32 frame) const { return m_Frames[frame]; }
-  u32 GetFrameCount() const { return static_cast<u32>(m_Frames.size()); }
+  void AddFrame(FifoFrameInfo frameInfo);
+  // Frames of a loaded file are read from it when they are needed, and only the most recently
+  // used ones are kept in memory, so the returned frame must be held for as long as it is used.
+  // Can be called from any thread.
+  std::shared_ptr<const FifoFrameInfo> GetFrame(u32 frame) const;
+  u32 GetFrameCount() const;
   bool Save(const std::string& filename);
 
   static std::unique_ptr<FifoDataFile> Load(const std::string& filename, bool flagsOnly);
@@ -82,15 +89,42 @@ private:
     FLAG_IS_WII = 1
   };
 
+  // Number of frames of a loaded file which are kept in memory.
+  static constexpr size_t FRAME_CACHE_SIZE = 8;
+
+  // Where the data of a frame is stored in the file it was loaded from.
+  struct FrameLocation
+  {
+    u64 fifoDataOffset;
+    u32 fifoDataSize;
+    u32 fifoStart;
+    u32 fifoEnd;
+    u64 memoryUpdatesOffset;
+    u32 numMemoryUpdates;
+  };
+
+  // Memory update data which has already been written while saving, keyed by its hash.
+  struct StoredMemoryUpdate
+  {
+    const std::vector<u8>* data;
+    u64 dataOffset;
+  };
+  using StoredMemoryUpdates = std::unordered_multimap<u64, StoredMemoryUpdate>;
+
   void PadFile(size_t numBytes, File::IOFile& file);
 
   void SetFlag(u32 flag, bool set);
   bool GetFlag(u32 flag) const;
 
-  u64 WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates, File::IOFile& file);
-  static void ReadMemoryUpdates(u64 fileOffset, u32 numUpdates,
+  u64 WriteMemoryUpdates(const std::vector<MemoryUpdate>& memUpdates,
+                         StoredMemoryUpdates& storedUpdates, File::IOFile& file);
+  static bool ReadMemoryUpdates(u64 fileOffset, u32 numUpdates, bool compressed,
                                 std::vector<MemoryUpdate>& memUpdates, File::IOFile& file);
 
+  static u64 WriteData(const void* data, size_t size, File::IOFile& file);
+  static bool ReadData(u64 offset, size_t size, bool compressed, void* data, File::IOFile& file);
+  std::shared_ptr<const FifoFrameInfo> ReadFrame(const FrameLocation& location) const;
+
   u32 m_BPMem[BP_MEM_SIZE];
   u32 m_CPMem[CP_MEM_SIZE];
   u32 m_XFMem[XF_MEM_SIZE];
@@ -100,5 +134,13 @@ private:
   u32 m_Flags = 0;
   u32 m_Version = 0;
 
-  std::vector<FifoFrameInfo> m_Frames;
+  // Frames which have been added to a file that is being recorded.
+  std::vector<std::shared_ptr<const FifoFrameInfo>> m_Frames;
+
+  // A loaded file is kept open, so that its frames can be read when they are needed.
+  std::unique_ptr<File::IOFile> m_LoadedFile;
+  std::vector<FrameLocation> m_FrameLocations;
+  mutable std::mutex m_LoadedFileMutex;
+  // Most recently used last.
+  mutable std::deque<std::pair<u32, std::shared_ptr<const FifoFrameInfo>>> m_FrameCache;
 };
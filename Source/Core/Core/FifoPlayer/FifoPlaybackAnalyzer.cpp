@@ -40,7 +40,7 @@ void FifoPlaybackAnalyzer::AnalyzeFrames(FifoDataFile* file,
 
   for (u32 frameIdx = 0; frameIdx < file->GetFrameCount(); ++frameIdx)
   {
-    const FifoFrameInfo& frame = file->GetFrame(frameIdx);
+    const auto frame = file->GetFrame(frameIdx);
     AnalyzedFrameInfo& analyzed = frameInfo[frameIdx];
 
     s_DrawingObject = false;
@@ -53,24 +53,24 @@ void FifoPlaybackAnalyzer::AnalyzeFrames(FifoDataFile* file,
     std::vector<CmdData> prevCmds;
 #endif
 
-    while (cmdStart < frame.fifoData.size())
+    while (cmdStart < frame->fifoData.size())
     {
       // Add memory updates that have occurred before this point in the frame
-      while (nextMemUpdate < frame.memoryUpdates.size() &&
-             frame.memoryUpdates[nextMemUpdate].fifoPosition <= cmdStart)
+      while (nextMemUpdate < frame->memoryUpdates.size() &&
+             frame->memoryUpdates[nextMemUpdate].fifoPosition <= cmdStart)
       {
-        analyzed.memoryUpdates.push_back(frame.memoryUpdates[nextMemUpdate]);
+        analyzed.memoryUpdates.push_back(frame->memoryUpdates[nextMemUpdate]);
         ++nextMemUpdate;
       }
 
       const bool wasDrawing = s_DrawingObject;
       const u32 cmdSize =
-          FifoAnalyzer::AnalyzeCommand(&frame.fifoData[cmdStart], DecodeMode::Playback);
+          FifoAnalyzer::AnalyzeCommand(&frame->fifoData[cmdStart], DecodeMode::Playback);
 
 #if LOG_FIFO_CMDS
       CmdData cmdData;
       cmdData.offset = cmdStart;
-      cmdData.ptr = &frame.fifoData[cmdStart];
+      cmdData.ptr = &frame->fifoData[cmdStart];
       cmdData.size = cmdSize;
       prevCmds.push_back(cmdData);
 #endif
@@ -5,11 +5,20 @@
 #include "Core/FifoPlayer/FifoPlayer.h"
 
 #include <algorithm>
+#include <cinttypes>
+#include <memory>
 #include <mutex>
+#include <string>
 
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -46,6 +55,7 @@ bool FifoPlayer::Open(const std::string& filename)
   Close();
 
   m_File = FifoDataFile::Load(filename, false);
+  SplitPath(filename, nullptr, &m_FileName, nullptr);
 
   if (m_File)
   {
@@ -87,9 +97,14 @@ public:
 
     m_parent->m_CurrentFrame = m_parent->m_FrameRangeStart;
     m_parent->LoadMemory();
+    m_parent->StartBenchmark();
   }
 
-  void Shutdown() override { IsPlayingBackFifologWithBrokenEFBCopies = false; }
+  void Shutdown() override
+  {
+    IsPlayingBackFifologWithBrokenEFBCopies = false;
+    m_parent->m_BenchmarkLoops = 0;
+  }
   void ClearCache() override
   {
     // Nothing to clear.
@@ -133,8 +148,16 @@ CPU::State FifoPlayer::AdvanceFrame()
 {
   if (m_CurrentFrame >= m_FrameRangeEnd)
   {
-    if (!m_Loop)
+    if (IsBenchmarking())
+    {
+      if (!EndBenchmarkLoop())
+        return CPU::State::PowerDown;
+    }
+    else if (!m_Loop)
+    {
       return CPU::State::PowerDown;
+    }
+
     // If there are zero frames in the range then sleep instead of busy spinning
     if (m_FrameRangeStart >= m_FrameRangeEnd)
       return CPU::State::Stepping;
@@ -154,12 +177,122 @@ CPU::State FifoPlayer::AdvanceFrame()
   if (m_EarlyMemoryUpdates && m_CurrentFrame == m_FrameRangeStart)
     WriteAllMemoryUpdates();
 
-  WriteFrame(m_File->GetFrame(m_CurrentFrame), m_FrameInfo[m_CurrentFrame]);
+  // Fetch the frame before timing it, so that reading it from disk isn't measured.
+  const std::shared_ptr<const FifoFrameInfo> frame = m_File->GetFrame(m_CurrentFrame);
+  if (IsBenchmarking())
+  {
+    const u64 start_time = Common::Timer::GetTimeUs();
+    WriteFrame(*frame, m_FrameInfo[m_CurrentFrame]);
+    m_BenchmarkFrameTimings[m_CurrentFrame].Add(Common::Timer::GetTimeUs() - start_time);
+  }
+  else
+  {
+    WriteFrame(*frame, m_FrameInfo[m_CurrentFrame]);
+  }
 
   ++m_CurrentFrame;
   return CPU::State::Running;
 }
 
+void FifoPlayer::BenchmarkTiming::Add(u64 time_us)
+{
+  total_us += time_us;
+  min_us = std::min(min_us, time_us);
+  max_us = std::max(max_us, time_us);
+  count++;
+}
+
+void FifoPlayer::StartBenchmark()
+{
+  m_BenchmarkLoops =
+      static_cast<u32>(std::max(Config::Get(Config::MAIN_FIFOPLAYER_BENCHMARK_LOOPS), 0));
+  m_BenchmarkTimeObjects = Config::Get(Config::MAIN_FIFOPLAYER_BENCHMARK_OBJECT_TIMINGS);
+  m_BenchmarkLoopsCompleted = 0;
+  m_BenchmarkLoopTimings = {};
+  ResetBenchmarkTimings();
+  m_BenchmarkLoopStartTime = Common::Timer::GetTimeUs();
+}
+
+void FifoPlayer::ResetBenchmarkTimings()
+{
+  m_BenchmarkFrameTimings.assign(m_File->GetFrameCount(), {});
+  m_BenchmarkObjectTimings.assign(m_File->GetFrameCount(), {});
+  for (u32 frame = 0; frame < m_File->GetFrameCount(); ++frame)
+    m_BenchmarkObjectTimings[frame].resize(m_FrameInfo[frame].objectStarts.size());
+}
+
+bool FifoPlayer::EndBenchmarkLoop()
+{
+  const u64 loop_time = Common::Timer::GetTimeUs() - m_BenchmarkLoopStartTime;
+  ++m_BenchmarkLoopsCompleted;
+
+  // The first loop compiles shaders and fills caches, so only count it if it's the only one.
+  if (m_BenchmarkLoopsCompleted == 1 && m_BenchmarkLoops > 1)
+    ResetBenchmarkTimings();
+  else
+    m_BenchmarkLoopTimings.Add(loop_time);
+
+  if (m_BenchmarkLoopsCompleted >= m_BenchmarkLoops || m_FrameRangeStart >= m_FrameRangeEnd)
+  {
+    WriteBenchmarkReport();
+    return false;
+  }
+
+  m_BenchmarkLoopStartTime = Common::Timer::GetTimeUs();
+  return true;
+}
+
+void FifoPlayer::WriteBenchmarkReport() const
+{
+  const auto format_timing = [](const BenchmarkTiming& timing) {
+    if (timing.count == 0)
+      return std::string("-");
+    return StringFromFormat("%" PRIu64 " %" PRIu64 " %" PRIu64, timing.total_us / timing.count,
+                            timing.min_us, timing.max_us);
+  };
+
+  const u32 num_frames = m_FrameRangeEnd - m_FrameRangeStart;
+  const double loop_average_us =
+      m_BenchmarkLoopTimings.count ?
+          static_cast<double>(m_BenchmarkLoopTimings.total_us) / m_BenchmarkLoopTimings.count :
+          0.0;
+  const double fps = loop_average_us > 0.0 ? num_frames * 1000000.0 / loop_average_us : 0.0;
+
+  std::string report = StringFromFormat(
+      "# %s, frames %u-%u, %u timed loops%s\n", m_FileName.c_str(), m_FrameRangeStart,
+      m_FrameRangeEnd, m_BenchmarkLoopTimings.count,
+      m_BenchmarkLoops > 1 ? " after a warm-up loop" : "");
+  report += "# Times are in microseconds: average, minimum and maximum over all loops.\n";
+  report += StringFromFormat("loop %s\n", format_timing(m_BenchmarkLoopTimings).c_str());
+  report += StringFromFormat("fps %.2f\n", fps);
+  for (u32 frame = m_FrameRangeStart; frame < m_FrameRangeEnd; ++frame)
+  {
+    report += StringFromFormat("frame %u %s\n", frame,
+                               format_timing(m_BenchmarkFrameTimings[frame]).c_str());
+    if (!m_BenchmarkTimeObjects)
+      continue;
+
+    const std::vector<BenchmarkTiming>& objects = m_BenchmarkObjectTimings[frame];
+    for (u32 object = 0; object < static_cast<u32>(objects.size()); ++object)
+    {
+      if (objects[object].count != 0)
+      {
+        report += StringFromFormat("object %u %u %s\n", frame, object,
+                                   format_timing(objects[object]).c_str());
+      }
+    }
+  }
+
+  const std::string path = File::GetUserPath(D_DUMP_IDX) + "fifobenchmark_" + m_FileName + ".txt";
+  File::CreateFullPath(path);
+  File::IOFile file(path, "wb");
+  if (!file.WriteBytes(report.data(), report.size()))
+    ERROR_LOG(VIDEO, "Failed to write FIFO benchmark report to %s", path.c_str());
+
+  NOTICE_LOG(VIDEO, "FIFO benchmark of %s: %.2f fps, average loop %.0f us, report written to %s",
+             m_FileName.c_str(), fps, loop_average_us, path.c_str());
+}
+
 std::unique_ptr<CPUCoreBase> FifoPlayer::GetCPUCore()
 {
   if (!m_File || m_File->GetFrameCount() == 0)
@@ -265,10 +398,27 @@ void FifoPlayer::WriteFrame(const FifoFrameInfo& frame, const AnalyzedFrameInfo&
     // Write objects in draw range
     if (objectNum < numObjects && drawStart <= drawEnd)
     {
-      objectNum = drawEnd;
-      WriteFramePart(position, info.objectEnds[objectNum], memoryUpdate, frame, info);
-      position = info.objectEnds[objectNum];
-      ++objectNum;
+      if (IsBenchmarking() && m_BenchmarkTimeObjects)
+      {
+        // Wait for the GPU after each object, so that they can be timed individually.
+        std::vector<BenchmarkTiming>& timings = m_BenchmarkObjectTimings[m_CurrentFrame];
+        for (; objectNum <= drawEnd; ++objectNum)
+        {
+          const u64 start_time = Common::Timer::GetTimeUs();
+          WriteFramePart(position, info.objectEnds[objectNum], memoryUpdate, frame, info);
+          FlushWGP();
+          WaitForGPUIdle();
+          timings[objectNum].Add(Common::Timer::GetTimeUs() - start_time);
+          position = info.objectEnds[objectNum];
+        }
+      }
+      else
+      {
+        objectNum = drawEnd;
+        WriteFramePart(position, info.objectEnds[objectNum], memoryUpdate, frame, info);
+        position = info.objectEnds[objectNum];
+        ++objectNum;
+      }
     }
 
     // Write fifo data skipping objects after the draw range
@@ -285,7 +435,11 @@ void FifoPlayer::WriteFrame(const FifoFrameInfo& frame, const AnalyzedFrameInfo&
   WriteFramePart(position, static_cast<u32>(frame.fifoData.size()), memoryUpdate, frame, info);
 
   FlushWGP();
+  WaitForGPUIdle();
+}
 
+void FifoPlayer::WaitForGPUIdle()
+{
   // Sleep while the GPU is active
   while (!IsIdleSet() && CPU::GetState() != CPU::State::PowerDown)
   {
@@ -332,8 +486,8 @@ void FifoPlayer::WriteAllMemoryUpdates()
 
   for (u32 frameNum = 0; frameNum < m_File->GetFrameCount(); ++frameNum)
   {
-    const FifoFrameInfo& frame = m_File->GetFrame(frameNum);
-    for (auto& update : frame.memoryUpdates)
+    const auto frame = m_File->GetFrame(frameNum);
+    for (auto& update : frame->memoryUpdates)
     {
       WriteMemory(update);
     }
@@ -388,16 +542,16 @@ void FifoPlayer::SetupFifo()
   WriteCP(CommandProcessor::CTRL_REGISTER, 0);   // disable read, BP, interrupts
   WriteCP(CommandProcessor::CLEAR_REGISTER, 7);  // clear overflow, underflow, metrics
 
-  const FifoFrameInfo& frame = m_File->GetFrame(m_CurrentFrame);
+  const auto frame = m_File->GetFrame(m_CurrentFrame);
 
   // Set fifo bounds
-  WriteCP(CommandProcessor::FIFO_BASE_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_BASE_HI, frame.fifoStart >> 16);
-  WriteCP(CommandProcessor::FIFO_END_LO, frame.fifoEnd);
-  WriteCP(CommandProcessor::FIFO_END_HI, frame.fifoEnd >> 16);
+  WriteCP(CommandProcessor::FIFO_BASE_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_BASE_HI, frame->fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_END_LO, frame->fifoEnd);
+  WriteCP(CommandProcessor::FIFO_END_HI, frame->fifoEnd >> 16);
 
   // Set watermarks, high at 75%, low at 0%
-  u32 hi_watermark = (frame.fifoEnd - frame.fifoStart) * 3 / 4;
+  u32 hi_watermark = (frame->fifoEnd - frame->fifoStart) * 3 / 4;
   WriteCP(CommandProcessor::FIFO_HI_WATERMARK_LO, hi_watermark);
   WriteCP(CommandProcessor::FIFO_HI_WATERMARK_HI, hi_watermark >> 16);
   WriteCP(CommandProcessor::FIFO_LO_WATERMARK_LO, 0);
@@ -406,19 +560,19 @@ void FifoPlayer::SetupFifo()
   // Set R/W pointers to fifo start
   WriteCP(CommandProcessor::FIFO_RW_DISTANCE_LO, 0);
   WriteCP(CommandProcessor::FIFO_RW_DISTANCE_HI, 0);
-  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_HI, frame.fifoStart >> 16);
-  WriteCP(CommandProcessor::FIFO_READ_POINTER_LO, frame.fifoStart);
-  WriteCP(CommandProcessor::FIFO_READ_POINTER_HI, frame.fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_WRITE_POINTER_HI, frame->fifoStart >> 16);
+  WriteCP(CommandProcessor::FIFO_READ_POINTER_LO, frame->fifoStart);
+  WriteCP(CommandProcessor::FIFO_READ_POINTER_HI, frame->fifoStart >> 16);
 
   // Set fifo bounds
-  WritePI(ProcessorInterface::PI_FIFO_BASE, frame.fifoStart);
-  WritePI(ProcessorInterface::PI_FIFO_END, frame.fifoEnd);
+  WritePI(ProcessorInterface::PI_FIFO_BASE, frame->fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_END, frame->fifoEnd);
 
   // Set write pointer
-  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame.fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame->fifoStart);
   FlushWGP();
-  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame.fifoStart);
+  WritePI(ProcessorInterface::PI_FIFO_WPTR, frame->fifoStart);
 
   WriteCP(CommandProcessor::CTRL_REGISTER, 17);  // enable read & GP link
 }
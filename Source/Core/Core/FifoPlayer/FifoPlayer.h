@@ -99,13 +99,33 @@ public:
 
   bool IsRunningWithFakeVideoInterfaceUpdates() const;
 
+  // True while replaying the frame range as fast as possible to time it, which is enabled with
+  // Config::MAIN_FIFOPLAYER_BENCHMARK_LOOPS.
+  bool IsBenchmarking() const { return m_BenchmarkLoops != 0; }
+
 private:
   class CPUCore;
 
+  struct BenchmarkTiming
+  {
+    void Add(u64 time_us);
+
+    u64 total_us = 0;
+    u64 min_us = UINT64_MAX;
+    u64 max_us = 0;
+    u32 count = 0;
+  };
+
   FifoPlayer();
 
   CPU::State AdvanceFrame();
 
+  void StartBenchmark();
+  void ResetBenchmarkTimings();
+  // Returns false once all of the loops have been completed.
+  bool EndBenchmarkLoop();
+  void WriteBenchmarkReport() const;
+
   void WriteFrame(const FifoFrameInfo& frame, const AnalyzedFrameInfo& info);
   void WriteFramePart(u32 dataStart, u32 dataEnd, u32& nextMemUpdate, const FifoFrameInfo& frame,
                       const AnalyzedFrameInfo& info);
@@ -127,6 +147,7 @@ private:
   void WritePI(u32 address, u32 value);
 
   void FlushWGP();
+  void WaitForGPUIdle();
 
   void LoadBPReg(u8 reg, u32 value);
   void LoadCPReg(u8 reg, u32 value);
@@ -157,6 +178,16 @@ private:
   CallbackFunc m_FrameWrittenCb = nullptr;
 
   std::unique_ptr<FifoDataFile> m_File;
+  std::string m_FileName;
 
   std::vector<AnalyzedFrameInfo> m_FrameInfo;
+
+  u32 m_BenchmarkLoops = 0;
+  u32 m_BenchmarkLoopsCompleted = 0;
+  bool m_BenchmarkTimeObjects = false;
+  u64 m_BenchmarkLoopStartTime = 0;
+  BenchmarkTiming m_BenchmarkLoopTimings;
+  // Indexed by frame number, and then by object number.
+  std::vector<BenchmarkTiming> m_BenchmarkFrameTimings;
+  std::vector<std::vector<BenchmarkTiming>> m_BenchmarkObjectTimings;
 };
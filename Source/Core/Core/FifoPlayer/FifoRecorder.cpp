@@ -6,6 +6,9 @@
 
 #include <algorithm>
 #include <cstring>
+#include <utility>
+
+#include <xxhash.h>
 
 #include "Common/MsgHandler.h"
 #include "Common/Thread.h"
@@ -18,8 +21,16 @@ static FifoRecorder instance;
 
 FifoRecorder::FifoRecorder() = default;
 
+FifoRecorder::~FifoRecorder()
+{
+  StopRecordingThread();
+}
+
 void FifoRecorder::StartRecording(s32 numFrames, CallbackFunc finishedCb)
 {
+  // Frames from a previous recording which haven't been processed yet are dropped.
+  StopRecordingThread();
+
   std::lock_guard<std::recursive_mutex> lk(m_mutex);
 
   m_File = std::make_unique<FifoDataFile>();
@@ -41,6 +52,12 @@ void FifoRecorder::StartRecording(s32 numFrames, CallbackFunc finishedCb)
 
   std::fill(m_Ram.begin(), m_Ram.end(), 0);
   std::fill(m_ExRam.begin(), m_ExRam.end(), 0);
+  m_MemoryUpdates.clear();
+
+  m_UsedMemoryRanges.clear();
+  m_RamPageSequences.assign(Memory::RAM_SIZE >> PAGE_SHIFT, 0);
+  m_ExRamPageSequences.assign(Memory::EXRAM_SIZE >> PAGE_SHIFT, 0);
+  m_TaskSequence = 0;
 
   m_File->SetIsWii(SConfig::GetInstance().bWii);
 
@@ -53,6 +70,8 @@ void FifoRecorder::StartRecording(s32 numFrames, CallbackFunc finishedCb)
 
   m_RequestedRecordingEnd = false;
   m_FinishedCb = finishedCb;
+
+  StartRecordingThread();
 }
 
 void FifoRecorder::StopRecording()
@@ -94,21 +113,22 @@ void FifoRecorder::WriteGPCommand(const u8* data, u32 size)
 
   if (m_FrameEnded && !m_FifoData.empty())
   {
-    m_CurrentFrame.fifoData = m_FifoData;
+    // The recording thread adds the frame to the file once it has processed the memory updates
+    RecorderTask task;
+    task.type = RecorderTask::Type::EndFrame;
+    task.frame.fifoStart = m_CurrentFrame.fifoStart;
+    task.frame.fifoEnd = m_CurrentFrame.fifoEnd;
+    task.frame.fifoData = std::move(m_FifoData);
 
     {
       std::lock_guard<std::recursive_mutex> lk(m_mutex);
-
-      // Copy frame to file
-      // The file will be responsible for freeing the memory allocated for each frame's fifoData
-      m_File->AddFrame(m_CurrentFrame);
-
-      if (m_FinishedCb && m_RequestedRecordingEnd)
-        m_FinishedCb();
+      task.callFinishedCb = m_FinishedCb && m_RequestedRecordingEnd;
     }
 
-    m_CurrentFrame.memoryUpdates.clear();
     m_FifoData.clear();
+    m_FifoData.reserve(task.frame.fifoData.size());
+    m_Tasks.Push(std::move(task));
+    m_TasksAvailable.Set();
     m_FrameEnded = false;
   }
 
@@ -117,39 +137,58 @@ void FifoRecorder::WriteGPCommand(const u8* data, u32 size)
 
 void FifoRecorder::UseMemory(u32 address, u32 size, MemoryUpdate::Type type, bool dynamicUpdate)
 {
-  u8* curData;
-  u8* newData;
+  if (size == 0)
+    return;
+
+  const u8* newData;
+  std::vector<u32>* pageSequences;
+  u32 offset;
   if (address & 0x10000000)
   {
-    curData = &m_ExRam[address & Memory::EXRAM_MASK];
-    newData = &Memory::m_pEXRAM[address & Memory::EXRAM_MASK];
+    offset = address & Memory::EXRAM_MASK;
+    newData = &Memory::m_pEXRAM[offset];
+    pageSequences = &m_ExRamPageSequences;
   }
   else
   {
-    curData = &m_Ram[address & Memory::RAM_MASK];
-    newData = &Memory::m_pRAM[address & Memory::RAM_MASK];
+    offset = address & Memory::RAM_MASK;
+    newData = &Memory::m_pRAM[offset];
+    pageSequences = &m_RamPageSequences;
   }
 
-  if (!dynamicUpdate && memcmp(curData, newData, size) != 0)
-  {
-    // Update current memory
-    memcpy(curData, newData, size);
+  const auto firstPage = pageSequences->begin() + (offset >> PAGE_SHIFT);
+  const auto lastPage = pageSequences->begin() + ((offset + size - 1) >> PAGE_SHIFT);
 
-    // Record memory update
-    MemoryUpdate memUpdate;
-    memUpdate.address = address;
-    memUpdate.fifoPosition = (u32)(m_FifoData.size());
-    memUpdate.type = type;
-    memUpdate.data.resize(size);
-    std::copy(newData, newData + size, memUpdate.data.begin());
-
-    m_CurrentFrame.memoryUpdates.push_back(std::move(memUpdate));
-  }
-  else if (dynamicUpdate)
+  const u64 key = (static_cast<u64>(address) << 32) | size;
+  u64 hash = 0;
+  if (!dynamicUpdate)
   {
-    // Shadow the data so it won't be recorded as changed by a future UseMemory
-    memcpy(curData, newData, size);
+    // If the memory hashes the same as the last time this range was used, and no other task
+    // has touched it since, the recording thread already has the same data.
+    hash = XXH64(newData, size, 0);
+    const auto range = m_UsedMemoryRanges.find(key);
+    if (range != m_UsedMemoryRanges.end() && range->second.hash == hash &&
+        std::all_of(firstPage, lastPage + 1,
+                    [&range](u32 sequence) { return sequence <= range->second.sequence; }))
+    {
+      return;
+    }
   }
+
+  ++m_TaskSequence;
+  std::fill(firstPage, lastPage + 1, m_TaskSequence);
+  if (!dynamicUpdate)
+    m_UsedMemoryRanges[key] = {hash, m_TaskSequence};
+
+  // The memory is copied now, as it may have changed by the time the recording thread compares it
+  RecorderTask task;
+  task.type = dynamicUpdate ? RecorderTask::Type::DynamicUpdate : RecorderTask::Type::UseMemory;
+  task.memoryUpdate.address = address;
+  task.memoryUpdate.fifoPosition = static_cast<u32>(m_FifoData.size());
+  task.memoryUpdate.type = type;
+  task.memoryUpdate.data.assign(newData, newData + size);
+  m_Tasks.Push(std::move(task));
+  m_TasksAvailable.Set();
 }
 
 void FifoRecorder::EndFrame(u32 fifoStart, u32 fifoEnd)
@@ -220,6 +259,84 @@ bool FifoRecorder::IsRecording() const
   return m_IsRecording;
 }
 
+void FifoRecorder::StartRecordingThread()
+{
+  m_Tasks.Clear();
+  m_StopRecordingThread = false;
+  m_RecordingThread = std::thread(&FifoRecorder::RecordingThreadFunc, this);
+}
+
+void FifoRecorder::StopRecordingThread()
+{
+  if (!m_RecordingThread.joinable())
+    return;
+
+  m_StopRecordingThread = true;
+  m_TasksAvailable.Set();
+  m_RecordingThread.join();
+}
+
+void FifoRecorder::RecordingThreadFunc()
+{
+  Common::SetCurrentThreadName("FIFO Recorder");
+
+  while (!m_StopRecordingThread)
+  {
+    RecorderTask task;
+    if (!m_Tasks.Pop(task))
+    {
+      m_TasksAvailable.Wait();
+      continue;
+    }
+
+    if (task.type == RecorderTask::Type::EndFrame)
+      ProcessEndFrame(task);
+    else
+      ProcessMemoryUpdate(task);
+  }
+}
+
+void FifoRecorder::ProcessMemoryUpdate(RecorderTask& task)
+{
+  MemoryUpdate& memUpdate = task.memoryUpdate;
+  u8* curData;
+  if (memUpdate.address & 0x10000000)
+    curData = &m_ExRam[memUpdate.address & Memory::EXRAM_MASK];
+  else
+    curData = &m_Ram[memUpdate.address & Memory::RAM_MASK];
+
+  const u8* newData = memUpdate.data.data();
+  const size_t size = memUpdate.data.size();
+
+  if (task.type == RecorderTask::Type::UseMemory && memcmp(curData, newData, size) != 0)
+  {
+    // Update current memory
+    memcpy(curData, newData, size);
+
+    // Record memory update
+    m_MemoryUpdates.push_back(std::move(memUpdate));
+  }
+  else if (task.type == RecorderTask::Type::DynamicUpdate)
+  {
+    // Shadow the data so it won't be recorded as changed by a future UseMemory
+    memcpy(curData, newData, size);
+  }
+}
+
+void FifoRecorder::ProcessEndFrame(RecorderTask& task)
+{
+  task.frame.memoryUpdates = std::move(m_MemoryUpdates);
+  m_MemoryUpdates.clear();
+
+  std::lock_guard<std::recursive_mutex> lk(m_mutex);
+
+  // Move frame to file
+  m_File->AddFrame(std::move(task.frame));
+
+  if (task.callFinishedCb)
+    m_FinishedCb();
+}
+
 FifoRecorder& FifoRecorder::GetInstance()
 {
   return instance;
@@ -4,11 +4,16 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "Common/Event.h"
+#include "Common/SPSCQueue.h"
 #include "Core/FifoPlayer/FifoDataFile.h"
 
 class FifoRecorder
@@ -17,6 +22,7 @@ public:
   using CallbackFunc = std::function<void()>;
 
   FifoRecorder();
+  ~FifoRecorder();
 
   void StartRecording(s32 numFrames, CallbackFunc finishedCb);
   void StopRecording();
@@ -48,6 +54,41 @@ public:
   static FifoRecorder& GetInstance();
 
 private:
+  // Work which is passed from the video thread to the recording thread, which compares used
+  // memory against what has been recorded so far and assembles the frames.
+  struct RecorderTask
+  {
+    enum class Type
+    {
+      UseMemory,
+      DynamicUpdate,
+      EndFrame,
+    };
+
+    Type type;
+    // Contents of the used memory, for UseMemory and DynamicUpdate
+    MemoryUpdate memoryUpdate;
+    // FIFO data of the frame, for EndFrame
+    FifoFrameInfo frame;
+    bool callFinishedCb = false;
+  };
+
+  // The hash of a range of memory the last time it was used, and the sequence number of the
+  // task which passed it to the recording thread.
+  struct UsedMemoryRange
+  {
+    u64 hash;
+    u32 sequence;
+  };
+
+  static constexpr u32 PAGE_SHIFT = 12;
+
+  void StartRecordingThread();
+  void StopRecordingThread();
+  void RecordingThreadFunc();
+  void ProcessMemoryUpdate(RecorderTask& task);
+  void ProcessEndFrame(RecorderTask& task);
+
   // Accessed from both GUI and video threads
 
   std::recursive_mutex m_mutex;
@@ -67,6 +108,21 @@ private:
   bool m_FrameEnded = false;
   FifoFrameInfo m_CurrentFrame;
   std::vector<u8> m_FifoData;
+  // Used to avoid copying and comparing memory which hasn't changed since it was last used
+  std::unordered_map<u64, UsedMemoryRange> m_UsedMemoryRanges;
+  // Sequence number of the last task which passed each page to the recording thread
+  std::vector<u32> m_RamPageSequences;
+  std::vector<u32> m_ExRamPageSequences;
+  u32 m_TaskSequence = 0;
+
+  // Passed from the video thread to the recording thread
+  Common::SPSCQueue<RecorderTask, false> m_Tasks;
+  Common::Event m_TasksAvailable;
+  std::thread m_RecordingThread;
+  std::atomic<bool> m_StopRecordingThread{false};
+
+  // Accessed only from the recording thread
+  std::vector<MemoryUpdate> m_MemoryUpdates;
   std::vector<u8> m_Ram;
   std::vector<u8> m_ExRam;
 };
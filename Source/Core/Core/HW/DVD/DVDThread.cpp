@@ -4,6 +4,7 @@
 
 #include "Core/HW/DVD/DVDThread.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <map>
 #include <memory>
@@ -15,6 +16,7 @@
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
 #include "Common/Event.h"
 #include "Common/Flag.h"
 #include "Common/Logging/Log.h"
@@ -23,6 +25,7 @@
 #include "Common/Thread.h"
 #include "Common/Timer.h"
 
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -179,6 +182,18 @@ void SetDisc(std::unique_ptr<DiscIO::Volume> disc)
 {
   WaitUntilIdle();
   s_disc = std::move(disc);
+
+  // Decompress the data that follows sequential reads on another thread,
+  // so that the DVD thread doesn't have to do it when the data is requested
+  if (s_disc)
+  {
+    const int cache_size = std::max(Config::Get(Config::MAIN_DISC_CACHE_SIZE), 0);
+    const int read_ahead_size = std::max(Config::Get(Config::MAIN_DISC_READ_AHEAD_SIZE), 0);
+    s_disc->EnableReadAhead(cache_size * 1024ULL, read_ahead_size * 1024ULL);
+
+    if (Config::Get(Config::MAIN_MAP_DISC_IMAGES))
+      s_disc->EnableMemoryMapping();
+  }
 }
 
 bool HasDisc()
@@ -23,6 +23,7 @@ namespace FileMonitor
 {
 static DiscIO::Partition s_previous_partition;
 static u64 s_previous_file_offset;
+static u64 s_previous_file_size;
 
 // Filtered files
 static bool IsSoundFile(const std::string& filename)
@@ -56,6 +57,14 @@ void Log(const DiscIO::Volume& volume, const DiscIO::Partition& partition, u64 o
   if (!LogManager::GetInstance()->IsEnabled(LogTypes::FILEMON, LogTypes::LWARNING))
     return;
 
+  // Do nothing if the offset is in the file that was found last time, which is the common case
+  // when a game streams a file. This avoids looking the offset up again for every read.
+  if (s_previous_partition == partition && offset >= s_previous_file_offset &&
+      offset - s_previous_file_offset < s_previous_file_size)
+  {
+    return;
+  }
+
   const DiscIO::FileSystem* file_system = volume.GetFileSystem(partition);
 
   // Do nothing if there is no valid file system
@@ -85,6 +94,7 @@ void Log(const DiscIO::Volume& volume, const DiscIO::Partition& partition, u64 o
   // Update the last accessed file
   s_previous_partition = partition;
   s_previous_file_offset = file_offset;
+  s_previous_file_size = file_info->GetSize();
 }
 
 }  // namespace FileMonitor
@@ -59,6 +59,7 @@ IPC_HLE_PERIOD: For the Wii Remote this is the call schedule:
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/DSPEmulator.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/EXI/EXI_DeviceIPL.h"
@@ -176,7 +177,8 @@ void ThrottleCallback(u64 last_time, s64 cyclesLate)
 
   s64 diff = last_time - time;
   const SConfig& config = SConfig::GetInstance();
-  bool frame_limiter = config.m_EmulationSpeed > 0.0f && !Core::GetIsThrottlerTempDisabled();
+  bool frame_limiter = config.m_EmulationSpeed > 0.0f && !Core::GetIsThrottlerTempDisabled() &&
+                       !FifoPlayer::GetInstance().IsBenchmarking();
   u32 next_event = GetTicksPerSecond() / 1000;
 
   {
@@ -0,0 +1,910 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/BCZBlob.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/Enums.h"
+#include "DiscIO/MultithreadedCompressor.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeWii.h"
+
+namespace DiscIO
+{
+namespace
+{
+constexpr u32 CLUSTER_SIZE = VolumeWii::BLOCK_TOTAL_SIZE;
+constexpr u32 CLUSTER_HEADER_SIZE = VolumeWii::BLOCK_HEADER_SIZE;
+constexpr u32 CLUSTER_DATA_SIZE = VolumeWii::BLOCK_DATA_SIZE;
+constexpr u32 CLUSTERS_PER_SUBGROUP = 8;
+constexpr u32 CLUSTERS_PER_GROUP = 64;
+constexpr u32 GROUP_SIZE = CLUSTER_SIZE * CLUSTERS_PER_GROUP;
+
+constexpr u32 MIN_BLOCK_SIZE = CLUSTER_SIZE;
+constexpr u32 MAX_BLOCK_SIZE = GROUP_SIZE;
+
+constexpr size_t SHA1_SIZE = 20;
+constexpr u32 H0_OFFSET = 0x000;
+constexpr u32 H0_SIZE = SHA1_SIZE * (CLUSTER_DATA_SIZE / 0x400);
+constexpr u32 H1_OFFSET = 0x280;
+constexpr u32 H1_SIZE = SHA1_SIZE * CLUSTERS_PER_SUBGROUP;
+constexpr u32 H2_OFFSET = 0x340;
+constexpr u32 H2_SIZE = SHA1_SIZE * (CLUSTERS_PER_GROUP / CLUSTERS_PER_SUBGROUP);
+
+bool IsValidBlockSize(u32 block_size)
+{
+  return block_size >= MIN_BLOCK_SIZE && block_size <= MAX_BLOCK_SIZE &&
+         (block_size & (block_size - 1)) == 0;
+}
+
+// Regenerates the H0, H1 and H2 hashes of a group from the decrypted data of its clusters.
+// out_headers must hold a zero-filled CLUSTER_HEADER_SIZE bytes for each cluster. The hashes of
+// clusters past the end of a partial group are left as zeroes.
+void HashGroup(const u8* data, u32 num_clusters, u8* out_headers)
+{
+  for (u32 i = 0; i < num_clusters; ++i)
+  {
+    const u8* cluster_data = data + i * CLUSTER_DATA_SIZE;
+    u8* header = out_headers + i * CLUSTER_HEADER_SIZE;
+    for (u32 j = 0; j < CLUSTER_DATA_SIZE / 0x400; ++j)
+    {
+      const Common::SHA1::Digest h0 =
+          Common::SHA1::CalculateDigest(cluster_data + j * 0x400, 0x400);
+      std::copy(h0.begin(), h0.end(), header + H0_OFFSET + j * SHA1_SIZE);
+    }
+  }
+
+  std::array<u8, H2_SIZE> h2_table{};
+  for (u32 subgroup_start = 0; subgroup_start < num_clusters;
+       subgroup_start += CLUSTERS_PER_SUBGROUP)
+  {
+    const u32 subgroup_end = std::min(subgroup_start + CLUSTERS_PER_SUBGROUP, num_clusters);
+
+    std::array<u8, H1_SIZE> h1_table{};
+    for (u32 i = subgroup_start; i < subgroup_end; ++i)
+    {
+      const Common::SHA1::Digest h1 =
+          Common::SHA1::CalculateDigest(out_headers + i * CLUSTER_HEADER_SIZE + H0_OFFSET, H0_SIZE);
+      std::copy(h1.begin(), h1.end(), h1_table.data() + (i - subgroup_start) * SHA1_SIZE);
+    }
+    for (u32 i = subgroup_start; i < subgroup_end; ++i)
+      std::memcpy(out_headers + i * CLUSTER_HEADER_SIZE + H1_OFFSET, h1_table.data(), H1_SIZE);
+
+    const Common::SHA1::Digest h2 = Common::SHA1::CalculateDigest(h1_table);
+    std::copy(h2.begin(), h2.end(),
+              h2_table.data() + subgroup_start / CLUSTERS_PER_SUBGROUP * SHA1_SIZE);
+  }
+
+  for (u32 i = 0; i < num_clusters; ++i)
+    std::memcpy(out_headers + i * CLUSTER_HEADER_SIZE + H2_OFFSET, h2_table.data(), H2_SIZE);
+}
+
+void EncryptCluster(const Common::AES::Context& key, const u8* header, const u8* data,
+                    u8* out_ptr)
+{
+  const std::array<u8, 16> iv{};
+  key.Crypt(iv.data(), header, out_ptr, CLUSTER_HEADER_SIZE);
+  key.Crypt(out_ptr + 0x3D0, data, out_ptr + CLUSTER_HEADER_SIZE, CLUSTER_DATA_SIZE);
+}
+
+void DecryptCluster(const Common::AES::Context& key, const u8* cluster, u8* out_header,
+                    u8* out_data)
+{
+  const std::array<u8, 16> iv{};
+  if (out_header)
+    key.Crypt(iv.data(), cluster, out_header, CLUSTER_HEADER_SIZE);
+  key.Crypt(cluster + 0x3D0, cluster + CLUSTER_HEADER_SIZE, out_data, CLUSTER_DATA_SIZE);
+}
+
+u64 GetRegionChunkCount(const BCZRegion& region, u32 block_size)
+{
+  if (region.partition == BCZRegion::RAW)
+    return (region.size + block_size - 1) / block_size;
+
+  const u64 clusters_per_chunk = block_size / CLUSTER_SIZE;
+  const u64 num_clusters = region.size / CLUSTER_SIZE;
+  return (num_clusters + clusters_per_chunk - 1) / clusters_per_chunk;
+}
+}  // Anonymous namespace
+
+// Presents the decrypted data of a partition with one block per cluster and one chunk per BCZ
+// chunk, so that SectorReader can cache it and read it ahead.
+class BCZFileReader::DecryptedPartitionReader final : public SectorReader
+{
+public:
+  DecryptedPartitionReader(BCZFileReader* parent, u32 partition_index, u64 data_size)
+      : m_parent(parent), m_partition_index(partition_index), m_data_size(data_size)
+  {
+    SetSectorSize(CLUSTER_DATA_SIZE);
+    SetChunkSize(parent->m_header.block_size / CLUSTER_SIZE);
+  }
+  ~DecryptedPartitionReader() { StopReadAhead(); }
+
+  BlobType GetBlobType() const override { return BlobType::BCZ; }
+  u64 GetRawSize() const override { return m_parent->GetRawSize(); }
+  u64 GetDataSize() const override { return m_data_size; }
+  bool IsDataSizeAccurate() const override { return true; }
+
+protected:
+  bool GetBlock(u64 block_num, u8* out_ptr) override
+  {
+    return m_parent->ReadDecryptedClusters(m_partition_index, block_num, 1, out_ptr);
+  }
+
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override
+  {
+    return m_parent->ReadDecryptedClusters(m_partition_index, block_num, num_blocks, out_ptr);
+  }
+
+private:
+  BCZFileReader* m_parent;
+  u32 m_partition_index;
+  u64 m_data_size;
+};
+
+BCZFileReader::BCZFileReader(File::IOFile file, const std::string& path)
+    : m_file(std::move(file)), m_path(path)
+{
+}
+
+BCZFileReader::~BCZFileReader()
+{
+  StopReadAhead();
+
+  // Their read-ahead threads use this reader
+  m_decrypted_readers.clear();
+}
+
+std::unique_ptr<BCZFileReader> BCZFileReader::Create(File::IOFile file, const std::string& path)
+{
+  std::unique_ptr<BCZFileReader> reader(new BCZFileReader(std::move(file), path));
+  if (!reader->Initialize())
+    return nullptr;
+
+  return reader;
+}
+
+bool BCZFileReader::Initialize()
+{
+  m_file_size = m_file.GetSize();
+  m_file.Seek(0, SEEK_SET);
+  if (!m_file.ReadArray(&m_header, 1) || m_header.magic != BCZ_MAGIC)
+    return false;
+
+  if (m_header.version != BCZ_VERSION)
+  {
+    ERROR_LOG(DISCIO, "%s uses unsupported BCZ version %u", m_path.c_str(), m_header.version);
+    return false;
+  }
+
+  if (m_header.compression != BCZCompression::None &&
+      m_header.compression != BCZCompression::Deflate)
+  {
+    ERROR_LOG(DISCIO, "%s uses unknown BCZ compression %u", m_path.c_str(),
+              static_cast<u32>(m_header.compression));
+    return false;
+  }
+
+  if (!IsValidBlockSize(m_header.block_size))
+  {
+    ERROR_LOG(DISCIO, "%s has invalid BCZ block size %u", m_path.c_str(), m_header.block_size);
+    return false;
+  }
+
+  m_partitions.resize(m_header.num_partitions);
+  m_regions.resize(m_header.num_regions);
+  m_chunks.resize(m_header.num_chunks);
+  if (!m_file.Seek(m_header.index_offset, SEEK_SET) ||
+      !m_file.ReadArray(m_partitions.data(), m_partitions.size()) ||
+      !m_file.ReadArray(m_regions.data(), m_regions.size()) ||
+      !m_file.ReadArray(m_chunks.data(), m_chunks.size()))
+  {
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_path.c_str());
+    return false;
+  }
+
+  // The regions must cover the whole disc, in order, and partition regions must start at a group
+  const auto is_valid_region = [this](const BCZRegion& region, u64 offset) {
+    if (region.offset != offset ||
+        region.first_chunk + GetRegionChunkCount(region, m_header.block_size) > m_chunks.size())
+    {
+      return false;
+    }
+    if (region.partition == BCZRegion::RAW)
+      return true;
+
+    return region.partition < m_partitions.size() && region.size % CLUSTER_SIZE == 0 &&
+           region.offset >= m_partitions[region.partition].data_offset &&
+           (region.offset - m_partitions[region.partition].data_offset) % GROUP_SIZE == 0;
+  };
+
+  u64 offset = 0;
+  for (const BCZRegion& region : m_regions)
+  {
+    if (!is_valid_region(region, offset))
+    {
+      PanicAlertT("The disc image \"%s\" is corrupt.", m_path.c_str());
+      return false;
+    }
+    offset += region.size;
+  }
+
+  const bool partitions_valid =
+      std::all_of(m_partitions.begin(), m_partitions.end(),
+                  [](const BCZPartition& p) { return p.data_offset % CLUSTER_SIZE == 0; });
+  if (offset != m_header.data_size || !partitions_valid)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.", m_path.c_str());
+    return false;
+  }
+
+  m_keys.reserve(m_partitions.size());
+  for (const BCZPartition& partition : m_partitions)
+  {
+    m_keys.push_back({Common::AES::CreateContextEncrypt(partition.key.data()),
+                      Common::AES::CreateContextDecrypt(partition.key.data())});
+  }
+
+  m_compressed_buffer.resize(m_header.block_size);
+  m_encrypted_cluster.resize(CLUSTER_SIZE);
+  m_decrypted_chunk.resize(m_header.block_size / CLUSTER_SIZE * CLUSTER_DATA_SIZE);
+
+  SetSectorSize(CLUSTER_SIZE);
+
+  // The size of a partition isn't stored, so it is assumed to end where the next partition starts
+  for (u32 i = 0; i < m_partitions.size(); ++i)
+  {
+    const u64 data_offset = m_partitions[i].data_offset;
+    u64 data_end = m_header.data_size;
+    for (const BCZPartition& partition : m_partitions)
+    {
+      if (partition.partition_offset >= data_offset)
+        data_end = std::min(data_end, partition.partition_offset);
+    }
+
+    const u64 num_clusters = data_end > data_offset ? (data_end - data_offset) / CLUSTER_SIZE : 0;
+    m_decrypted_readers.push_back(
+        std::make_unique<DecryptedPartitionReader>(this, i, num_clusters * CLUSTER_DATA_SIZE));
+  }
+
+  return true;
+}
+
+const BCZRegion* BCZFileReader::FindRegion(u64 offset) const
+{
+  auto it = std::upper_bound(m_regions.begin(), m_regions.end(), offset,
+                             [](u64 value, const BCZRegion& region) {
+                               return value < region.offset;
+                             });
+  if (it == m_regions.begin())
+    return nullptr;
+
+  --it;
+  return offset - it->offset < it->size ? &*it : nullptr;
+}
+
+bool BCZFileReader::ReadChunk(u32 chunk_index, size_t size, u8* out_ptr)
+{
+  const BCZChunk& chunk = m_chunks[chunk_index];
+  if (chunk.size == 0)
+  {
+    std::fill_n(out_ptr, size, 0);
+    return true;
+  }
+
+  const bool uncompressed = (chunk.flags & BCZChunk::UNCOMPRESSED) != 0;
+  if (chunk.size > m_compressed_buffer.size() || (uncompressed && chunk.size != size))
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.", m_path.c_str());
+    return false;
+  }
+
+  u8* const read_ptr = uncompressed ? out_ptr : m_compressed_buffer.data();
+  if (!m_file.Seek(chunk.offset, SEEK_SET) || !m_file.ReadBytes(read_ptr, chunk.size))
+  {
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_path.c_str());
+    m_file.Clear();
+    return false;
+  }
+
+  if (uncompressed)
+    return true;
+
+  uLongf uncompressed_size = static_cast<uLongf>(size);
+  if (uncompress(out_ptr, &uncompressed_size, m_compressed_buffer.data(), chunk.size) != Z_OK ||
+      uncompressed_size != size)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.\n"
+                "Chunk %u could not be decompressed.",
+                m_path.c_str(), chunk_index);
+    return false;
+  }
+
+  return true;
+}
+
+bool BCZFileReader::LoadGroup(const BCZRegion& region, u64 group_offset)
+{
+  if (m_group_region == &region && m_group_offset == group_offset)
+    return true;
+
+  m_group_region = nullptr;
+
+  const u32 clusters_per_chunk = m_header.block_size / CLUSTER_SIZE;
+  const u32 first_cluster = static_cast<u32>((group_offset - region.offset) / CLUSTER_SIZE);
+  const u64 remaining_clusters = (region.offset + region.size - group_offset) / CLUSTER_SIZE;
+  const u32 num_clusters =
+      static_cast<u32>(std::min<u64>(CLUSTERS_PER_GROUP, remaining_clusters));
+
+  m_group_data.resize(num_clusters * CLUSTER_DATA_SIZE);
+  for (u32 i = 0; i < num_clusters; i += clusters_per_chunk)
+  {
+    const u32 chunk_clusters = std::min(clusters_per_chunk, num_clusters - i);
+    if (!ReadChunk(region.first_chunk + (first_cluster + i) / clusters_per_chunk,
+                   chunk_clusters * CLUSTER_DATA_SIZE, m_group_data.data() + i * CLUSTER_DATA_SIZE))
+    {
+      return false;
+    }
+  }
+
+  m_group_hashes.assign(num_clusters * CLUSTER_HEADER_SIZE, 0);
+  HashGroup(m_group_data.data(), num_clusters, m_group_hashes.data());
+
+  m_group_region = &region;
+  m_group_offset = group_offset;
+  return true;
+}
+
+bool BCZFileReader::ReadRaw(u64 offset, u64 size, u8* out_ptr)
+{
+  while (size > 0)
+  {
+    const BCZRegion* region = FindRegion(offset);
+    if (!region)
+      return false;
+
+    const u64 offset_in_region = offset - region->offset;
+    u64 read_size;
+    if (region->partition == BCZRegion::RAW)
+    {
+      const u32 chunk_index =
+          region->first_chunk + static_cast<u32>(offset_in_region / m_header.block_size);
+      const u64 chunk_offset = offset_in_region / m_header.block_size * m_header.block_size;
+      const u64 chunk_size = std::min<u64>(m_header.block_size, region->size - chunk_offset);
+      if (m_raw_chunk_index != chunk_index)
+      {
+        m_raw_chunk_index = UINT32_MAX;
+        m_raw_chunk.resize(chunk_size);
+        if (!ReadChunk(chunk_index, chunk_size, m_raw_chunk.data()))
+          return false;
+        m_raw_chunk_index = chunk_index;
+      }
+
+      const u64 offset_in_chunk = offset_in_region - chunk_offset;
+      read_size = std::min(size, chunk_size - offset_in_chunk);
+      std::copy_n(m_raw_chunk.data() + offset_in_chunk, read_size, out_ptr);
+    }
+    else
+    {
+      const u64 group_offset = region->offset + offset_in_region / GROUP_SIZE * GROUP_SIZE;
+      if (!LoadGroup(*region, group_offset))
+        return false;
+
+      const u64 cluster_index = (offset - group_offset) / CLUSTER_SIZE;
+      const u64 offset_in_cluster = (offset - group_offset) % CLUSTER_SIZE;
+      read_size = std::min<u64>(size, CLUSTER_SIZE - offset_in_cluster);
+
+      u8* cluster_ptr = read_size == CLUSTER_SIZE ? out_ptr : m_encrypted_cluster.data();
+      EncryptCluster(*m_keys[region->partition].encrypt,
+                     m_group_hashes.data() + cluster_index * CLUSTER_HEADER_SIZE,
+                     m_group_data.data() + cluster_index * CLUSTER_DATA_SIZE, cluster_ptr);
+      if (cluster_ptr != out_ptr)
+        std::copy_n(cluster_ptr + offset_in_cluster, read_size, out_ptr);
+    }
+
+    offset += read_size;
+    size -= read_size;
+    out_ptr += read_size;
+  }
+
+  return true;
+}
+
+bool BCZFileReader::GetBlock(u64 block_num, u8* out_ptr)
+{
+  const u64 offset = block_num * CLUSTER_SIZE;
+  if (offset >= m_header.data_size)
+    return false;
+
+  // The data size doesn't have to be a multiple of the sector size
+  const u64 size = std::min<u64>(CLUSTER_SIZE, m_header.data_size - offset);
+  std::fill(out_ptr + size, out_ptr + CLUSTER_SIZE, 0);
+  return ReadRaw(offset, size, out_ptr);
+}
+
+bool BCZFileReader::ReadDecryptedClusters(u32 partition_index, u64 first_cluster,
+                                          u64 num_clusters, u8* out_ptr)
+{
+  // The buffers are shared with GetBlock, which may be running on the read-ahead thread
+  std::lock_guard<std::mutex> lk(m_read_mutex);
+
+  const u32 clusters_per_chunk = m_header.block_size / CLUSTER_SIZE;
+  while (num_clusters > 0)
+  {
+    const u64 cluster_offset =
+        m_partitions[partition_index].data_offset + first_cluster * CLUSTER_SIZE;
+    const BCZRegion* region = FindRegion(cluster_offset);
+    if (!region)
+      return false;
+
+    u64 read_clusters;
+    if (region->partition == partition_index)
+    {
+      // Partition regions store the decrypted data, so it only has to be decompressed. Whole
+      // chunks are decompressed straight into the output.
+      const u64 cluster_in_region = (cluster_offset - region->offset) / CLUSTER_SIZE;
+      const u64 chunk_in_region = cluster_in_region / clusters_per_chunk;
+      const u64 first_chunk_cluster = chunk_in_region * clusters_per_chunk;
+      const u64 chunk_clusters =
+          std::min<u64>(clusters_per_chunk, region->size / CLUSTER_SIZE - first_chunk_cluster);
+      const u64 offset_in_chunk = cluster_in_region - first_chunk_cluster;
+      read_clusters = std::min(num_clusters, chunk_clusters - offset_in_chunk);
+
+      const u32 chunk_index = region->first_chunk + static_cast<u32>(chunk_in_region);
+      const size_t chunk_size = static_cast<size_t>(chunk_clusters * CLUSTER_DATA_SIZE);
+      if (read_clusters == chunk_clusters)
+      {
+        if (!ReadChunk(chunk_index, chunk_size, out_ptr))
+          return false;
+      }
+      else
+      {
+        if (!ReadChunk(chunk_index, chunk_size, m_decrypted_chunk.data()))
+          return false;
+        std::copy_n(m_decrypted_chunk.data() + offset_in_chunk * CLUSTER_DATA_SIZE,
+                    read_clusters * CLUSTER_DATA_SIZE, out_ptr);
+      }
+    }
+    else
+    {
+      // This cluster couldn't be stored decrypted, so it has to be decrypted like on a plain disc
+      if (!ReadRaw(cluster_offset, CLUSTER_SIZE, m_encrypted_cluster.data()))
+        return false;
+      DecryptCluster(*m_keys[partition_index].decrypt, m_encrypted_cluster.data(), nullptr,
+                     out_ptr);
+      read_clusters = 1;
+    }
+
+    first_cluster += read_clusters;
+    num_clusters -= read_clusters;
+    out_ptr += read_clusters * CLUSTER_DATA_SIZE;
+  }
+
+  return true;
+}
+
+bool BCZFileReader::ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset)
+{
+  const auto it = std::find_if(
+      m_partitions.begin(), m_partitions.end(),
+      [partition_offset](const BCZPartition& p) { return p.partition_offset == partition_offset; });
+  if (it == m_partitions.end())
+    return false;
+
+  return m_decrypted_readers[it - m_partitions.begin()]->Read(offset, size, out_ptr);
+}
+
+void BCZFileReader::EnableReadAhead(u64 cache_size, u64 read_ahead_size)
+{
+  // Reads from partitions are decrypted reads, so on Wii discs, only the small parts of the disc
+  // outside of partitions use the encrypted cache
+  if (m_decrypted_readers.empty())
+    SectorReader::EnableReadAhead(cache_size, read_ahead_size);
+
+  for (std::unique_ptr<DecryptedPartitionReader>& reader : m_decrypted_readers)
+    reader->EnableReadAhead(cache_size, read_ahead_size);
+}
+
+namespace
+{
+struct ConvertPartition
+{
+  BCZPartition partition;
+  u64 data_end;
+  std::unique_ptr<Common::AES::Context> key;
+};
+
+struct BCZCompressParameters
+{
+  u64 offset;
+  std::vector<u8> data;
+  ConvertPartition* partition;  // The partition the data is in, if any
+  u32 partition_index;
+};
+
+struct BCZOutputChunk
+{
+  std::vector<u8> data;  // Empty if the chunk only contains zeroes
+  u32 flags;
+};
+
+struct BCZOutputParameters
+{
+  u64 offset;
+  u64 size;
+  u32 partition;  // Index of the partition, or BCZRegion::RAW
+  std::vector<BCZOutputChunk> chunks;
+};
+
+struct BCZCompressState
+{
+  std::vector<u8> compressed_buffer;
+  std::vector<u8> group_data;
+  std::vector<u8> group_headers;
+  std::vector<u8> hashes;
+};
+
+BCZOutputChunk CompressChunk(BCZCompressState* state, const u8* data, size_t size,
+                             int compression_level)
+{
+  if (std::all_of(data, data + size, [](u8 x) { return x == 0; }))
+    return {{}, 0};
+
+  if (compression_level > 0)
+  {
+    state->compressed_buffer.resize(compressBound(static_cast<uLong>(size)));
+    uLongf compressed_size = static_cast<uLongf>(state->compressed_buffer.size());
+    if (compress2(state->compressed_buffer.data(), &compressed_size, data,
+                  static_cast<uLong>(size), compression_level) == Z_OK &&
+        compressed_size < size)
+    {
+      const auto begin = state->compressed_buffer.begin();
+      return {{begin, begin + compressed_size}, 0};
+    }
+  }
+
+  return {{data, data + size}, BCZChunk::UNCOMPRESSED};
+}
+
+// Decrypts and compresses a group of a partition, or compresses a piece of raw data
+BCZOutputParameters CompressBCZData(BCZCompressState* state, BCZCompressParameters parameters,
+                                    u32 block_size, int compression_level)
+{
+  const std::vector<u8>& data = parameters.data;
+  const u32 num_clusters = static_cast<u32>(data.size() / CLUSTER_SIZE);
+  bool store_decrypted = parameters.partition && data.size() % CLUSTER_SIZE == 0;
+  if (store_decrypted)
+  {
+    state->group_data.resize(num_clusters * CLUSTER_DATA_SIZE);
+    state->group_headers.resize(num_clusters * CLUSTER_HEADER_SIZE);
+    state->hashes.assign(num_clusters * CLUSTER_HEADER_SIZE, 0);
+
+    // Decryption doesn't modify the AES context, so the context can be shared between threads
+    const Common::AES::Context& key = *parameters.partition->key;
+    for (u32 i = 0; i < num_clusters; ++i)
+    {
+      DecryptCluster(key, data.data() + i * CLUSTER_SIZE,
+                     state->group_headers.data() + i * CLUSTER_HEADER_SIZE,
+                     state->group_data.data() + i * CLUSTER_DATA_SIZE);
+    }
+
+    // Only store the group decrypted if the original disc image can be recreated exactly
+    HashGroup(state->group_data.data(), num_clusters, state->hashes.data());
+    store_decrypted = state->hashes == state->group_headers;
+  }
+
+  BCZOutputParameters output{parameters.offset, data.size(), BCZRegion::RAW, {}};
+  if (store_decrypted)
+  {
+    output.partition = parameters.partition_index;
+
+    const u32 clusters_per_chunk = block_size / CLUSTER_SIZE;
+    for (u32 i = 0; i < num_clusters; i += clusters_per_chunk)
+    {
+      const u32 chunk_clusters = std::min(clusters_per_chunk, num_clusters - i);
+      output.chunks.push_back(CompressChunk(state,
+                                            state->group_data.data() + i * CLUSTER_DATA_SIZE,
+                                            chunk_clusters * CLUSTER_DATA_SIZE, compression_level));
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < data.size(); i += block_size)
+    {
+      const size_t chunk_size = std::min<size_t>(block_size, data.size() - i);
+      output.chunks.push_back(
+          CompressChunk(state, data.data() + i, chunk_size, compression_level));
+    }
+  }
+
+  return output;
+}
+
+class BCZWriter
+{
+public:
+  BCZWriter(File::IOFile* outfile, u32 block_size) : m_outfile(outfile), m_block_size(block_size)
+  {
+  }
+
+  u64 GetPosition() const { return m_position; }
+  const std::vector<BCZRegion>& GetRegions() const { return m_regions; }
+  const std::vector<BCZChunk>& GetChunks() const { return m_chunks; }
+
+  // Adds data that directly follows the previously added data
+  bool Write(const BCZOutputParameters& data)
+  {
+    // Raw regions can be continued if all their chunks are full, and partition regions if all
+    // their groups are full, since chunks and groups are located by their offset in the region
+    const u64 region_alignment = data.partition == BCZRegion::RAW ? m_block_size : GROUP_SIZE;
+    if (m_regions.empty() || m_regions.back().partition != data.partition ||
+        m_regions.back().size % region_alignment != 0)
+    {
+      m_regions.push_back({data.offset, 0, data.partition, static_cast<u32>(m_chunks.size())});
+    }
+
+    for (const BCZOutputChunk& chunk : data.chunks)
+    {
+      if (chunk.data.empty())
+      {
+        m_chunks.push_back({0, 0, 0});
+        continue;
+      }
+
+      if (!m_outfile->WriteBytes(chunk.data.data(), chunk.data.size()))
+        return false;
+
+      m_chunks.push_back({m_position, static_cast<u32>(chunk.data.size()), chunk.flags});
+      m_position += chunk.data.size();
+    }
+
+    m_regions.back().size += data.size;
+    return true;
+  }
+
+private:
+  File::IOFile* m_outfile;
+  u32 m_block_size;
+  // Also read by the converting thread to report the compression ratio
+  std::atomic<u64> m_position{sizeof(BCZHeader)};
+  std::vector<BCZRegion> m_regions;
+  std::vector<BCZChunk> m_chunks;
+};
+
+// Returns the encrypted partitions whose groups can be stored decrypted, sorted by offset
+std::vector<ConvertPartition> GetConvertPartitions(const std::string& path, u64 data_size)
+{
+  std::vector<ConvertPartition> partitions;
+
+  std::unique_ptr<VolumeDisc> volume = CreateDisc(path);
+  if (!volume || volume->GetVolumeType() != Platform::WiiDisc || !volume->IsEncryptedAndHashed())
+    return partitions;
+
+  for (const Partition& partition : volume->GetPartitions())
+  {
+    const IOS::ES::TicketReader& ticket = volume->GetTicket(partition);
+    const std::optional<u64> data_offset =
+        volume->ReadSwappedAndShifted(partition.offset + 0x2b8, PARTITION_NONE);
+    const std::optional<u64> size =
+        volume->ReadSwappedAndShifted(partition.offset + 0x2bc, PARTITION_NONE);
+    if (!ticket.IsValid() || !data_offset || !size)
+      continue;
+
+    const u64 start = partition.offset + *data_offset;
+    const u64 end = std::min(start + *size / CLUSTER_SIZE * CLUSTER_SIZE, data_size);
+    if (start % CLUSTER_SIZE != 0 || start >= end)
+      continue;
+
+    ConvertPartition& p = partitions.emplace_back();
+    p.partition = {partition.offset, start, ticket.GetTitleKey()};
+    p.data_end = end;
+  }
+
+  std::sort(partitions.begin(), partitions.end(),
+            [](const ConvertPartition& a, const ConvertPartition& b) {
+              return a.partition.data_offset < b.partition.data_offset;
+            });
+
+  // Partitions are expected to never overlap, but if they do, only the first one is used
+  for (size_t i = 1; i < partitions.size();)
+  {
+    if (partitions[i].partition.data_offset < partitions[i - 1].data_end)
+      partitions.erase(partitions.begin() + i);
+    else
+      ++i;
+  }
+
+  return partitions;
+}
+}  // Anonymous namespace
+
+bool ConvertToBCZ(const std::string& infile_path, const std::string& outfile_path, u32 block_size,
+                  int compression_level, CompressCB callback, void* arg)
+{
+  if (!IsValidBlockSize(block_size))
+  {
+    PanicAlertT("The block size %u is not supported.", block_size);
+    return false;
+  }
+
+  std::unique_ptr<BlobReader> reader = CreateBlobReader(infile_path);
+  if (!reader)
+  {
+    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    return false;
+  }
+
+  if (reader->GetBlobType() == BlobType::BCZ)
+  {
+    PanicAlertT("\"%s\" is already compressed! Cannot compress it further.", infile_path.c_str());
+    return false;
+  }
+
+  File::IOFile outfile(outfile_path, "wb");
+  if (!outfile)
+  {
+    PanicAlertT("Failed to open the output file \"%s\".\n"
+                "Check that you have permissions to write the target folder and that the media can "
+                "be written.",
+                outfile_path.c_str());
+    return false;
+  }
+
+  const u64 data_size = reader->GetDataSize();
+  std::vector<ConvertPartition> partitions = GetConvertPartitions(infile_path, data_size);
+  for (ConvertPartition& p : partitions)
+    p.key = Common::AES::CreateContextDecrypt(p.partition.key.data());
+
+  if (callback)
+    callback(Common::GetStringT("Files opened, ready to compress."), 0, arg);
+
+  // seek past the header (we will write it at the end)
+  outfile.Seek(sizeof(BCZHeader), SEEK_SET);
+
+  BCZWriter writer(&outfile, block_size);
+
+  const auto compress = [block_size, compression_level](BCZCompressState* state,
+                                                        BCZCompressParameters parameters) {
+    return std::optional<BCZOutputParameters>(
+        CompressBCZData(state, std::move(parameters), block_size, compression_level));
+  };
+
+  const auto output = [&writer, &outfile_path](BCZOutputParameters parameters) {
+    if (!writer.Write(parameters))
+    {
+      PanicAlertT("Failed to write the output file \"%s\".\n"
+                  "Check that you have enough space available on the target drive.",
+                  outfile_path.c_str());
+      return false;
+    }
+    return true;
+  };
+
+  const u64 num_blocks = (data_size + block_size - 1) / block_size;
+  const u64 progress_interval = std::max<u64>(GROUP_SIZE, data_size / 1000);
+  u64 next_progress = 0;
+  u64 offset = 0;
+  size_t partition_index = 0;
+  bool success = true;
+
+  {
+    MultithreadedCompressor<BCZCompressState, BCZCompressParameters, BCZOutputParameters>
+        compressor(nullptr, compress, output);
+
+    while (offset < data_size)
+    {
+      if (callback && offset >= next_progress)
+      {
+        const int ratio = offset == 0 ? 0 : static_cast<int>(100 * writer.GetPosition() / offset);
+        const std::string text =
+            StringFromFormat(Common::GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                             static_cast<int>(offset / block_size), static_cast<int>(num_blocks),
+                             ratio);
+        if (!callback(text, static_cast<float>(offset) / static_cast<float>(data_size), arg))
+        {
+          success = false;
+          break;
+        }
+        next_progress = offset + progress_interval;
+      }
+
+      ConvertPartition* partition =
+          partition_index < partitions.size() ? &partitions[partition_index] : nullptr;
+      const bool in_partition = partition && offset >= partition->partition.data_offset;
+
+      const u64 end = in_partition ? partition->data_end :
+                                     partition ? partition->partition.data_offset : data_size;
+      const u64 size = std::min<u64>(in_partition ? GROUP_SIZE : block_size, end - offset);
+
+      std::vector<u8> buffer(size);
+      if (!reader->Read(offset, size, buffer.data()))
+      {
+        PanicAlertT("Failed to read from the input file \"%s\".", infile_path.c_str());
+        success = false;
+        break;
+      }
+
+      if (!compressor.CompressAndWrite({offset, std::move(buffer),
+                                        in_partition ? partition : nullptr,
+                                        static_cast<u32>(partition_index)}))
+      {
+        success = false;
+        break;
+      }
+
+      offset += size;
+      if (in_partition && offset >= partition->data_end)
+        ++partition_index;
+    }
+
+    success = compressor.Finish() && success;
+  }
+
+  if (success)
+  {
+    BCZHeader header{};
+    header.magic = BCZ_MAGIC;
+    header.version = BCZ_VERSION;
+    header.compression = compression_level > 0 ? BCZCompression::Deflate : BCZCompression::None;
+    header.block_size = block_size;
+    header.data_size = data_size;
+    header.index_offset = writer.GetPosition();
+    header.num_partitions = static_cast<u32>(partitions.size());
+    header.num_regions = static_cast<u32>(writer.GetRegions().size());
+    header.num_chunks = static_cast<u32>(writer.GetChunks().size());
+
+    std::vector<BCZPartition> partition_table;
+    for (const ConvertPartition& p : partitions)
+      partition_table.push_back(p.partition);
+
+    success = outfile.WriteArray(partition_table.data(), partition_table.size()) &&
+              outfile.WriteArray(writer.GetRegions().data(), writer.GetRegions().size()) &&
+              outfile.WriteArray(writer.GetChunks().data(), writer.GetChunks().size()) &&
+              outfile.Seek(0, SEEK_SET) && outfile.WriteArray(&header, 1);
+    if (!success)
+    {
+      PanicAlertT("Failed to write the output file \"%s\".\n"
+                  "Check that you have enough space available on the target drive.",
+                  outfile_path.c_str());
+    }
+  }
+
+  if (!success)
+  {
+    // Remove the incomplete output file.
+    outfile.Close();
+    File::Delete(outfile_path);
+    return false;
+  }
+
+  if (callback)
+    callback(Common::GetStringT("Done compressing disc image."), 1.0f, arg);
+  return true;
+}
+
+}  // namespace DiscIO
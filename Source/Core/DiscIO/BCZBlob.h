@@ -0,0 +1,164 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// To create new BCZ files, use ConvertToBCZ.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/File.h"
+#include "DiscIO/Blob.h"
+
+namespace DiscIO
+{
+static constexpr u32 BCZ_MAGIC = 0x015A4342;  // "BCZ\x01"
+static constexpr u32 BCZ_VERSION = 1;
+
+// BCZ file structure:
+// BCZHeader
+// compressed data
+// BCZPartition[num_partitions]
+// BCZRegion[num_regions]
+// BCZChunk[num_chunks]
+//
+// The disc is split into regions. Raw regions store the disc as it is. Partition regions cover
+// whole hash groups of an encrypted Wii partition, and only store the decrypted data of each
+// cluster, as encrypted data and hashes don't compress. When they are read, the hashes are
+// regenerated and the data is encrypted again. Groups whose hashes can't be regenerated exactly
+// are stored in raw regions instead, so that the original disc image can always be recreated.
+//
+// Each region is split into chunks, each of which holds block_size bytes of the disc and is
+// compressed separately, so that any part of the disc can be read without reading the rest.
+
+enum class BCZCompression : u32
+{
+  None = 0,
+  Deflate = 1,
+};
+
+struct BCZHeader  // 48 bytes
+{
+  u32 magic;
+  u32 version;
+  BCZCompression compression;
+  u32 block_size;
+  u64 data_size;
+  u64 index_offset;  // Offset of the partition, region and chunk tables
+  u32 num_partitions;
+  u32 num_regions;
+  u32 num_chunks;
+  u32 reserved;
+};
+static_assert(sizeof(BCZHeader) == 48, "BCZHeader should be 48 bytes");
+
+struct BCZPartition  // 32 bytes
+{
+  u64 partition_offset;
+  u64 data_offset;  // Offset of the first cluster on the disc
+  std::array<u8, 16> key;
+};
+static_assert(sizeof(BCZPartition) == 32, "BCZPartition should be 32 bytes");
+
+struct BCZRegion  // 24 bytes
+{
+  static constexpr u32 RAW = 0xFFFFFFFF;
+
+  u64 offset;
+  u64 size;
+  u32 partition;  // Index of the partition, or RAW
+  u32 first_chunk;
+};
+static_assert(sizeof(BCZRegion) == 24, "BCZRegion should be 24 bytes");
+
+struct BCZChunk  // 16 bytes
+{
+  enum Flags : u32
+  {
+    UNCOMPRESSED = 1,
+  };
+
+  u64 offset;
+  u32 size;  // Zero if the chunk only contains zeroes, in which case nothing is stored
+  u32 flags;
+};
+static_assert(sizeof(BCZChunk) == 16, "BCZChunk should be 16 bytes");
+
+class BCZFileReader : public SectorReader
+{
+public:
+  static std::unique_ptr<BCZFileReader> Create(File::IOFile file, const std::string& path);
+  ~BCZFileReader();
+
+  BlobType GetBlobType() const override { return BlobType::BCZ; }
+  u64 GetRawSize() const override { return m_file_size; }
+  u64 GetDataSize() const override { return m_header.data_size; }
+  bool IsDataSizeAccurate() const override { return true; }
+
+  bool SupportsReadWiiDecrypted() const override { return !m_partitions.empty(); }
+  bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset) override;
+
+  void EnableReadAhead(u64 cache_size, u64 read_ahead_size) override;
+
+  bool GetBlock(u64 block_num, u8* out_ptr) override;
+
+private:
+  class DecryptedPartitionReader;
+
+  struct PartitionKeys
+  {
+    std::unique_ptr<Common::AES::Context> encrypt;
+    std::unique_ptr<Common::AES::Context> decrypt;
+  };
+
+  BCZFileReader(File::IOFile file, const std::string& path);
+  bool Initialize();
+
+  const BCZRegion* FindRegion(u64 offset) const;
+  bool ReadChunk(u32 chunk_index, size_t size, u8* out_ptr);
+  bool ReadRaw(u64 offset, u64 size, u8* out_ptr);
+  bool LoadGroup(const BCZRegion& region, u64 group_offset);
+  bool ReadDecryptedClusters(u32 partition_index, u64 first_cluster, u64 num_clusters,
+                             u8* out_ptr);
+
+  BCZHeader m_header;
+  std::vector<BCZPartition> m_partitions;
+  std::vector<BCZRegion> m_regions;
+  std::vector<BCZChunk> m_chunks;
+  std::vector<PartitionKeys> m_keys;
+
+  File::IOFile m_file;
+  u64 m_file_size;
+  std::string m_path;
+  std::vector<u8> m_compressed_buffer;
+
+  // The most recently read chunk of a raw region
+  u32 m_raw_chunk_index = UINT32_MAX;
+  std::vector<u8> m_raw_chunk;
+
+  // The most recently read group of a partition region, with its regenerated hashes. Only
+  // encrypted reads use it, decrypted reads decompress the chunks they need directly.
+  const BCZRegion* m_group_region = nullptr;
+  u64 m_group_offset = 0;
+  std::vector<u8> m_group_data;
+  std::vector<u8> m_group_hashes;
+
+  std::vector<u8> m_encrypted_cluster;
+  std::vector<u8> m_decrypted_chunk;
+
+  // Decrypted reads of each partition go through a SectorReader of their own, so that they are
+  // cached and read ahead like encrypted reads
+  std::vector<std::unique_ptr<DecryptedPartitionReader>> m_decrypted_readers;
+};
+
+bool ConvertToBCZ(const std::string& infile_path, const std::string& outfile_path,
+                  u32 block_size = 0x20000, int compression_level = 9,
+                  CompressCB callback = nullptr, void* arg = nullptr);
+
+}  // namespace DiscIO
@@ -3,16 +3,21 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cinttypes>
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
 #include "Common/CDUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
 
+#include "DiscIO/BCZBlob.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
 #include "DiscIO/CompressedBlob.h"
@@ -45,46 +50,151 @@ SectorReader::~SectorReader()
 {
 }
 
-const SectorReader::Cache* SectorReader::FindCacheLine(u64 block_num)
+void SectorReader::EnableReadAhead(u64 cache_size, u64 read_ahead_size)
 {
-  auto itr = std::find_if(m_cache.begin(), m_cache.end(),
-                          [&](const Cache& entry) { return entry.Contains(block_num); });
-  if (itr == m_cache.end())
-    return nullptr;
+  StopReadAhead();
+
+  const u64 chunk_size = static_cast<u64>(m_chunk_blocks) * m_block_size;
+  if (chunk_size == 0)
+    return;
+
+  // The cache never gets smaller than the default size
+  const size_t cache_lines =
+      static_cast<size_t>(std::max<u64>(cache_size / chunk_size, CACHE_LINES));
+  if (cache_lines != m_cache.size())
+  {
+    m_cache.resize(cache_lines);
+    for (Cache& cache_entry : m_cache)
+      cache_entry.data.resize(chunk_size);
+  }
+
+  // Leave half of the cache for data that has already been read
+  m_read_ahead_chunks = std::min<u64>(read_ahead_size / chunk_size, cache_lines / 2);
+  m_last_read_chunk = UINT64_MAX;
+  m_sequential_reads = 0;
+  m_read_ahead_next = 0;
+  m_read_ahead_end = 0;
+  m_stats = {};
+
+  if (m_read_ahead_chunks != 0)
+    m_read_ahead_thread = std::thread(&SectorReader::ReadAheadThread, this);
+}
+
+void SectorReader::StopReadAhead()
+{
+  if (!m_read_ahead_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(m_cache_mutex);
+    m_read_ahead_exiting = true;
+  }
+  m_read_ahead_changed.notify_one();
+  m_read_ahead_thread.join();
+  m_read_ahead_exiting = false;
+
+  const ReadAheadStats stats = GetReadAheadStats();
+  INFO_LOG(DISCIO,
+           "Read-ahead: %" PRIu64 " hits, %" PRIu64 " read-ahead hits, %" PRIu64 " waits, %" PRIu64
+           " misses, %" PRIu64 " chunks read ahead, %" PRIu64 " unused",
+           stats.hits, stats.read_ahead_hits, stats.waits, stats.misses, stats.read_ahead,
+           stats.wasted);
+}
 
-  itr->MarkUsed();
-  return &*itr;
+ReadAheadStats SectorReader::GetReadAheadStats() const
+{
+  std::lock_guard<std::mutex> lk(m_cache_mutex);
+  return m_stats;
+}
+
+SectorReader::Cache* SectorReader::FindCacheLine(u64 chunk_num)
+{
+  const u64 first_block = chunk_num * m_chunk_blocks;
+  auto itr = std::find_if(m_cache.begin(), m_cache.end(),
+                          [&](const Cache& entry) { return entry.HoldsChunk(first_block); });
+  return itr != m_cache.end() ? &*itr : nullptr;
 }
 
 SectorReader::Cache* SectorReader::GetEmptyCacheLine()
 {
-  Cache* oldest = &m_cache[0];
-  // Find the Least Recently Used cache line to replace.
-  std::for_each(m_cache.begin() + 1, m_cache.end(), [&](Cache& line) {
-    if (line.IsLessRecentlyUsedThan(*oldest))
+  // Find the Least Recently Used cache line to replace. Lines that are being loaded can't be
+  // replaced, but at most two lines (one per thread) are being loaded at any time.
+  Cache* oldest = nullptr;
+  for (Cache& line : m_cache)
+  {
+    if (line.pending)
+      continue;
+
+    if (!oldest)
+    {
+      oldest = &line;
+    }
+    else if (line.IsLessRecentlyUsedThan(*oldest))
     {
       oldest->ShiftLRU();
       oldest = &line;
-      return;
     }
-    line.ShiftLRU();
-  });
+    else
+    {
+      line.ShiftLRU();
+    }
+  }
+
+  if (oldest->read_ahead)
+    ++m_stats.wasted;
+
   oldest->Reset();
   return oldest;
 }
 
-const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
+const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num,
+                                                      std::unique_lock<std::mutex>& lock)
 {
-  if (auto entry = FindCacheLine(block_num))
-    return entry;
+  // We only read aligned chunks, this avoids duplicate overlapping entries.
+  const u64 chunk_idx = block_num / m_chunk_blocks;
+
+  while (Cache* entry = FindCacheLine(chunk_idx))
+  {
+    if (entry->pending)
+    {
+      // The read-ahead thread is loading this chunk. Wait for it instead of loading it twice,
+      // and look again afterwards in case loading it failed.
+      ++m_stats.waits;
+      m_cache_line_loaded.wait(lock, [entry] { return !entry->pending; });
+      continue;
+    }
+
+    if (entry->read_ahead)
+    {
+      ++m_stats.read_ahead_hits;
+      entry->read_ahead = false;
+    }
+    else
+    {
+      ++m_stats.hits;
+    }
+
+    entry->MarkUsed();
+    return entry->Contains(block_num) ? entry : nullptr;
+  }
 
   // Cache miss. Fault in the missing entry.
+  ++m_stats.misses;
   Cache* cache = GetEmptyCacheLine();
-  // We only read aligned chunks, this avoids duplicate overlapping entries.
-  u64 chunk_idx = block_num / m_chunk_blocks;
+  cache->block_idx = chunk_idx * m_chunk_blocks;
+  cache->pending = true;
+
+  lock.unlock();
   u32 blocks_read = ReadChunk(cache->data.data(), chunk_idx);
+  lock.lock();
+
+  cache->pending = false;
+  m_cache_line_loaded.notify_all();
   if (!blocks_read)
+  {
+    cache->Reset();
     return nullptr;
+  }
   cache->Fill(chunk_idx * m_chunk_blocks, blocks_read);
 
   // Secondary check for out-of-bounds read.
@@ -96,15 +206,27 @@ const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
 {
+  if (size == 0)
+    return true;
+
+  const u64 chunk_size = static_cast<u64>(m_chunk_blocks) * m_block_size;
+  const u64 first_chunk = offset / chunk_size;
+  const u64 last_chunk = (offset + size - 1) / chunk_size;
+
   u64 remain = size;
   u64 block = 0;
   u32 position_in_block = static_cast<u32>(offset % m_block_size);
 
+  std::unique_lock<std::mutex> lk(m_cache_mutex);
+
+  if (m_read_ahead_thread.joinable())
+    UpdateReadAhead(first_chunk, last_chunk);
+
   while (remain > 0)
   {
     block = offset / m_block_size;
 
-    const Cache* cache = GetCacheLine(block);
+    const Cache* cache = GetCacheLine(block, lk);
     if (!cache)
       return false;
 
@@ -124,6 +246,76 @@ bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
   return true;
 }
 
+void SectorReader::UpdateReadAhead(u64 first_chunk, u64 last_chunk)
+{
+  const bool sequential = first_chunk == m_last_read_chunk || first_chunk == m_last_read_chunk + 1;
+  m_sequential_reads = sequential ? m_sequential_reads + 1 : 0;
+  m_last_read_chunk = last_chunk;
+
+  if (m_sequential_reads < SEQUENTIAL_READS_FOR_READ_AHEAD)
+  {
+    // Drop the chunks that were queued for an earlier sequential read
+    m_read_ahead_next = m_read_ahead_end;
+    return;
+  }
+
+  // The chunks of this read are loaded by the caller, so read ahead from the chunk after them.
+  // Chunks that were already read ahead are skipped by the read-ahead thread.
+  m_read_ahead_next = std::max(m_read_ahead_next, last_chunk + 1);
+  m_read_ahead_end = last_chunk + 1 + m_read_ahead_chunks;
+  m_read_ahead_changed.notify_one();
+}
+
+void SectorReader::ReadAheadThread()
+{
+  Common::SetCurrentThreadName("Read-ahead thread");
+
+  const u64 chunk_size = static_cast<u64>(m_chunk_blocks) * m_block_size;
+  const u64 end_chunk = (GetDataSize() + chunk_size - 1) / chunk_size;
+
+  std::unique_lock<std::mutex> lk(m_cache_mutex);
+  while (true)
+  {
+    m_read_ahead_changed.wait(
+        lk, [this] { return m_read_ahead_exiting || m_read_ahead_next < m_read_ahead_end; });
+    if (m_read_ahead_exiting)
+      return;
+
+    const u64 chunk_idx = m_read_ahead_next++;
+
+    // Don't read past the end of the disc, or read chunks that are already cached
+    if (chunk_idx >= end_chunk)
+    {
+      m_read_ahead_next = m_read_ahead_end;
+      continue;
+    }
+    if (FindCacheLine(chunk_idx))
+      continue;
+
+    Cache* cache = GetEmptyCacheLine();
+    cache->block_idx = chunk_idx * m_chunk_blocks;
+    cache->pending = true;
+
+    lk.unlock();
+    const u32 blocks_read = ReadChunk(cache->data.data(), chunk_idx);
+    lk.lock();
+
+    cache->pending = false;
+    if (blocks_read)
+    {
+      cache->Fill(chunk_idx * m_chunk_blocks, blocks_read);
+      cache->read_ahead = true;
+      ++m_stats.read_ahead;
+    }
+    else
+    {
+      cache->Reset();
+      m_read_ahead_next = m_read_ahead_end;
+    }
+    m_cache_line_loaded.notify_all();
+  }
+}
+
 // Crap default implementation if not overridden.
 bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 cnt_blocks, u8* out_ptr)
 {
@@ -138,6 +330,8 @@ bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 cnt_blocks, u8*
 
 u32 SectorReader::ReadChunk(u8* buffer, u64 chunk_num)
 {
+  std::lock_guard<std::mutex> lk(m_read_mutex);
+
   u64 block_num = chunk_num * m_chunk_blocks;
   u32 cnt_blocks = m_chunk_blocks;
 
@@ -194,6 +388,8 @@ std::unique_ptr<BlobReader> CreateBlobReader(const std::string& filename)
 
   switch (magic)
   {
+  case BCZ_MAGIC:
+    return BCZFileReader::Create(std::move(file), filename);
   case CISO_MAGIC:
     return CISOFileReader::Create(std::move(file));
   case GCZ_MAGIC:
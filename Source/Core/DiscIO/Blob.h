@@ -14,10 +14,12 @@
 // detect whether the file is a compressed blob, or just a big hunk of data, or a drive, and
 // automatically do the right thing.
 
-#include <array>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -34,7 +36,8 @@ enum class BlobType
   GCZ,
   CISO,
   WBFS,
-  TGC
+  TGC,
+  BCZ
 };
 
 class BlobReader
@@ -63,10 +66,37 @@ public:
     return false;
   }
 
+  // Lets readers that have to decompress the data cache up to cache_size bytes of it, and
+  // decompress up to read_ahead_size bytes past the end of sequential reads on a worker thread
+  // before they are requested. Must not be called while another thread is using the reader.
+  virtual void EnableReadAhead(u64 cache_size, u64 read_ahead_size) {}
+
+  // Lets readers of uncompressed files map the file into memory instead of reading it with system
+  // calls. If the storage fails while the file is mapped, the process crashes instead of the read
+  // failing, so this should only be used for reliable local storage. Must not be called while
+  // another thread is using the reader.
+  virtual void EnableMemoryMapping() {}
+
 protected:
   BlobReader() {}
 };
 
+struct ReadAheadStats
+{
+  // Chunks that were found in the cache, not counting read_ahead_hits
+  u64 hits = 0;
+  // First uses of chunks that were decompressed by the read-ahead thread
+  u64 read_ahead_hits = 0;
+  // Chunks that were being decompressed by the read-ahead thread when they were requested
+  u64 waits = 0;
+  // Chunks that had to be decompressed when they were requested
+  u64 misses = 0;
+  // Chunks that were decompressed by the read-ahead thread
+  u64 read_ahead = 0;
+  // Chunks that were decompressed by the read-ahead thread but evicted before being used
+  u64 wasted = 0;
+};
+
 // Provides caching and byte-operation-to-block-operations facilities.
 // Used for compressed blob and direct drive reading.
 // NOTE: GetDataSize() is expected to be evenly divisible by the sector size.
@@ -77,6 +107,9 @@ public:
 
   bool Read(u64 offset, u64 size, u8* out_ptr) override;
 
+  void EnableReadAhead(u64 cache_size, u64 read_ahead_size) override;
+  ReadAheadStats GetReadAheadStats() const;
+
 protected:
   void SetSectorSize(int blocksize);
   int GetSectorSize() const { return m_block_size; }
@@ -95,12 +128,23 @@ protected:
   // overridden in derived classes where possible.
   virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
 
+  // The read-ahead thread calls GetBlock, so derived classes must call this in their destructor.
+  void StopReadAhead();
+
+  // Held while calling GetBlock and ReadMultipleAlignedBlocks, which may happen on the read-ahead
+  // thread. Derived classes must hold it when they use the same state from anywhere else.
+  std::mutex m_read_mutex;
+
 private:
   struct Cache
   {
     std::vector<u8> data;
     u64 block_idx = 0;
     u32 num_blocks = 0;
+    // The chunk starting at block_idx is being read into data by another thread
+    bool pending = false;
+    // The data was read by the read-ahead thread and hasn't been used yet
+    bool read_ahead = false;
 
     // [Pseudo-] Least Recently Used Shift Register
     // When an empty cache line is needed, the line with the lowest value
@@ -113,6 +157,8 @@ private:
     {
       block_idx = 0;
       num_blocks = 0;
+      pending = false;
+      read_ahead = false;
       lru_sreg = 0;
     }
     void Fill(u64 block, u32 count)
@@ -126,22 +172,29 @@ private:
       MarkUsed();
     }
     bool Contains(u64 block) const { return block >= block_idx && block - block_idx < num_blocks; }
+    bool HoldsChunk(u64 first_block) const
+    {
+      return block_idx == first_block && (pending || num_blocks != 0);
+    }
     void MarkUsed() { lru_sreg |= 0x80000000; }
     void ShiftLRU() { lru_sreg >>= 1; }
     bool IsLessRecentlyUsedThan(const Cache& other) const { return lru_sreg < other.lru_sreg; }
   };
 
-  // Gets the cache line that contains the given block, or nullptr.
-  // NOTE: The cache record only lasts until it expires (next GetEmptyCacheLine)
-  const Cache* FindCacheLine(u64 block_num);
+  // Gets the cache line that holds or is being loaded with the given chunk, or nullptr.
+  // Must be called with m_cache_mutex held.
+  Cache* FindCacheLine(u64 chunk_num);
 
-  // Finds the least recently used cache line, resets and returns it.
+  // Finds the least recently used cache line that isn't being loaded, resets and returns it.
+  // Must be called with m_cache_mutex held.
   Cache* GetEmptyCacheLine();
 
   // Combines FindCacheLine with GetEmptyCacheLine and ReadChunk.
   // Always returns a valid cache line (loading the data if needed).
   // May return nullptr only if the cache missed and the read failed.
-  const Cache* GetCacheLine(u64 block_num);
+  // lock must hold m_cache_mutex. It is released while the chunk is being read.
+  // NOTE: The cache line only stays valid while lock is held.
+  const Cache* GetCacheLine(u64 block_num, std::unique_lock<std::mutex>& lock);
 
   // Read all bytes from a chunk of blocks into a buffer.
   // Returns the number of blocks read (may be less than m_chunk_blocks
@@ -149,10 +202,34 @@ private:
   // evenly divisible into chunks). Returns zero if it fails.
   u32 ReadChunk(u8* buffer, u64 chunk_num);
 
+  // Tracks sequential reads and moves the read-ahead window past the end of them.
+  // Must be called with m_cache_mutex held.
+  void UpdateReadAhead(u64 first_chunk, u64 last_chunk);
+  void ReadAheadThread();
+
   static constexpr int CACHE_LINES = 32;
+  // Number of consecutive sequential reads after which the read-ahead thread starts
+  static constexpr u32 SEQUENTIAL_READS_FOR_READ_AHEAD = 2;
+
   u32 m_block_size = 0;    // Bytes in a sector/block
   u32 m_chunk_blocks = 1;  // Number of sectors/blocks in a chunk
-  std::array<Cache, CACHE_LINES> m_cache;
+
+  // Protects the cache, the read-ahead state and the statistics
+  mutable std::mutex m_cache_mutex;
+  // Is notified when a pending cache line has been loaded
+  std::condition_variable m_cache_line_loaded;
+  std::vector<Cache> m_cache = std::vector<Cache>(CACHE_LINES);
+
+  std::thread m_read_ahead_thread;
+  std::condition_variable m_read_ahead_changed;
+  bool m_read_ahead_exiting = false;
+  u64 m_read_ahead_chunks = 0;  // Number of chunks to read ahead of sequential reads
+  u64 m_last_read_chunk = UINT64_MAX;
+  u32 m_sequential_reads = 0;
+  // The chunks in [m_read_ahead_next, m_read_ahead_end) are waiting to be read ahead
+  u64 m_read_ahead_next = 0;
+  u64 m_read_ahead_end = 0;
+  ReadAheadStats m_stats;
 };
 
 // Factory function - examines the path to choose the right type of BlobReader, and returns one.
@@ -8,10 +8,12 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,6 +29,7 @@
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
+#include "DiscIO/MultithreadedCompressor.h"
 #include "DiscIO/Volume.h"
 
 namespace DiscIO
@@ -71,6 +74,7 @@ std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+  StopReadAhead();
 }
 
 // IMPORTANT: Calling this function invalidates all earlier pointers gotten from this function.
@@ -153,6 +157,87 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
   return true;
 }
 
+namespace
+{
+struct GCZCompressState
+{
+  GCZCompressState() = default;
+  GCZCompressState(const GCZCompressState&) = delete;
+  GCZCompressState& operator=(const GCZCompressState&) = delete;
+  ~GCZCompressState()
+  {
+    if (z_initialized)
+      deflateEnd(&z);
+  }
+
+  z_stream z = {};
+  bool z_initialized = true;
+  std::vector<u8> out_buf;
+};
+
+struct GCZCompressParameters
+{
+  u32 block_index;
+  std::vector<u8> data;
+};
+
+struct GCZOutputParameters
+{
+  u32 block_index;
+  std::vector<u8> data;
+  bool compressed;
+};
+
+struct DecompressState
+{
+  std::unique_ptr<BlobReader> reader;
+};
+
+struct DecompressParameters
+{
+  u64 offset;
+  size_t size;
+};
+
+struct DecompressOutput
+{
+  std::vector<u8> data;
+};
+
+std::optional<GCZOutputParameters> CompressGCZBlock(GCZCompressState* state,
+                                                    GCZCompressParameters parameters,
+                                                    u32 block_size)
+{
+  z_stream& z = state->z;
+  state->out_buf.resize(block_size);
+
+  int retval = state->z_initialized ? deflateReset(&z) : Z_STREAM_ERROR;
+  z.next_in = parameters.data.data();
+  z.avail_in = block_size;
+  z.next_out = state->out_buf.data();
+  z.avail_out = block_size;
+
+  if (retval != Z_OK)
+  {
+    ERROR_LOG(DISCIO, "Deflate failed");
+    return std::nullopt;
+  }
+
+  int status = deflate(&z, Z_FINISH);
+  int comp_size = block_size - z.avail_out;
+
+  if ((status != Z_STREAM_END) || (z.avail_out < 10))
+  {
+    // let's store uncompressed
+    return GCZOutputParameters{parameters.block_index, std::move(parameters.data), false};
+  }
+
+  // let's store compressed
+  std::vector<u8> data(state->out_buf.begin(), state->out_buf.begin() + comp_size);
+  return GCZOutputParameters{parameters.block_index, std::move(data), true};
+}
+}  // Anonymous namespace
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type, int block_size, CompressCB callback, void* arg)
 {
@@ -196,10 +281,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     scrubbing = true;
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
-
   callback(Common::GetStringT("Files opened, ready to compress."), 0, arg);
 
   CompressedBlobHeader header;
@@ -213,8 +294,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -224,90 +303,76 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   infile.Seek(0, SEEK_SET);
 
   // Now we are ready to write compressed data!
-  u64 position = 0;
-  int num_compressed = 0;
-  int num_stored = 0;
+  std::atomic<u64> position{0};
   int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
   bool success = true;
 
-  for (u32 i = 0; i < header.num_blocks; i++)
-  {
-    if (i % progress_monitor == 0)
-    {
-      const u64 inpos = infile.Tell();
-      int ratio = 0;
-      if (inpos != 0)
-        ratio = (int)(100 * position / inpos);
-
-      const std::string temp =
-          StringFromFormat(Common::GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(), i,
-                           header.num_blocks, ratio);
-      bool was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
-      if (was_cancelled)
-      {
-        success = false;
-        break;
-      }
-    }
+  const auto set_up = [](GCZCompressState* state) {
+    if (deflateInit(&state->z, 9) != Z_OK)
+      state->z_initialized = false;
+  };
 
-    offsets[i] = position;
+  const auto compress = [&header](GCZCompressState* state, GCZCompressParameters parameters) {
+    return CompressGCZBlock(state, std::move(parameters), header.block_size);
+  };
 
-    size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
-
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
-
-    if (retval != Z_OK)
+  const auto output = [&](GCZOutputParameters parameters) {
+    if (!outfile.WriteBytes(parameters.data.data(), parameters.data.size()))
     {
-      ERROR_LOG(DISCIO, "Deflate failed");
-      success = false;
-      break;
+      PanicAlertT("Failed to write the output file \"%s\".\n"
+                  "Check that you have enough space available on the target drive.",
+                  outfile_path.c_str());
+      return false;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
+    offsets[parameters.block_index] = position | (parameters.compressed ? 0 : (1ULL << 63));
+    hashes[parameters.block_index] =
+        Common::HashAdler32(parameters.data.data(), parameters.data.size());
+    position += parameters.data.size();
+    return true;
+  };
 
-    u8* write_buf;
-    int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
-    {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-      // let's store uncompressed
-      write_buf = in_buf.data();
-      offsets[i] |= 0x8000000000000000ULL;
-      write_size = block_size;
-      num_stored++;
-    }
-    else
-    {
-      // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
-      num_compressed++;
-    }
+  {
+    MultithreadedCompressor<GCZCompressState, GCZCompressParameters, GCZOutputParameters>
+        compressor(set_up, compress, output);
 
-    if (!outfile.WriteBytes(write_buf, write_size))
+    for (u32 i = 0; i < header.num_blocks; i++)
     {
-      PanicAlertT("Failed to write the output file \"%s\".\n"
-                  "Check that you have enough space available on the target drive.",
-                  outfile_path.c_str());
-      success = false;
-      break;
-    }
+      if (i % progress_monitor == 0)
+      {
+        const u64 inpos = infile.Tell();
+        int ratio = 0;
+        if (inpos != 0)
+          ratio = (int)(100 * position / inpos);
+
+        const std::string temp =
+            StringFromFormat(Common::GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                             i, header.num_blocks, ratio);
+        bool was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
+        if (was_cancelled)
+        {
+          success = false;
+          break;
+        }
+      }
 
-    position += write_size;
+      std::vector<u8> in_buf(block_size);
+      size_t read_bytes;
+      if (scrubbing)
+        read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
+      else
+        infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
+      if (read_bytes < header.block_size)
+        std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+
+      if (!compressor.CompressAndWrite({i, std::move(in_buf)}))
+      {
+        success = false;
+        break;
+      }
+    }
 
-    hashes[i] = Common::HashAdler32(write_buf, write_size);
+    success = compressor.Finish() && success;
   }
 
   header.compressed_data_size = position;
@@ -327,9 +392,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     outfile.WriteArray(hashes.data(), header.num_blocks);
   }
 
-  // Cleanup
-  deflateEnd(&z);
-
   if (success)
   {
     callback(Common::GetStringT("Done compressing disc image."), 1.0f, arg);
@@ -340,21 +402,16 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 bool DecompressBlobToFile(const std::string& infile_path, const std::string& outfile_path,
                           CompressCB callback, void* arg)
 {
-  std::unique_ptr<CompressedBlobReader> reader;
+  std::unique_ptr<BlobReader> reader = CreateBlobReader(infile_path);
+  if (!reader)
   {
-    File::IOFile infile(infile_path, "rb");
-    if (!IsGCZBlob(infile))
-    {
-      PanicAlertT("File not compressed");
-      return false;
-    }
-
-    reader = CompressedBlobReader::Create(std::move(infile), infile_path);
+    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    return false;
   }
 
-  if (!reader)
+  if (reader->GetBlobType() != BlobType::GCZ && reader->GetBlobType() != BlobType::BCZ)
   {
-    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    PanicAlertT("File not compressed");
     return false;
   }
 
@@ -368,37 +425,68 @@ bool DecompressBlobToFile(const std::string& infile_path, const std::string& out
     return false;
   }
 
-  const CompressedBlobHeader& header = reader->GetHeader();
-  static const size_t BUFFER_BLOCKS = 32;
-  size_t buffer_size = header.block_size * BUFFER_BLOCKS;
-  size_t last_buffer_size = header.block_size * (header.num_blocks % BUFFER_BLOCKS);
-  std::vector<u8> buffer(buffer_size);
-  u32 num_buffers = (header.num_blocks + BUFFER_BLOCKS - 1) / BUFFER_BLOCKS;
-  int progress_monitor = std::max<int>(1, num_buffers / 100);
+  static const size_t BUFFER_SIZE = 0x200000;
+  const u64 data_size = reader->GetDataSize();
+  const u64 num_buffers = (data_size + BUFFER_SIZE - 1) / BUFFER_SIZE;
+  const u64 progress_monitor = std::max<u64>(1, num_buffers / 100);
   bool success = true;
 
-  for (u64 i = 0; i < num_buffers; i++)
-  {
-    if (i % progress_monitor == 0)
+  // BlobReaders aren't thread-safe, so each thread decompresses using a reader of its own
+  const auto set_up = [&infile_path](DecompressState* state) {
+    state->reader = CreateBlobReader(infile_path);
+  };
+
+  const auto decompress = [&infile_path](DecompressState* state,
+                                         DecompressParameters parameters) {
+    std::optional<DecompressOutput> result;
+    result.emplace();
+    result->data.resize(parameters.size);
+    if (!state->reader ||
+        !state->reader->Read(parameters.offset, parameters.size, result->data.data()))
     {
-      const bool was_cancelled =
-          !callback(Common::GetStringT("Unpacking"), (float)i / (float)num_buffers, arg);
-      if (was_cancelled)
-      {
-        success = false;
-        break;
-      }
+      PanicAlertT("Failed to read from the input file \"%s\".", infile_path.c_str());
+      result.reset();
     }
-    const size_t sz = i == num_buffers - 1 ? last_buffer_size : buffer_size;
-    reader->Read(i * buffer_size, sz, buffer.data());
-    if (!outfile.WriteBytes(buffer.data(), sz))
+    return result;
+  };
+
+  const auto output = [&](DecompressOutput parameters) {
+    if (!outfile.WriteBytes(parameters.data.data(), parameters.data.size()))
     {
       PanicAlertT("Failed to write the output file \"%s\".\n"
                   "Check that you have enough space available on the target drive.",
                   outfile_path.c_str());
-      success = false;
-      break;
+      return false;
     }
+    return true;
+  };
+
+  {
+    MultithreadedCompressor<DecompressState, DecompressParameters, DecompressOutput> decompressor(
+        set_up, decompress, output);
+
+    for (u64 i = 0; i < num_buffers; i++)
+    {
+      if (i % progress_monitor == 0)
+      {
+        const bool was_cancelled =
+            !callback(Common::GetStringT("Unpacking"), (float)i / (float)num_buffers, arg);
+        if (was_cancelled)
+        {
+          success = false;
+          break;
+        }
+      }
+      const size_t sz =
+          static_cast<size_t>(std::min<u64>(BUFFER_SIZE, data_size - i * BUFFER_SIZE));
+      if (!decompressor.CompressAndWrite({i * BUFFER_SIZE, sz}))
+      {
+        success = false;
+        break;
+      }
+    }
+
+    success = decompressor.Finish() && success;
   }
 
   if (!success)
@@ -407,10 +495,6 @@ bool DecompressBlobToFile(const std::string& infile_path, const std::string& out
     outfile.Close();
     File::Delete(outfile_path);
   }
-  else
-  {
-    outfile.Resize(header.data_size);
-  }
 
   return success;
 }
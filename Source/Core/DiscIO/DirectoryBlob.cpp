@@ -11,7 +11,6 @@
 #include <locale>
 #include <map>
 #include <memory>
-#include <set>
 #include <string>
 #include <utility>
 #include <variant>
@@ -60,6 +59,31 @@ constexpr u8 ENTRY_SIZE = 0x0c;
 constexpr u8 FILE_ENTRY = 0;
 constexpr u8 DIRECTORY_ENTRY = 1;
 
+File::IOFile* OpenFileCache::GetFile(const std::string& path)
+{
+  auto it = m_files.find(path);
+  if (it == m_files.end())
+  {
+    File::IOFile file(path, "rb");
+    if (!file)
+      return nullptr;
+
+    if (m_files.size() >= MAX_OPEN_FILES)
+    {
+      const auto least_recently_used =
+          std::min_element(m_files.begin(), m_files.end(), [](const auto& a, const auto& b) {
+            return a.second.last_used < b.second.last_used;
+          });
+      m_files.erase(least_recently_used);
+    }
+
+    it = m_files.emplace(path, OpenFile{std::move(file), 0}).first;
+  }
+
+  it->second.last_used = m_use_counter++;
+  return &it->second.file;
+}
+
 DiscContent::DiscContent(u64 offset, u64 size, const std::string& path)
     : m_offset(offset), m_size(size), m_content_source(path)
 {
@@ -89,7 +113,7 @@ u64 DiscContent::GetSize() const
   return m_size;
 }
 
-bool DiscContent::Read(u64* offset, u64* length, u8** buffer) const
+bool DiscContent::Read(u64* offset, u64* length, u8** buffer, OpenFileCache* file_cache) const
 {
   if (m_size == 0)
     return true;
@@ -103,10 +127,15 @@ bool DiscContent::Read(u64* offset, u64* length, u8** buffer) const
 
     if (std::holds_alternative<std::string>(m_content_source))
     {
-      File::IOFile file(std::get<std::string>(m_content_source), "rb");
-      file.Seek(offset_in_content, SEEK_SET);
-      if (!file.ReadBytes(*buffer, bytes_to_read))
+      File::IOFile* file = file_cache->GetFile(std::get<std::string>(m_content_source));
+      if (!file)
         return false;
+
+      if (!file->Seek(offset_in_content, SEEK_SET) || !file->ReadBytes(*buffer, bytes_to_read))
+      {
+        file->Clear();
+        return false;
+      }
     }
     else
     {
@@ -125,13 +154,25 @@ bool DiscContent::Read(u64* offset, u64* length, u8** buffer) const
 void DiscContentContainer::Add(u64 offset, u64 size, const std::string& path)
 {
   if (size != 0)
-    m_contents.emplace(offset, size, path);
+    Insert(DiscContent(offset, size, path));
 }
 
 void DiscContentContainer::Add(u64 offset, u64 size, const u8* data)
 {
   if (size != 0)
-    m_contents.emplace(offset, size, data);
+    Insert(DiscContent(offset, size, data));
+}
+
+void DiscContentContainer::Insert(DiscContent content)
+{
+  // Contents are mostly added in order, so this usually appends to the end
+  const auto it = std::lower_bound(m_contents.begin(), m_contents.end(), content);
+
+  // Like std::set, ignore contents that compare equal to an existing one
+  if (it != m_contents.end() && *it == content)
+    return;
+
+  m_contents.insert(it, std::move(content));
 }
 
 u64 DiscContentContainer::CheckSizeAndAdd(u64 offset, const std::string& path)
@@ -148,17 +189,18 @@ u64 DiscContentContainer::CheckSizeAndAdd(u64 offset, u64 max_size, const std::s
   return size;
 }
 
-bool DiscContentContainer::Read(u64 offset, u64 length, u8* buffer) const
+bool DiscContentContainer::Read(u64 offset, u64 length, u8* buffer,
+                                OpenFileCache* file_cache) const
 {
   // Determine which DiscContent the offset refers to
-  std::set<DiscContent>::const_iterator it = m_contents.upper_bound(DiscContent(offset));
+  auto it = std::upper_bound(m_contents.begin(), m_contents.end(), DiscContent(offset));
 
   while (it != m_contents.end() && length > 0)
   {
     // Zero fill to start of DiscContent data
     PadToAddress(it->GetOffset(), &offset, &length, &buffer);
 
-    if (!it->Read(&offset, &length, &buffer))
+    if (!it->Read(&offset, &length, &buffer, file_cache))
       return false;
 
     ++it;
@@ -377,7 +419,7 @@ bool DirectoryBlobReader::Read(u64 offset, u64 length, u8* buffer)
 {
   // TODO: We don't handle raw access to the encrypted area of Wii discs correctly.
   return (m_is_wii ? m_nonpartition_contents : m_gamecube_pseudopartition.GetContents())
-      .Read(offset, length, buffer);
+      .Read(offset, length, buffer, &m_open_files);
 }
 
 bool DirectoryBlobReader::SupportsReadWiiDecrypted() const
@@ -394,7 +436,7 @@ bool DirectoryBlobReader::ReadWiiDecrypted(u64 offset, u64 size, u8* buffer, u64
   if (it == m_partitions.end())
     return false;
 
-  return it->second.GetContents().Read(offset, size, buffer);
+  return it->second.GetContents().Read(offset, size, buffer, &m_open_files);
 }
 
 BlobType DirectoryBlobReader::GetBlobType() const
@@ -8,19 +8,19 @@
 #include <map>
 #include <memory>
 #include <optional>
-#include <set>
 #include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/File.h"
 #include "Common/FileUtil.h"
 #include "DiscIO/Blob.h"
 
 namespace File
 {
 struct FSTEntry;
-class IOFile;
 }  // namespace File
 
 namespace DiscIO
@@ -30,6 +30,27 @@ enum class PartitionType : u32;
 // Returns true if the path is inside a DirectoryBlob and doesn't represent the DirectoryBlob itself
 bool ShouldHideFromGameList(const std::string& volume_path);
 
+// Keeps the most recently read files open, so that games with many small files
+// don't need to open and close a file for every read.
+class OpenFileCache
+{
+public:
+  // Returns nullptr if the file can't be opened
+  File::IOFile* GetFile(const std::string& path);
+
+private:
+  static constexpr size_t MAX_OPEN_FILES = 64;
+
+  struct OpenFile
+  {
+    File::IOFile file;
+    u64 last_used;
+  };
+
+  std::unordered_map<std::string, OpenFile> m_files;
+  u64 m_use_counter = 0;
+};
+
 class DiscContent
 {
 public:
@@ -38,13 +59,13 @@ public:
   DiscContent(u64 offset, u64 size, const std::string& path);
   DiscContent(u64 offset, u64 size, const u8* data);
 
-  // Provided because it's convenient when searching for DiscContent in an std::set
+  // Provided because it's convenient when searching for DiscContent in a sorted std::vector
   explicit DiscContent(u64 offset);
 
   u64 GetOffset() const;
   u64 GetEndOffset() const;
   u64 GetSize() const;
-  bool Read(u64* offset, u64* length, u8** buffer) const;
+  bool Read(u64* offset, u64* length, u8** buffer, OpenFileCache* file_cache) const;
 
   bool operator==(const DiscContent& other) const { return GetEndOffset() == other.GetEndOffset(); }
   bool operator!=(const DiscContent& other) const { return !(*this == other); }
@@ -72,10 +93,13 @@ public:
   u64 CheckSizeAndAdd(u64 offset, const std::string& path);
   u64 CheckSizeAndAdd(u64 offset, u64 max_size, const std::string& path);
 
-  bool Read(u64 offset, u64 length, u8* buffer) const;
+  bool Read(u64 offset, u64 length, u8* buffer, OpenFileCache* file_cache) const;
 
 private:
-  std::set<DiscContent> m_contents;
+  void Insert(DiscContent content);
+
+  // Sorted by end offset, so that the content for an offset can be found with a binary search
+  std::vector<DiscContent> m_contents;
 };
 
 class DirectoryBlobPartition
@@ -184,6 +208,8 @@ private:
   std::vector<std::vector<u8>> m_partition_headers;
 
   u64 m_data_size;
+
+  OpenFileCache m_open_files;
 };
 
 }  // namespace DiscIO
@@ -35,7 +35,9 @@ bool ExportFile(const Volume& volume, const Partition& partition, const FileInfo
 bool ExportFile(const Volume& volume, const Partition& partition, std::string_view path,
                 const std::string& export_filename);
 
-// update_progress is called once for each child (file or directory).
+// update_progress is called once for each child (file or directory), always on the calling thread.
+// Directories are reported first, and then files in the order they are read, which is the order
+// they are stored on the disc. Files are written on worker threads while the next ones are read.
 // If update_progress returns true, the extraction gets cancelled.
 // filesystem_path is supposed to be the path corresponding to the directory argument.
 void ExportDirectory(const Volume& volume, const Partition& partition, const FileInfo& directory,
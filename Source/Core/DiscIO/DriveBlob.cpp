@@ -104,6 +104,8 @@ DriveReader::DriveReader(const std::string& drive)
 
 DriveReader::~DriveReader()
 {
+  StopReadAhead();
+
 #ifdef _WIN32
 #ifdef _LOCKDRIVE  // Do we want to lock the drive?
   // Unlock the disc in the CD-ROM drive.
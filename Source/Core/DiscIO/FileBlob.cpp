@@ -2,10 +2,21 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstdio>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "Common/Logging/Log.h"
 #include "DiscIO/FileBlob.h"
 
 namespace DiscIO
@@ -15,6 +26,11 @@ PlainFileReader::PlainFileReader(File::IOFile file) : m_file(std::move(file))
   m_size = m_file.GetSize();
 }
 
+PlainFileReader::~PlainFileReader()
+{
+  UnmapFile();
+}
+
 std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
 {
   if (file)
@@ -23,8 +39,66 @@ std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
   return nullptr;
 }
 
+void PlainFileReader::EnableMemoryMapping()
+{
+  if (m_mapped_data || m_size <= 0 || static_cast<u64>(m_size) > std::numeric_limits<size_t>::max())
+    return;
+
+#ifdef _WIN32
+  const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file.GetHandle())));
+  m_mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m_mapping_handle)
+  {
+    WARN_LOG(DISCIO, "Failed to create a file mapping: error %lu", GetLastError());
+    return;
+  }
+
+  m_mapped_data = static_cast<const u8*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  if (!m_mapped_data)
+  {
+    WARN_LOG(DISCIO, "Failed to map the file into memory: error %lu", GetLastError());
+    CloseHandle(m_mapping_handle);
+    m_mapping_handle = nullptr;
+  }
+#else
+  void* data = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_SHARED,
+                    fileno(m_file.GetHandle()), 0);
+  if (data == MAP_FAILED)
+  {
+    WARN_LOG(DISCIO, "Failed to map the file into memory");
+    return;
+  }
+
+  m_mapped_data = static_cast<const u8*>(data);
+#endif
+}
+
+void PlainFileReader::UnmapFile()
+{
+  if (!m_mapped_data)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_mapped_data);
+  CloseHandle(m_mapping_handle);
+  m_mapping_handle = nullptr;
+#else
+  munmap(const_cast<u8*>(m_mapped_data), static_cast<size_t>(m_size));
+#endif
+  m_mapped_data = nullptr;
+}
+
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
+  if (m_mapped_data)
+  {
+    if (offset > static_cast<u64>(m_size) || nbytes > static_cast<u64>(m_size) - offset)
+      return false;
+
+    std::copy_n(m_mapped_data + offset, nbytes, out_ptr);
+    return true;
+  }
+
   if (m_file.Seek(offset, SEEK_SET) && m_file.ReadBytes(out_ptr, nbytes))
   {
     return true;
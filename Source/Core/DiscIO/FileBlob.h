@@ -8,6 +8,10 @@
 #include <memory>
 #include <string>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
 #include "DiscIO/Blob.h"
@@ -18,6 +22,7 @@ class PlainFileReader : public BlobReader
 {
 public:
   static std::unique_ptr<PlainFileReader> Create(File::IOFile file);
+  ~PlainFileReader();
 
   BlobType GetBlobType() const override { return BlobType::PLAIN; }
   u64 GetRawSize() const override { return m_size; }
@@ -25,11 +30,26 @@ public:
   bool IsDataSizeAccurate() const override { return true; }
   bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
 
+  // Maps the whole file into memory, so that reads don't need any system calls.
+  // If this fails, the file is read with m_file instead.
+  // Read copies the data out of the mapping on the calling thread. Unlike with m_file, an I/O
+  // error during the copy (such as removable or network storage going away, or the file being
+  // truncated) can't be reported as a failed read, and raises SIGBUS (an access violation on
+  // Windows) instead.
+  void EnableMemoryMapping() override;
+
 private:
   PlainFileReader(File::IOFile file);
 
+  void UnmapFile();
+
   File::IOFile m_file;
   s64 m_size;
+
+  const u8* m_mapped_data = nullptr;
+#ifdef _WIN32
+  HANDLE m_mapping_handle = nullptr;
+#endif
 };
 
 }  // namespace DiscIO
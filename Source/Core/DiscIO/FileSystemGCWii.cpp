@@ -7,11 +7,11 @@
 #include <cstddef>
 #include <cstring>
 #include <locale>
-#include <map>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonFuncs.h"
@@ -28,6 +28,14 @@
 namespace DiscIO
 {
 constexpr u32 FST_ENTRY_SIZE = 4 * 3;  // An FST entry consists of three 32-bit integers
+// The number of path lookups after which building the path index is worth it
+constexpr u32 PATH_INDEX_THRESHOLD = 8;
+
+static void AppendLowercase(std::string* out, std::string_view str)
+{
+  for (char c : str)
+    out->push_back(std::tolower(c, std::locale::classic()));
+}
 
 // Set everything manually.
 FileInfoGCWii::FileInfoGCWii(const u8* fst, u8 offset_shift, u32 index, u32 total_file_infos)
@@ -157,6 +165,21 @@ bool FileInfoGCWii::NameCaseInsensitiveEquals(std::string_view other) const
   return *this_ptr == '\0';  // If we're not at a null byte, this is longer than other
 }
 
+std::string FileInfoGCWii::GetLowercaseName() const
+{
+  // Like NameCaseInsensitiveEquals, only convert from Shift-JIS starting at the first
+  // non-ASCII character, so that ASCII characters like ~ are kept as they are
+  const char* name = reinterpret_cast<const char*>(m_fst + GetNameOffset());
+  const char* non_ascii =
+      std::find_if(name, name + std::strlen(name), [](char c) { return c & 0x80; });
+
+  std::string result;
+  AppendLowercase(&result, std::string_view(name, non_ascii - name));
+  if (*non_ascii != '\0')
+    AppendLowercase(&result, SHIFTJISToUTF8(non_ascii));
+  return result;
+}
+
 std::string FileInfoGCWii::GetPath() const
 {
   // The root entry doesn't have a name
@@ -301,7 +324,47 @@ std::unique_ptr<FileInfo> FileSystemGCWii::FindFileInfo(std::string_view path) c
   if (!IsValid())
     return nullptr;
 
-  return FindFileInfo(path, m_root);
+  if (m_path_index.empty())
+  {
+    if (++m_path_lookups < PATH_INDEX_THRESHOLD)
+      return FindFileInfo(path, m_root);
+
+    m_path_index.emplace("", m_root);
+    BuildPathIndex(m_root, "");
+  }
+
+  std::string key;
+  key.reserve(path.size());
+  size_t name_start = path.find_first_not_of('/');
+  while (name_start != std::string::npos)
+  {
+    const size_t name_end = path.find('/', name_start);
+    if (!key.empty())
+      key.push_back('/');
+    AppendLowercase(&key, path.substr(name_start, name_end - name_start));
+    name_start = path.find_first_not_of('/', name_end);
+  }
+
+  const auto it = m_path_index.find(key);
+  if (it == m_path_index.end())
+    return nullptr;
+
+  return std::make_unique<FileInfoGCWii>(it->second);
+}
+
+void FileSystemGCWii::BuildPathIndex(const FileInfoGCWii& directory,
+                                     const std::string& directory_path) const
+{
+  for (const FileInfo& child : directory)
+  {
+    const FileInfoGCWii& child_gcwii = static_cast<const FileInfoGCWii&>(child);
+    const std::string path = directory_path + child_gcwii.GetLowercaseName();
+
+    // If several entries have the same path, the first one is used, like in the tree search
+    m_path_index.emplace(path, child_gcwii);
+    if (child.IsDirectory())
+      BuildPathIndex(child_gcwii, path + '/');
+  }
 }
 
 std::unique_ptr<FileInfo> FileSystemGCWii::FindFileInfo(std::string_view path,
@@ -342,8 +405,8 @@ std::unique_ptr<FileInfo> FileSystemGCWii::FindFileInfo(u64 disc_offset) const
   if (!IsValid())
     return nullptr;
 
-  // Build a cache (unless there already is one)
-  if (m_offset_file_info_cache.empty())
+  // Build an index (unless there already is one)
+  if (m_offset_index.empty())
   {
     u32 fst_entries = m_root.GetSize();
     for (u32 i = 0; i < fst_entries; i++)
@@ -353,22 +416,25 @@ std::unique_ptr<FileInfo> FileSystemGCWii::FindFileInfo(u64 disc_offset) const
       {
         const u32 size = file_info.GetSize();
         if (size != 0)
-          m_offset_file_info_cache.emplace(file_info.GetOffset() + size, i);
+          m_offset_index.push_back({file_info.GetOffset(), file_info.GetOffset() + size, i});
       }
     }
+
+    // If several files end at the same offset, the one with the lowest index comes first
+    std::stable_sort(m_offset_index.begin(), m_offset_index.end(),
+                     [](const FileRange& a, const FileRange& b) { return a.end < b.end; });
   }
 
   // Get the first file that ends after disc_offset
-  const auto it = m_offset_file_info_cache.upper_bound(disc_offset);
-  if (it == m_offset_file_info_cache.end())
-    return nullptr;
-  std::unique_ptr<FileInfo> result(std::make_unique<FileInfoGCWii>(m_root, it->second));
+  const auto it =
+      std::upper_bound(m_offset_index.begin(), m_offset_index.end(), disc_offset,
+                       [](u64 offset, const FileRange& range) { return offset < range.end; });
 
   // If the file's start isn't after disc_offset, success
-  if (result->GetOffset() <= disc_offset)
-    return result;
+  if (it == m_offset_index.end() || it->start > disc_offset)
+    return nullptr;
 
-  return nullptr;
+  return std::make_unique<FileInfoGCWii>(m_root, it->index);
 }
 
 }  // namespace DiscIO
@@ -5,11 +5,11 @@
 #pragma once
 
 #include <cstddef>
-#include <map>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -48,6 +48,9 @@ public:
   bool NameCaseInsensitiveEquals(std::string_view other) const override;
   std::string GetPath() const override;
 
+  // Returns the name in lowercase, in the form that NameCaseInsensitiveEquals compares against
+  std::string GetLowercaseName() const;
+
   bool IsValid(u64 fst_size, const FileInfoGCWii& parent_directory) const;
 
 protected:
@@ -96,13 +99,27 @@ public:
   std::unique_ptr<FileInfo> FindFileInfo(u64 disc_offset) const override;
 
 private:
+  struct FileRange
+  {
+    u64 start;
+    u64 end;
+    u32 index;  // FST index
+  };
+
   bool m_valid;
   std::vector<u8> m_file_system_table;
   FileInfoGCWii m_root;
-  // Maps the end offset of files to FST indexes
-  mutable std::map<u64, u32> m_offset_file_info_cache;
+
+  // Both indexes are built on demand. The path index is only built once there have been enough
+  // lookups to make up for the time it takes to build it, since most users only look up a few
+  // paths. Its keys are full paths in lowercase without leading, trailing or repeated slashes.
+  mutable u32 m_path_lookups = 0;
+  mutable std::unordered_map<std::string, FileInfoGCWii> m_path_index;
+  // Non-empty files, sorted by end offset
+  mutable std::vector<FileRange> m_offset_index;
 
   std::unique_ptr<FileInfo> FindFileInfo(std::string_view path, const FileInfo& file_info) const;
+  void BuildPathIndex(const FileInfoGCWii& directory, const std::string& directory_path) const;
 };
 
 }  // namespace DiscIO
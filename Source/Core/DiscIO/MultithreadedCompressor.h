@@ -0,0 +1,180 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Thread.h"
+
+// Runs the compression step of a disc image conversion on a pool of worker threads.
+//
+// The thread that converts the image reads the input and passes each piece of it to
+// CompressAndWrite. The pieces are compressed in parallel, and the results are passed to the
+// output function one at a time in the order they were submitted, so that the output can be
+// written sequentially. The number of pieces in flight is limited, which keeps memory usage
+// bounded and makes CompressAndWrite block when the workers can't keep up with the reader.
+
+namespace DiscIO
+{
+template <typename ThreadState, typename CompressParameters, typename OutputParameters>
+class MultithreadedCompressor
+{
+public:
+  // Called once on each worker thread before it compresses anything
+  using SetUpFunction = std::function<void(ThreadState*)>;
+  // Called on the worker threads. Returns nothing on failure
+  using CompressFunction =
+      std::function<std::optional<OutputParameters>(ThreadState*, CompressParameters)>;
+  // Called in submission order, never concurrently. Returns false on failure
+  using OutputFunction = std::function<bool(OutputParameters)>;
+
+  MultithreadedCompressor(SetUpFunction set_up, CompressFunction compress, OutputFunction output,
+                          size_t num_threads = GetDefaultThreadCount())
+      : m_set_up(std::move(set_up)), m_compress(std::move(compress)), m_output(std::move(output)),
+        m_max_in_flight(std::max<size_t>(num_threads, 1) * 2)
+  {
+    for (size_t i = 0; i < std::max<size_t>(num_threads, 1); ++i)
+      m_threads.emplace_back([this, i] { ThreadLoop(i); });
+  }
+
+  ~MultithreadedCompressor()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_shutdown = true;
+    }
+    m_queue_changed.notify_all();
+
+    for (std::thread& thread : m_threads)
+      thread.join();
+  }
+
+  MultithreadedCompressor(const MultithreadedCompressor&) = delete;
+  MultithreadedCompressor& operator=(const MultithreadedCompressor&) = delete;
+
+  // Queues up a piece of the input. Blocks if too many pieces are waiting to be written.
+  // Returns false if an earlier piece failed to be compressed or written.
+  bool CompressAndWrite(CompressParameters parameters)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_queue_changed.wait(lk, [this] { return m_failed || m_in_flight < m_max_in_flight; });
+    if (m_failed)
+      return false;
+
+    m_queue.emplace_back(m_next_index++, std::move(parameters));
+    ++m_in_flight;
+    lk.unlock();
+
+    m_queue_changed.notify_all();
+    return true;
+  }
+
+  // Waits until every queued piece has been written. Returns false if any of them failed.
+  bool Finish()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_queue_changed.wait(lk, [this] { return m_in_flight == 0; });
+    return !m_failed;
+  }
+
+  static size_t GetDefaultThreadCount()
+  {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+private:
+  void ThreadLoop(size_t thread_index)
+  {
+    Common::SetCurrentThreadName(("Compressor " + std::to_string(thread_index)).c_str());
+
+    ThreadState state{};
+    if (m_set_up)
+      m_set_up(&state);
+
+    while (true)
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_queue_changed.wait(lk, [this] { return m_shutdown || !m_queue.empty(); });
+      if (m_queue.empty())
+        return;
+
+      std::pair<u64, CompressParameters> item = std::move(m_queue.front());
+      m_queue.pop_front();
+      const bool skip = m_failed || m_shutdown;
+      lk.unlock();
+
+      // After a failure or cancellation, the remaining pieces are only drained
+      std::optional<OutputParameters> result;
+      if (!skip)
+        result = m_compress(&state, std::move(item.second));
+
+      Output(item.first, std::move(result));
+    }
+  }
+
+  void Output(u64 index, std::optional<OutputParameters> result)
+  {
+    std::lock_guard<std::mutex> output_lk(m_output_mutex);
+    m_results.emplace(index, std::move(result));
+
+    size_t num_written = 0;
+    bool failed = false;
+    for (auto it = m_results.find(m_next_output); it != m_results.end();
+         it = m_results.find(m_next_output))
+    {
+      if (!m_output_failed && (!it->second || !m_output(std::move(*it->second))))
+        m_output_failed = true;
+
+      failed |= m_output_failed;
+      m_results.erase(it);
+      ++m_next_output;
+      ++num_written;
+    }
+
+    if (num_written == 0)
+      return;
+
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_in_flight -= num_written;
+      m_failed |= failed;
+    }
+    m_queue_changed.notify_all();
+  }
+
+  SetUpFunction m_set_up;
+  CompressFunction m_compress;
+  OutputFunction m_output;
+  const size_t m_max_in_flight;
+  std::vector<std::thread> m_threads;
+
+  // Protects the input queue and the bookkeeping shared with the converting thread
+  std::mutex m_mutex;
+  std::condition_variable m_queue_changed;
+  std::deque<std::pair<u64, CompressParameters>> m_queue;
+  u64 m_next_index = 0;
+  size_t m_in_flight = 0;
+  bool m_failed = false;
+  bool m_shutdown = false;
+
+  // Protects the results waiting for the pieces before them to be written
+  std::mutex m_output_mutex;
+  std::map<u64, std::optional<OutputParameters>> m_results;
+  u64 m_next_output = 0;
+  bool m_output_failed = false;
+};
+
+}  // namespace DiscIO
@@ -0,0 +1,281 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/RedumpDatabase.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <pugixml.hpp>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/File.h"
+#include "Common/FileSearch.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Swap.h"
+
+namespace DiscIO
+{
+namespace
+{
+constexpr u32 INDEX_MAGIC = 0x49424452;  // "RDBI"
+constexpr u32 INDEX_VERSION = 1;
+
+// The index file consists of an IndexHeader, the entries and the name table.
+// It's only a cache, so it uses the byte order of the host.
+struct IndexHeader  // 48 bytes
+{
+  u32 magic;
+  u32 version;
+  u32 num_entries;
+  u32 names_size;
+  u64 dat_size;
+  std::array<u8, 20> dat_sha1;  // For noticing that the DAT file has changed
+  u32 reserved;
+};
+static_assert(sizeof(IndexHeader) == 48, "IndexHeader should be 48 bytes");
+
+template <size_t N>
+bool ParseHex(std::string_view str, std::array<u8, N>* out)
+{
+  if (str.size() != N * 2)
+    return false;
+
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    const char c = str[i];
+    u8 nibble;
+    if (c >= '0' && c <= '9')
+      nibble = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      nibble = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      nibble = c - 'A' + 10;
+    else
+      return false;
+
+    if (i % 2 == 0)
+      (*out)[i / 2] = nibble << 4;
+    else
+      (*out)[i / 2] |= nibble;
+  }
+
+  return true;
+}
+}  // Anonymous namespace
+
+std::unique_ptr<RedumpDatabase> RedumpDatabase::Load(const std::string& dat_directory,
+                                                     const std::string& index_directory)
+{
+  std::unique_ptr<RedumpDatabase> database(new RedumpDatabase);
+
+  for (const std::string& dat_path : Common::DoFileSearch({dat_directory}, {".dat"}))
+  {
+    std::string name;
+    SplitPath(dat_path, nullptr, &name, nullptr);
+
+    Index index;
+    if (LoadIndex(dat_path, index_directory + name + ".idx", &index))
+      database->m_indexes.push_back(std::move(index));
+  }
+
+  if (database->m_indexes.empty())
+    return nullptr;
+
+  return database;
+}
+
+std::unique_ptr<RedumpDatabase> RedumpDatabase::LoadFromUserDirectory()
+{
+  return Load(File::GetUserPath(D_REDUMP_IDX), File::GetUserPath(D_REDUMPCACHE_IDX));
+}
+
+size_t RedumpDatabase::GetEntryCount() const
+{
+  size_t count = 0;
+  for (const Index& index : m_indexes)
+    count += index.entries.size();
+  return count;
+}
+
+RedumpDatabase::Result RedumpDatabase::Lookup(const std::vector<u8>& crc32,
+                                              const std::vector<u8>& md5,
+                                              const std::vector<u8>& sha1) const
+{
+  const bool has_crc32 = crc32.size() == 4;
+  const bool has_md5 = md5.size() == 16;
+  const bool has_sha1 = sha1.size() == 20;
+  if (!has_crc32 && !has_md5 && !has_sha1)
+    return {};
+
+  const u32 crc32_value = has_crc32 ? Common::swap32(crc32.data()) : 0;
+
+  for (const Index& index : m_indexes)
+  {
+    auto begin = index.entries.begin();
+    auto end = index.entries.end();
+    if (has_crc32)
+    {
+      std::tie(begin, end) = std::equal_range(
+          begin, end, IndexEntry{crc32_value},
+          [](const IndexEntry& a, const IndexEntry& b) { return a.crc32 < b.crc32; });
+    }
+
+    for (auto it = begin; it != end; ++it)
+    {
+      if (has_md5 && !std::equal(md5.begin(), md5.end(), it->md5.begin()))
+        continue;
+      if (has_sha1 && !std::equal(sha1.begin(), sha1.end(), it->sha1.begin()))
+        continue;
+
+      return {Status::Match, std::string(index.names.data() + it->name_offset)};
+    }
+  }
+
+  return {};
+}
+
+bool RedumpDatabase::ParseDat(const std::string& dat, Index* index)
+{
+  pugi::xml_document doc;
+  const pugi::xml_parse_result result = doc.load_buffer(dat.data(), dat.size());
+  if (!result)
+  {
+    ERROR_LOG(DISCIO, "Failed to parse DAT file: %s", result.description());
+    return false;
+  }
+
+  for (const pugi::xml_node& game : doc.child("datafile").children("game"))
+  {
+    const std::string_view name = game.attribute("name").value();
+    const u32 name_offset = static_cast<u32>(index->names.size());
+    bool name_used = false;
+
+    for (const pugi::xml_node& rom : game.children("rom"))
+    {
+      IndexEntry entry;
+      std::array<u8, 4> crc32;
+      if (!ParseHex(rom.attribute("crc").value(), &crc32) ||
+          !ParseHex(rom.attribute("md5").value(), &entry.md5) ||
+          !ParseHex(rom.attribute("sha1").value(), &entry.sha1))
+      {
+        WARN_LOG(DISCIO, "Skipping a rom of \"%s\" with missing or malformed hashes",
+                 std::string(name).c_str());
+        continue;
+      }
+
+      entry.crc32 = Common::swap32(crc32.data());
+      entry.name_offset = name_offset;
+      index->entries.push_back(entry);
+      name_used = true;
+    }
+
+    if (name_used)
+    {
+      index->names.insert(index->names.end(), name.begin(), name.end());
+      index->names.push_back('\0');
+    }
+  }
+
+  std::stable_sort(index->entries.begin(), index->entries.end(),
+                   [](const IndexEntry& a, const IndexEntry& b) { return a.crc32 < b.crc32; });
+  return true;
+}
+
+bool RedumpDatabase::ReadIndexFile(const std::string& index_path, u64 dat_size,
+                                   const std::array<u8, 20>& dat_sha1, Index* index)
+{
+  File::IOFile file(index_path, "rb");
+  IndexHeader header;
+  if (!file.ReadArray(&header, 1) || header.magic != INDEX_MAGIC ||
+      header.version != INDEX_VERSION || header.dat_size != dat_size ||
+      header.dat_sha1 != dat_sha1)
+  {
+    return false;
+  }
+
+  const u64 expected_size =
+      sizeof(IndexHeader) + u64(header.num_entries) * sizeof(IndexEntry) + header.names_size;
+  if (file.GetSize() != expected_size)
+    return false;
+
+  index->entries.resize(header.num_entries);
+  index->names.resize(header.names_size);
+  if (!file.ReadArray(index->entries.data(), index->entries.size()) ||
+      !file.ReadArray(index->names.data(), index->names.size()))
+  {
+    return false;
+  }
+
+  // Make sure that every name can be read without going out of bounds
+  if (!index->names.empty() && index->names.back() != '\0')
+    return false;
+  return std::all_of(index->entries.begin(), index->entries.end(), [&](const IndexEntry& e) {
+    return e.name_offset < index->names.size();
+  });
+}
+
+void RedumpDatabase::WriteIndexFile(const std::string& index_path, u64 dat_size,
+                                    const std::array<u8, 20>& dat_sha1, const Index& index)
+{
+  IndexHeader header{};
+  header.magic = INDEX_MAGIC;
+  header.version = INDEX_VERSION;
+  header.num_entries = static_cast<u32>(index.entries.size());
+  header.names_size = static_cast<u32>(index.names.size());
+  header.dat_size = dat_size;
+  header.dat_sha1 = dat_sha1;
+
+  // Write to a temporary file first, so that an interrupted write can't leave a broken index
+  const std::string temp_path = index_path + ".tmp";
+  {
+    File::CreateFullPath(index_path);
+    File::IOFile file(temp_path, "wb");
+    if (!file.WriteArray(&header, 1) ||
+        !file.WriteArray(index.entries.data(), index.entries.size()) ||
+        !file.WriteArray(index.names.data(), index.names.size()))
+    {
+      ERROR_LOG(DISCIO, "Failed to write %s", temp_path.c_str());
+      file.Close();
+      File::Delete(temp_path);
+      return;
+    }
+  }
+
+  if (!File::Rename(temp_path, index_path))
+    ERROR_LOG(DISCIO, "Failed to rename %s to %s", temp_path.c_str(), index_path.c_str());
+}
+
+bool RedumpDatabase::LoadIndex(const std::string& dat_path, const std::string& index_path,
+                               Index* index)
+{
+  std::string dat;
+  if (!File::ReadFileToString(dat_path, dat))
+  {
+    ERROR_LOG(DISCIO, "Failed to read %s", dat_path.c_str());
+    return false;
+  }
+
+  const Common::SHA1::Digest dat_sha1 = Common::SHA1::CalculateDigest(dat);
+  if (ReadIndexFile(index_path, dat.size(), dat_sha1, index))
+    return true;
+
+  INFO_LOG(DISCIO, "Building an index of %s", dat_path.c_str());
+  *index = Index();
+  if (!ParseDat(dat, index))
+    return false;
+
+  WriteIndexFile(index_path, dat.size(), dat_sha1, *index);
+  return true;
+}
+
+}  // namespace DiscIO
@@ -0,0 +1,78 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Looks up the hashes of disc images in DAT files of the kind published by redump.org
+// (Logiqx XML, one <game> per disc with a <rom> carrying its size, CRC32, MD5 and SHA-1).
+//
+// Parsing a DAT file takes much longer than verifying that a dump matches it, so each DAT file
+// is converted into a compact binary index the first time it's loaded. The index is only rebuilt
+// when the DAT file changes. Its entries are sorted by CRC32, so that looking up a dump is a
+// binary search on the cheapest hash followed by comparing the few candidates' MD5 and SHA-1.
+
+namespace DiscIO
+{
+class RedumpDatabase final
+{
+public:
+  enum class Status
+  {
+    NoMatch,  // No entry has the given hashes
+    Match,    // An entry has all of the given hashes
+  };
+
+  struct Result
+  {
+    Status status = Status::NoMatch;
+    std::string name;  // The name of the matching game
+  };
+
+  // Loads every .dat file in dat_directory. The indexes are stored in index_directory.
+  // Both paths must end with a directory separator. Returns nullptr if no DAT file was loaded.
+  static std::unique_ptr<RedumpDatabase> Load(const std::string& dat_directory,
+                                              const std::string& index_directory);
+  // Loads the DAT files that the user has placed in User/Redump
+  static std::unique_ptr<RedumpDatabase> LoadFromUserDirectory();
+
+  size_t GetEntryCount() const;
+
+  // Hashes that weren't calculated should be empty. At least one hash must be given.
+  Result Lookup(const std::vector<u8>& crc32, const std::vector<u8>& md5,
+                const std::vector<u8>& sha1) const;
+
+private:
+  struct IndexEntry  // 44 bytes
+  {
+    u32 crc32;
+    u32 name_offset;  // Offset of the game's name in the name table
+    std::array<u8, 16> md5;
+    std::array<u8, 20> sha1;
+  };
+  static_assert(sizeof(IndexEntry) == 44, "IndexEntry should be 44 bytes");
+
+  struct Index
+  {
+    std::vector<IndexEntry> entries;  // Sorted by CRC32
+    std::vector<char> names;          // Null-terminated names
+  };
+
+  static bool ParseDat(const std::string& dat, Index* index);
+  static bool ReadIndexFile(const std::string& index_path, u64 dat_size,
+                            const std::array<u8, 20>& dat_sha1, Index* index);
+  static void WriteIndexFile(const std::string& index_path, u64 dat_size,
+                             const std::array<u8, 20>& dat_sha1, const Index& index);
+  static bool LoadIndex(const std::string& dat_path, const std::string& index_path, Index* index);
+
+  std::vector<Index> m_indexes;
+};
+
+}  // namespace DiscIO
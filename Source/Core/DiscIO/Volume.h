@@ -115,7 +115,11 @@ public:
   virtual Platform GetVolumeType() const = 0;
   virtual bool SupportsIntegrityCheck() const { return false; }
   virtual bool CheckH3TableIntegrity(const Partition& partition) const { return false; }
-  virtual bool CheckBlockIntegrity(u64 block_index, const std::vector<u8>& encrypted_data,
+  // Loads everything CheckBlockIntegrity needs for the partition, so that blocks of the partition
+  // can afterwards be checked from multiple threads at once
+  virtual void PrepareIntegrityChecks(const Partition& partition) const {}
+  // encrypted_data must point to a whole block, including its hashes
+  virtual bool CheckBlockIntegrity(u64 block_index, const u8* encrypted_data,
                                    const Partition& partition) const
   {
     return false;
@@ -132,6 +136,10 @@ public:
   virtual bool IsSizeAccurate() const = 0;
   // Size on disc (compressed size)
   virtual u64 GetRawSize() const = 0;
+  // See BlobReader::EnableReadAhead
+  virtual void EnableReadAhead(u64 cache_size, u64 read_ahead_size) {}
+  // See BlobReader::EnableMemoryMapping
+  virtual void EnableMemoryMapping() {}
 
 protected:
   template <u32 N>
@@ -190,6 +190,16 @@ u64 VolumeGC::GetRawSize() const
   return m_reader->GetRawSize();
 }
 
+void VolumeGC::EnableReadAhead(u64 cache_size, u64 read_ahead_size)
+{
+  m_reader->EnableReadAhead(cache_size, read_ahead_size);
+}
+
+void VolumeGC::EnableMemoryMapping()
+{
+  m_reader->EnableMemoryMapping();
+}
+
 std::optional<u8> VolumeGC::GetDiscNumber(const Partition& partition) const
 {
   return ReadSwapped<u8>(6, partition);
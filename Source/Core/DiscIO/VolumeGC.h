@@ -54,6 +54,8 @@ public:
   u64 GetSize() const override;
   bool IsSizeAccurate() const override;
   u64 GetRawSize() const override;
+  void EnableReadAhead(u64 cache_size, u64 read_ahead_size) override;
+  void EnableMemoryMapping() override;
 
 private:
   static const u32 GC_BANNER_WIDTH = 96;
@@ -11,15 +11,16 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
 #include <mbedtls/md5.h>
-#include <mbedtls/sha1.h>
 #include <zlib.h>
 
 #include "Common/Align.h"
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
@@ -45,17 +46,30 @@ constexpr u64 SL_DVD_R_SIZE = 4707319808;  // Wii RVT-R
 constexpr u64 DL_DVD_SIZE = 8511160320;    // Wii retail
 constexpr u64 DL_DVD_R_SIZE = 8543666176;  // Wii RVT-R
 
-constexpr u64 BLOCK_SIZE = 0x20000;
+// How much of the volume Process reads at once, unless a WAD content is in the way.
+// A multiple of VolumeWii::BLOCK_TOTAL_SIZE, so that aligned Wii blocks are never split
+constexpr u64 DEFAULT_READ_SIZE = 0x200000;
 
-VolumeVerifier::VolumeVerifier(const Volume& volume, Hashes<bool> hashes_to_calculate)
-    : m_volume(volume), m_hashes_to_calculate(hashes_to_calculate),
+// The smallest number of Wii blocks that is worth giving a thread of its own to check
+constexpr size_t MIN_BLOCKS_PER_THREAD = 4;
+
+VolumeVerifier::VolumeVerifier(const Volume& volume, Hashes<bool> hashes_to_calculate,
+                               const RedumpDatabase* redump_database)
+    : m_volume(volume), m_redump_database(redump_database),
+      m_hashes_to_calculate(hashes_to_calculate),
       m_calculating_any_hash(hashes_to_calculate.crc32 || hashes_to_calculate.md5 ||
                              hashes_to_calculate.sha1),
       m_max_progress(volume.GetSize())
 {
 }
 
-VolumeVerifier::~VolumeVerifier() = default;
+VolumeVerifier::~VolumeVerifier()
+{
+  // The async operations access members, so they must finish before anything is destroyed
+  WaitForAsyncOperations();
+  if (m_read_future.valid())
+    m_read_future.wait();
+}
 
 void VolumeVerifier::Start()
 {
@@ -76,6 +90,8 @@ void VolumeVerifier::Start()
   CheckMisc();
 
   SetUpHashing();
+
+  m_start_time = std::chrono::steady_clock::now();
 }
 
 void VolumeVerifier::CheckPartitions()
@@ -292,6 +308,7 @@ bool VolumeVerifier::CheckPartition(const Partition& partition)
       m_blocks.emplace_back(BlockToVerify{partition, offset, i});
 
     m_block_errors.emplace(partition, 0);
+    m_volume.PrepareIntegrityChecks(partition);
   }
 
   return true;
@@ -664,9 +681,96 @@ void VolumeVerifier::SetUpHashing()
 
   if (m_hashes_to_calculate.sha1)
   {
-    mbedtls_sha1_init(&m_sha1_context);
-    mbedtls_sha1_starts_ret(&m_sha1_context);
+    m_sha1_context = Common::SHA1::CreateContext();
+  }
+}
+
+u64 VolumeVerifier::GetBytesToRead() const
+{
+  u64 bytes_to_read = DEFAULT_READ_SIZE;
+  if (m_content_index < m_content_offsets.size() &&
+      m_content_offsets[m_content_index] == m_progress)
+  {
+    IOS::ES::Content content{};
+    m_volume.GetTMD(PARTITION_NONE).GetContent(m_content_index, &content);
+    bytes_to_read = Common::AlignUp(content.size, 0x40);
+  }
+  else if (m_content_index < m_content_offsets.size() &&
+           m_content_offsets[m_content_index] > m_progress)
+  {
+    bytes_to_read = std::min(bytes_to_read, m_content_offsets[m_content_index] - m_progress);
+  }
+  bytes_to_read = std::min(bytes_to_read, m_max_progress - m_progress);
+
+  // Don't split a Wii block between two chunks. This only matters for misaligned partitions
+  size_t block_index = m_block_index;
+  while (block_index + 1 < m_blocks.size() &&
+         m_blocks[block_index + 1].offset < m_progress + bytes_to_read)
+  {
+    block_index++;
+  }
+  if (block_index < m_blocks.size())
+  {
+    const u64 block_offset = m_blocks[block_index].offset;
+    if (block_offset > m_progress && block_offset < m_progress + bytes_to_read &&
+        block_offset + VolumeWii::BLOCK_TOTAL_SIZE > m_progress + bytes_to_read)
+    {
+      bytes_to_read = block_offset - m_progress;
+    }
+  }
+
+  return bytes_to_read;
+}
+
+bool VolumeVerifier::IsDataNeeded(u64 bytes_to_read) const
+{
+  if (m_calculating_any_hash)
+    return true;
+
+  if (m_content_index < m_content_offsets.size() &&
+      m_content_offsets[m_content_index] == m_progress)
+  {
+    return true;
   }
+
+  return m_block_index < m_blocks.size() &&
+         m_blocks[m_block_index].offset < m_progress + bytes_to_read;
+}
+
+std::optional<std::vector<u8>> VolumeVerifier::ReadChunk(u64 offset, u64 size)
+{
+  if (m_read_future.valid())
+  {
+    std::optional<std::vector<u8>> data = m_read_future.get();
+    if (m_read_future_offset == offset && m_read_future_size == size)
+      return data;
+  }
+
+  std::vector<u8> data(size);
+  std::lock_guard lk(m_volume_mutex);
+  if (!m_volume.Read(offset, size, data.data(), PARTITION_NONE))
+    return std::nullopt;
+  return data;
+}
+
+void VolumeVerifier::StartReadingNextChunk()
+{
+  if (m_progress == m_max_progress)
+    return;
+
+  const u64 bytes_to_read = GetBytesToRead();
+  if (!IsDataNeeded(bytes_to_read))
+    return;
+
+  m_read_future_offset = m_progress;
+  m_read_future_size = bytes_to_read;
+  m_read_future = std::async(std::launch::async, [this, offset = m_progress, bytes_to_read] {
+    std::vector<u8> data(bytes_to_read);
+    std::lock_guard lk(m_volume_mutex);
+    if (!m_volume.Read(offset, bytes_to_read, data.data(), PARTITION_NONE))
+      return std::optional<std::vector<u8>>();
+    return std::optional<std::vector<u8>>(std::move(data));
+  });
 }
 
 void VolumeVerifier::WaitForAsyncOperations() const
@@ -679,22 +783,76 @@ void VolumeVerifier::WaitForAsyncOperations() const
     m_sha1_future.wait();
   if (m_content_future.valid())
     m_content_future.wait();
-  if (m_block_future.valid())
-    m_block_future.wait();
+  for (const std::future<void>& future : m_block_futures)
+    future.wait();
+}
+
+void VolumeVerifier::StartBlockChecks(size_t blocks_end, bool read_succeeded)
+{
+  const size_t num_blocks = blocks_end - m_block_index;
+  m_block_results_start = m_block_index;
+  m_block_results.assign(num_blocks, 0);
+  m_block_futures.clear();
+
+  // Checking a block doesn't modify the volume, and everything it evaluates lazily was loaded by
+  // PrepareIntegrityChecks in CheckPartition, so blocks can be checked in parallel
+  auto check_blocks = [this, read_succeeded, progress = m_progress](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i)
+    {
+      const BlockToVerify& block = m_blocks[m_block_results_start + i];
+      bool success;
+      if (read_succeeded && block.offset >= progress &&
+          block.offset + VolumeWii::BLOCK_TOTAL_SIZE <= progress + m_data.size())
+      {
+        success = m_volume.CheckBlockIntegrity(
+            block.block_index, m_data.data() + (block.offset - progress), block.partition);
+      }
+      else
+      {
+        std::lock_guard lk(m_volume_mutex);
+        success = m_volume.CheckBlockIntegrity(block.block_index, block.partition);
+      }
+      m_block_results[i] = success;
+    }
+  };
+
+  const size_t num_threads = std::clamp<size_t>(num_blocks / MIN_BLOCKS_PER_THREAD, 1,
+                                                std::max(std::thread::hardware_concurrency(), 1u));
+  for (size_t thread = 0; thread < num_threads; ++thread)
+  {
+    const size_t start = num_blocks * thread / num_threads;
+    const size_t end = num_blocks * (thread + 1) / num_threads;
+    m_block_futures.emplace_back(std::async(std::launch::async, check_blocks, start, end));
+  }
 }
 
-bool VolumeVerifier::ReadChunkAndWaitForAsyncOperations(u64 bytes_to_read)
+void VolumeVerifier::ProcessBlockResults()
 {
-  std::vector<u8> data(bytes_to_read);
+  for (size_t i = 0; i < m_block_results.size(); ++i)
   {
-    std::lock_guard lk(m_volume_mutex);
-    if (!m_volume.Read(m_progress, bytes_to_read, data.data(), PARTITION_NONE))
-      return false;
+    const BlockToVerify& block = m_blocks[m_block_results_start + i];
+    if (m_block_results[i])
+    {
+      m_biggest_verified_offset =
+          std::max(m_biggest_verified_offset, block.offset + VolumeWii::BLOCK_TOTAL_SIZE);
+    }
+    else
+    {
+      if (m_scrubber.CanBlockBeScrubbed(block.offset))
+      {
+        WARN_LOG(DISCIO, "Integrity check failed for unused block at 0x%" PRIx64, block.offset);
+        m_unused_block_errors[block.partition]++;
+      }
+      else
+      {
+        WARN_LOG(DISCIO, "Integrity check failed for block at 0x%" PRIx64, block.offset);
+        m_block_errors[block.partition]++;
+      }
+    }
   }
 
-  WaitForAsyncOperations();
-  m_data = std::move(data);
-  return true;
+  m_block_results.clear();
+  m_block_futures.clear();
 }
 
 void VolumeVerifier::Process()
@@ -707,33 +865,28 @@ void VolumeVerifier::Process()
 
   IOS::ES::Content content{};
   bool content_read = false;
-  bool block_read = false;
-  u64 bytes_to_read = BLOCK_SIZE;
   if (m_content_index < m_content_offsets.size() &&
       m_content_offsets[m_content_index] == m_progress)
   {
     m_volume.GetTMD(PARTITION_NONE).GetContent(m_content_index, &content);
-    bytes_to_read = Common::AlignUp(content.size, 0x40);
     content_read = true;
   }
-  else if (m_content_index < m_content_offsets.size() &&
-           m_content_offsets[m_content_index] > m_progress)
-  {
-    bytes_to_read = std::min(bytes_to_read, m_content_offsets[m_content_index] - m_progress);
-  }
-  else if (m_block_index < m_blocks.size() && m_blocks[m_block_index].offset == m_progress)
-  {
-    bytes_to_read = VolumeWii::BLOCK_TOTAL_SIZE;
-    block_read = true;
-  }
-  else if (m_block_index < m_blocks.size() && m_blocks[m_block_index].offset > m_progress)
-  {
-    bytes_to_read = std::min(bytes_to_read, m_blocks[m_block_index].offset - m_progress);
-  }
-  bytes_to_read = std::min(bytes_to_read, m_max_progress - m_progress);
 
-  const bool is_data_needed = m_calculating_any_hash || content_read || block_read;
-  const bool read_succeeded = is_data_needed && ReadChunkAndWaitForAsyncOperations(bytes_to_read);
+  const u64 bytes_to_read = GetBytesToRead();
+  size_t blocks_end = m_block_index;
+  while (blocks_end < m_blocks.size() && m_blocks[blocks_end].offset < m_progress + bytes_to_read)
+    blocks_end++;
+
+  std::optional<std::vector<u8>> data;
+  if (IsDataNeeded(bytes_to_read))
+    data = ReadChunk(m_progress, bytes_to_read);
+  const bool read_succeeded = data.has_value();
+
+  // The operations started for the previous chunk must be done with m_data before it's replaced
+  WaitForAsyncOperations();
+  ProcessBlockResults();
+  if (read_succeeded)
+    m_data = std::move(*data);
 
   if (m_calculating_any_hash)
   {
@@ -762,7 +915,7 @@ void VolumeVerifier::Process()
       if (m_hashes_to_calculate.sha1)
       {
         m_sha1_future = std::async(std::launch::async, [this] {
-          mbedtls_sha1_update_ret(&m_sha1_context, m_data.data(), m_data.size());
+          m_sha1_context->Update(m_data);
         });
       }
     }
@@ -782,61 +935,15 @@ void VolumeVerifier::Process()
     m_content_index++;
   }
 
-  if (m_block_index < m_blocks.size() &&
-      m_blocks[m_block_index].offset < m_progress + bytes_to_read)
+  if (blocks_end != m_block_index)
   {
-    m_md5_future = std::async(
-        std::launch::async,
-        [this, read_succeeded, bytes_to_read](size_t block_index, u64 progress) {
-          while (block_index < m_blocks.size() &&
-                 m_blocks[block_index].offset < progress + bytes_to_read)
-          {
-            bool success;
-            if (m_blocks[block_index].offset == progress)
-            {
-              success = read_succeeded &&
-                        m_volume.CheckBlockIntegrity(m_blocks[block_index].block_index, m_data,
-                                                     m_blocks[block_index].partition);
-            }
-            else
-            {
-              std::lock_guard lk(m_volume_mutex);
-              success = m_volume.CheckBlockIntegrity(m_blocks[block_index].block_index,
-                                                     m_blocks[block_index].partition);
-            }
-
-            const u64 offset = m_blocks[block_index].offset;
-            if (success)
-            {
-              m_biggest_verified_offset =
-                  std::max(m_biggest_verified_offset, offset + VolumeWii::BLOCK_TOTAL_SIZE);
-            }
-            else
-            {
-              if (m_scrubber.CanBlockBeScrubbed(offset))
-              {
-                WARN_LOG(DISCIO, "Integrity check failed for unused block at 0x%" PRIx64, offset);
-                m_unused_block_errors[m_blocks[block_index].partition]++;
-              }
-              else
-              {
-                WARN_LOG(DISCIO, "Integrity check failed for block at 0x%" PRIx64, offset);
-                m_block_errors[m_blocks[block_index].partition]++;
-              }
-            }
-            block_index++;
-          }
-        },
-        m_block_index, m_progress);
-
-    while (m_block_index < m_blocks.size() &&
-           m_blocks[m_block_index].offset < m_progress + bytes_to_read)
-    {
-      m_block_index++;
-    }
+    StartBlockChecks(blocks_end, read_succeeded);
+    m_block_index = blocks_end;
   }
 
   m_progress += bytes_to_read;
+
+  StartReadingNextChunk();
 }
 
 u64 VolumeVerifier::GetBytesProcessed() const
@@ -849,6 +956,16 @@ u64 VolumeVerifier::GetTotalBytes() const
   return m_max_progress;
 }
 
+u64 VolumeVerifier::GetBytesPerSecond() const
+{
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - m_start_time);
+  if (elapsed.count() <= 0)
+    return 0;
+
+  return m_progress * 1000 / static_cast<u64>(elapsed.count());
+}
+
 void VolumeVerifier::Finish()
 {
   if (m_done)
@@ -856,6 +973,10 @@ void VolumeVerifier::Finish()
   m_done = true;
 
   WaitForAsyncOperations();
+  ProcessBlockResults();
+
+  INFO_LOG(DISCIO, "Verified 0x%" PRIx64 " bytes at %" PRIu64 " MB/s", m_progress,
+           GetBytesPerSecond() / 1000000);
 
   ASSERT(m_content_index == m_content_offsets.size());
   ASSERT(m_block_index == m_blocks.size());
@@ -878,8 +999,15 @@ void VolumeVerifier::Finish()
 
     if (m_hashes_to_calculate.sha1)
     {
-      m_result.hashes.sha1 = std::vector<u8>(20);
-      mbedtls_sha1_finish_ret(&m_sha1_context, m_result.hashes.sha1.data());
+      const Common::SHA1::Digest digest = m_sha1_context->Finish();
+      m_result.hashes.sha1 = std::vector<u8>(digest.begin(), digest.end());
+    }
+
+    // Redump only has entries for discs
+    if (m_redump_database && IsDisc(m_volume.GetVolumeType()))
+    {
+      m_result.redump = m_redump_database->Lookup(m_result.hashes.crc32, m_result.hashes.md5,
+                                                   m_result.hashes.sha1);
     }
   }
 
@@ -991,6 +1119,23 @@ void VolumeVerifier::Finish()
         Common::GetStringT("\n\nBecause this title is not for retail Wii consoles, "
                            "Dolphin cannot verify that it hasn't been tampered with.");
   }
+
+  if (m_result.redump)
+  {
+    if (m_result.redump->status == RedumpDatabase::Status::Match)
+    {
+      m_result.summary_text += StringFromFormat(
+          Common::GetStringT("\n\nThe hashes of this disc image match the good dump \"%s\".")
+              .c_str(),
+          m_result.redump->name.c_str());
+    }
+    else
+    {
+      m_result.summary_text +=
+          Common::GetStringT("\n\nThe hashes of this disc image don't match any good dump "
+                             "in the loaded Redump DAT files.");
+    }
+  }
 }
 
 const VolumeVerifier::Result& VolumeVerifier::GetResult() const
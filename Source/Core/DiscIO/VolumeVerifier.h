@@ -4,19 +4,22 @@
 
 #pragma once
 
+#include <chrono>
 #include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include <mbedtls/md5.h>
-#include <mbedtls/sha1.h>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/SHA1.h"
 #include "Core/IOS/ES/Formats.h"
 #include "DiscIO/DiscScrubber.h"
+#include "DiscIO/RedumpDatabase.h"
 #include "DiscIO/Volume.h"
 
 // To be used as follows:
@@ -30,6 +33,10 @@
 //
 // Start, Process and Finish may take some time to run.
 //
+// While Process hashes and checks one chunk of the volume on worker threads, the next chunk is
+// read in the background, so the speed of verification is limited by the slowest of reading and
+// the individual hash algorithms rather than by their sum.
+//
 // GetResult() can be called before the processing is finished, but the result will be incomplete.
 
 namespace DiscIO
@@ -64,17 +71,23 @@ public:
   struct Result
   {
     Hashes<std::vector<u8>> hashes;
+    // Only set if a Redump database was given and at least one hash was calculated
+    std::optional<RedumpDatabase::Result> redump;
     std::string summary_text;
     std::vector<Problem> problems;
   };
 
-  VolumeVerifier(const Volume& volume, Hashes<bool> hashes_to_calculate);
+  // The Redump database is optional and must outlive the VolumeVerifier
+  VolumeVerifier(const Volume& volume, Hashes<bool> hashes_to_calculate,
+                 const RedumpDatabase* redump_database = nullptr);
   ~VolumeVerifier();
 
   void Start();
   void Process();
   u64 GetBytesProcessed() const;
   u64 GetTotalBytes() const;
+  // Average processing speed since Start returned
+  u64 GetBytesPerSecond() const;
   void Finish();
   const Result& GetResult() const;
 
@@ -100,12 +113,18 @@ private:
   u64 GetBiggestReferencedOffset(const FileInfo& file_info) const;
   void CheckMisc();
   void SetUpHashing();
+  u64 GetBytesToRead() const;
+  bool IsDataNeeded(u64 bytes_to_read) const;
+  std::optional<std::vector<u8>> ReadChunk(u64 offset, u64 size);
+  void StartReadingNextChunk();
   void WaitForAsyncOperations() const;
-  bool ReadChunkAndWaitForAsyncOperations(u64 bytes_to_read);
+  void StartBlockChecks(size_t blocks_end, bool read_succeeded);
+  void ProcessBlockResults();
 
   void AddProblem(Severity severity, std::string text);
 
   const Volume& m_volume;
+  const RedumpDatabase* m_redump_database;
   Result m_result;
   bool m_is_tgc = false;
   bool m_is_datel = false;
@@ -115,7 +134,7 @@ private:
   bool m_calculating_any_hash = false;
   unsigned long m_crc32_context = 0;
   mbedtls_md5_context m_md5_context;
-  mbedtls_sha1_context m_sha1_context;
+  std::unique_ptr<Common::SHA1::Context> m_sha1_context;
 
   std::vector<u8> m_data;
   std::mutex m_volume_mutex;
@@ -123,7 +142,17 @@ private:
   std::future<void> m_md5_future;
   std::future<void> m_sha1_future;
   std::future<void> m_content_future;
-  std::future<void> m_block_future;
+
+  // The chunk after the one in m_data, which is read while m_data is being processed
+  std::future<std::optional<std::vector<u8>>> m_read_future;
+  u64 m_read_future_offset = 0;
+  u64 m_read_future_size = 0;
+
+  // The Wii blocks of m_data are checked in parallel. Each future writes the results of its own
+  // range of m_block_results, which holds the results for m_blocks[m_block_results_start] onwards
+  std::vector<std::future<void>> m_block_futures;
+  std::vector<u8> m_block_results;
+  size_t m_block_results_start = 0;
 
   DiscScrubber m_scrubber;
   IOS::ES::TicketReader m_ticket;
@@ -141,6 +170,7 @@ private:
   bool m_done = false;
   u64 m_progress = 0;
   u64 m_max_progress = 0;
+  std::chrono::steady_clock::time_point m_start_time;
 };
 
 }  // namespace DiscIO
@@ -13,12 +13,11 @@
 #include <utility>
 #include <vector>
 
-#include <mbedtls/aes.h>
-#include <mbedtls/sha1.h>
-
 #include "Common/Align.h"
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
@@ -159,21 +158,18 @@ bool VolumeWAD::CheckContentIntegrity(const IOS::ES::Content& content,
   if (encrypted_data.size() != Common::AlignUp(content.size, 0x40))
     return false;
 
-  mbedtls_aes_context context;
   const std::array<u8, 16> key = ticket.GetTitleKey();
-  mbedtls_aes_setkey_dec(&context, key.data(), 128);
+  const std::unique_ptr<Common::AES::Context> context =
+      Common::AES::CreateContextDecrypt(key.data());
 
   std::array<u8, 16> iv{};
   iv[0] = static_cast<u8>(content.index >> 8);
   iv[1] = static_cast<u8>(content.index & 0xFF);
 
   std::vector<u8> decrypted_data(encrypted_data.size());
-  mbedtls_aes_crypt_cbc(&context, MBEDTLS_AES_DECRYPT, decrypted_data.size(), iv.data(),
-                        encrypted_data.data(), decrypted_data.data());
+  context->Crypt(iv.data(), encrypted_data.data(), decrypted_data.data(), decrypted_data.size());
 
-  std::array<u8, 20> sha1;
-  mbedtls_sha1_ret(decrypted_data.data(), content.size, sha1.data());
-  return sha1 == content.sha1;
+  return Common::SHA1::CalculateDigest(decrypted_data.data(), content.size) == content.sha1;
 }
 
 bool VolumeWAD::CheckContentIntegrity(const IOS::ES::Content& content, u64 content_offset,
@@ -9,8 +9,6 @@
 #include <cstddef>
 #include <cstring>
 #include <map>
-#include <mbedtls/aes.h>
-#include <mbedtls/sha1.h>
 #include <memory>
 #include <optional>
 #include <string>
@@ -19,6 +17,8 @@
 
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/Swap.h"
@@ -122,14 +122,12 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
         return h3_table;
       };
 
-      auto get_key = [this, partition]() -> std::unique_ptr<mbedtls_aes_context> {
+      auto get_key = [this, partition]() -> std::unique_ptr<Common::AES::Context> {
         const IOS::ES::TicketReader& ticket = *m_partitions[partition].ticket;
         if (!ticket.IsValid())
           return nullptr;
         const std::array<u8, 16> key = ticket.GetTitleKey();
-        std::unique_ptr<mbedtls_aes_context> aes_context = std::make_unique<mbedtls_aes_context>();
-        mbedtls_aes_setkey_dec(aes_context.get(), key.data(), 128);
-        return aes_context;
+        return Common::AES::CreateContextDecrypt(key.data());
       };
 
       auto get_file_system = [this, partition]() -> std::unique_ptr<FileSystem> {
@@ -142,7 +140,7 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
       };
 
       m_partitions.emplace(
-          partition, PartitionDetails{Common::Lazy<std::unique_ptr<mbedtls_aes_context>>(get_key),
+          partition, PartitionDetails{Common::Lazy<std::unique_ptr<Common::AES::Context>>(get_key),
                                       Common::Lazy<IOS::ES::TicketReader>(get_ticket),
                                       Common::Lazy<IOS::ES::TMDReader>(get_tmd),
                                       Common::Lazy<std::vector<u8>>(get_cert_chain),
@@ -176,47 +174,69 @@ bool VolumeWii::Read(u64 offset, u64 length, u8* buffer, const Partition& partit
   if (m_reader->SupportsReadWiiDecrypted())
     return m_reader->ReadWiiDecrypted(offset, length, buffer, partition.offset);
 
-  mbedtls_aes_context* aes_context = partition_details.key->get();
+  const Common::AES::Context* aes_context = partition_details.key->get();
   if (!aes_context)
     return false;
 
-  std::vector<u8> read_buffer(BLOCK_TOTAL_SIZE);
+  const u64 partition_data_offset = partition.offset + *partition_details.data_offset;
+  std::vector<u8> read_buffer;
   while (length > 0)
   {
     // Calculate offsets
-    u64 block_offset_on_disc = partition.offset + *partition_details.data_offset +
-                               offset / BLOCK_DATA_SIZE * BLOCK_TOTAL_SIZE;
+    u64 block_offset_on_disc = partition_data_offset + offset / BLOCK_DATA_SIZE * BLOCK_TOTAL_SIZE;
     u64 data_offset_in_block = offset % BLOCK_DATA_SIZE;
 
-    if (m_last_decrypted_block != block_offset_on_disc)
+    if (m_last_decrypted_block == block_offset_on_disc)
     {
-      // Read the current block
-      if (!m_reader->Read(block_offset_on_disc, BLOCK_TOTAL_SIZE, read_buffer.data()))
-        return false;
-
-      // Decrypt the block's data.
-      // 0x3D0 - 0x3DF in read_buffer will be overwritten,
-      // but that won't affect anything, because we won't
-      // use the content of read_buffer anymore after this
-      mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_DATA_SIZE, &read_buffer[0x3D0],
-                            &read_buffer[BLOCK_HEADER_SIZE], m_last_decrypted_block_data);
-      m_last_decrypted_block = block_offset_on_disc;
+      const u64 copy_size = std::min(length, BLOCK_DATA_SIZE - data_offset_in_block);
+      memcpy(buffer, &m_last_decrypted_block_data[data_offset_in_block],
+             static_cast<size_t>(copy_size));
 
+      length -= copy_size;
+      buffer += copy_size;
+      offset += copy_size;
+      continue;
+    }
+
+    // Read all the blocks that the rest of the read covers at once (up to a limit), so that
+    // large reads don't have to go through the blob reader one block at a time
+    const u64 blocks_left = (data_offset_in_block + length + BLOCK_DATA_SIZE - 1) / BLOCK_DATA_SIZE;
+    const size_t num_blocks = static_cast<size_t>(std::min<u64>(blocks_left, MAX_BLOCKS_PER_READ));
+    read_buffer.resize(num_blocks * BLOCK_TOTAL_SIZE);
+    if (!m_reader->Read(block_offset_on_disc, read_buffer.size(), read_buffer.data()))
+      return false;
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
       // The only thing we currently use from the 0x000 - 0x3FF part
       // of the block is the IV (at 0x3D0), but it also contains SHA-1
       // hashes that IOS uses to check that discs aren't tampered with.
       // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+      const u8* block = read_buffer.data() + i * BLOCK_TOTAL_SIZE;
+      const u8* iv = block + 0x3D0;
+      const u64 copy_size = std::min(length, BLOCK_DATA_SIZE - data_offset_in_block);
+
+      if (copy_size == BLOCK_DATA_SIZE)
+      {
+        // The whole block is wanted, so it can be decrypted straight into the output
+        aes_context->Crypt(iv, block + BLOCK_HEADER_SIZE, buffer, BLOCK_DATA_SIZE);
+      }
+      else
+      {
+        aes_context->Crypt(iv, block + BLOCK_HEADER_SIZE, m_last_decrypted_block_data,
+                           BLOCK_DATA_SIZE);
+        m_last_decrypted_block = block_offset_on_disc;
+        memcpy(buffer, &m_last_decrypted_block_data[data_offset_in_block],
+               static_cast<size_t>(copy_size));
+      }
+
+      // Update offsets
+      length -= copy_size;
+      buffer += copy_size;
+      offset += copy_size;
+      block_offset_on_disc += BLOCK_TOTAL_SIZE;
+      data_offset_in_block = 0;
     }
-
-    // Copy the decrypted data
-    u64 copy_size = std::min(length, BLOCK_DATA_SIZE - data_offset_in_block);
-    memcpy(buffer, &m_last_decrypted_block_data[data_offset_in_block],
-           static_cast<size_t>(copy_size));
-
-    // Update offsets
-    length -= copy_size;
-    buffer += copy_size;
-    offset += copy_size;
   }
 
   return true;
@@ -423,6 +443,16 @@ u64 VolumeWii::GetRawSize() const
   return m_reader->GetRawSize();
 }
 
+void VolumeWii::EnableReadAhead(u64 cache_size, u64 read_ahead_size)
+{
+  m_reader->EnableReadAhead(cache_size, read_ahead_size);
+}
+
+void VolumeWii::EnableMemoryMapping()
+{
+  m_reader->EnableMemoryMapping();
+}
+
 bool VolumeWii::CheckH3TableIntegrity(const Partition& partition) const
 {
   auto it = m_partitions.find(partition);
@@ -442,17 +472,25 @@ bool VolumeWii::CheckH3TableIntegrity(const Partition& partition) const
   if (contents.size() != 1)
     return false;
 
-  std::array<u8, 20> h3_table_sha1;
-  mbedtls_sha1_ret(h3_table.data(), h3_table.size(), h3_table_sha1.data());
-  return h3_table_sha1 == contents[0].sha1;
+  return Common::SHA1::CalculateDigest(h3_table) == contents[0].sha1;
 }
 
-bool VolumeWii::CheckBlockIntegrity(u64 block_index, const std::vector<u8>& encrypted_data,
-                                    const Partition& partition) const
+void VolumeWii::PrepareIntegrityChecks(const Partition& partition) const
 {
-  if (encrypted_data.size() != BLOCK_TOTAL_SIZE)
-    return false;
+  auto it = m_partitions.find(partition);
+  if (it == m_partitions.end())
+    return;
+  const PartitionDetails& partition_details = it->second;
+
+  // Common::Lazy isn't thread-safe, so evaluate everything on this thread
+  *partition_details.key;
+  *partition_details.h3_table;
+  *partition_details.data_offset;
+}
 
+bool VolumeWii::CheckBlockIntegrity(u64 block_index, const u8* encrypted_data,
+                                    const Partition& partition) const
+{
   auto it = m_partitions.find(partition);
   if (it == m_partitions.end())
     return false;
@@ -462,42 +500,46 @@ bool VolumeWii::CheckBlockIntegrity(u64 block_index, const std::vector<u8>& encr
   if (block_index / 64 * SHA1_SIZE >= partition_details.h3_table->size())
     return false;
 
-  mbedtls_aes_context* aes_context = partition_details.key->get();
+  const Common::AES::Context* aes_context = partition_details.key->get();
   if (!aes_context)
     return false;
 
   u8 cluster_metadata[BLOCK_HEADER_SIZE];
-  u8 iv[16] = {0};
-  mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_HEADER_SIZE, iv,
-                        encrypted_data.data(), cluster_metadata);
+  const u8 iv[16] = {0};
+  aes_context->Crypt(iv, encrypted_data, cluster_metadata, BLOCK_HEADER_SIZE);
 
   u8 cluster_data[BLOCK_DATA_SIZE];
-  std::memcpy(iv, encrypted_data.data() + 0x3D0, 16);
-  mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_DATA_SIZE, iv,
-                        encrypted_data.data() + BLOCK_HEADER_SIZE, cluster_data);
+  aes_context->Crypt(encrypted_data + 0x3D0, encrypted_data + BLOCK_HEADER_SIZE, cluster_data,
+                     BLOCK_DATA_SIZE);
 
   for (u32 hash_index = 0; hash_index < 31; ++hash_index)
   {
-    u8 h0_hash[SHA1_SIZE];
-    mbedtls_sha1_ret(cluster_data + hash_index * 0x400, 0x400, h0_hash);
-    if (memcmp(h0_hash, cluster_metadata + hash_index * SHA1_SIZE, SHA1_SIZE))
+    const Common::SHA1::Digest h0_hash =
+        Common::SHA1::CalculateDigest(cluster_data + hash_index * 0x400, 0x400);
+    if (memcmp(h0_hash.data(), cluster_metadata + hash_index * SHA1_SIZE, SHA1_SIZE))
       return false;
   }
 
-  u8 h1_hash[SHA1_SIZE];
-  mbedtls_sha1_ret(cluster_metadata, SHA1_SIZE * 31, h1_hash);
-  if (memcmp(h1_hash, cluster_metadata + 0x280 + (block_index % 8) * SHA1_SIZE, SHA1_SIZE))
+  const Common::SHA1::Digest h1_hash =
+      Common::SHA1::CalculateDigest(cluster_metadata, SHA1_SIZE * 31);
+  if (memcmp(h1_hash.data(), cluster_metadata + 0x280 + (block_index % 8) * SHA1_SIZE, SHA1_SIZE))
     return false;
 
-  u8 h2_hash[SHA1_SIZE];
-  mbedtls_sha1_ret(cluster_metadata + 0x280, SHA1_SIZE * 8, h2_hash);
-  if (memcmp(h2_hash, cluster_metadata + 0x340 + (block_index / 8 % 8) * SHA1_SIZE, SHA1_SIZE))
+  const Common::SHA1::Digest h2_hash =
+      Common::SHA1::CalculateDigest(cluster_metadata + 0x280, SHA1_SIZE * 8);
+  if (memcmp(h2_hash.data(), cluster_metadata + 0x340 + (block_index / 8 % 8) * SHA1_SIZE,
+             SHA1_SIZE))
+  {
     return false;
+  }
 
-  u8 h3_hash[SHA1_SIZE];
-  mbedtls_sha1_ret(cluster_metadata + 0x340, SHA1_SIZE * 8, h3_hash);
-  if (memcmp(h3_hash, partition_details.h3_table->data() + block_index / 64 * SHA1_SIZE, SHA1_SIZE))
+  const Common::SHA1::Digest h3_hash =
+      Common::SHA1::CalculateDigest(cluster_metadata + 0x340, SHA1_SIZE * 8);
+  if (memcmp(h3_hash.data(), partition_details.h3_table->data() + block_index / 64 * SHA1_SIZE,
+             SHA1_SIZE))
+  {
     return false;
+  }
 
   return true;
 }
@@ -514,7 +556,7 @@ bool VolumeWii::CheckBlockIntegrity(u64 block_index, const Partition& partition)
   std::vector<u8> cluster(BLOCK_TOTAL_SIZE);
   if (!m_reader->Read(cluster_offset, cluster.size(), cluster.data()))
     return false;
-  return CheckBlockIntegrity(block_index, cluster, partition);
+  return CheckBlockIntegrity(block_index, cluster.data(), partition);
 }
 
 }  // namespace DiscIO
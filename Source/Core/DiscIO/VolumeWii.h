@@ -5,13 +5,13 @@
 #pragma once
 
 #include <map>
-#include <mbedtls/aes.h>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "Common/Lazy.h"
 #include "Core/IOS/ES/Formats.h"
 #include "DiscIO/Filesystem.h"
@@ -58,7 +58,8 @@ public:
   Platform GetVolumeType() const override;
   bool SupportsIntegrityCheck() const override { return m_encrypted; }
   bool CheckH3TableIntegrity(const Partition& partition) const override;
-  bool CheckBlockIntegrity(u64 block_index, const std::vector<u8>& encrypted_data,
+  void PrepareIntegrityChecks(const Partition& partition) const override;
+  bool CheckBlockIntegrity(u64 block_index, const u8* encrypted_data,
                            const Partition& partition) const override;
   bool CheckBlockIntegrity(u64 block_index, const Partition& partition) const override;
 
@@ -68,6 +69,8 @@ public:
   u64 GetSize() const override;
   bool IsSizeAccurate() const override;
   u64 GetRawSize() const override;
+  void EnableReadAhead(u64 cache_size, u64 read_ahead_size) override;
+  void EnableMemoryMapping() override;
 
   static constexpr unsigned int H3_TABLE_SIZE = 0x18000;
 
@@ -75,13 +78,16 @@ public:
   static constexpr unsigned int BLOCK_DATA_SIZE = 0x7C00;
   static constexpr unsigned int BLOCK_TOTAL_SIZE = BLOCK_HEADER_SIZE + BLOCK_DATA_SIZE;
 
+  // The largest number of blocks that Read reads from the blob at once
+  static constexpr size_t MAX_BLOCKS_PER_READ = 64;
+
 protected:
   u32 GetOffsetShift() const override { return 2; }
 
 private:
   struct PartitionDetails
   {
-    Common::Lazy<std::unique_ptr<mbedtls_aes_context>> key;
+    Common::Lazy<std::unique_ptr<Common::AES::Context>> key;
     Common::Lazy<IOS::ES::TicketReader> ticket;
     Common::Lazy<IOS::ES::TMDReader> tmd;
     Common::Lazy<std::vector<u8>> cert_chain;
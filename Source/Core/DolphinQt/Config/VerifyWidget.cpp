@@ -16,6 +16,7 @@
 #include <QVBoxLayout>
 
 #include "Common/CommonTypes.h"
+#include "DiscIO/RedumpDatabase.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeVerifier.h"
 
@@ -91,9 +92,13 @@ static void SetHash(QLineEdit* line_edit, const std::vector<u8>& hash)
 
 void VerifyWidget::Verify()
 {
+  const std::unique_ptr<DiscIO::RedumpDatabase> redump_database =
+      DiscIO::RedumpDatabase::LoadFromUserDirectory();
+
   DiscIO::VolumeVerifier verifier(
       *m_volume,
-      {m_crc32_checkbox->isChecked(), m_md5_checkbox->isChecked(), m_sha1_checkbox->isChecked()});
+      {m_crc32_checkbox->isChecked(), m_md5_checkbox->isChecked(), m_sha1_checkbox->isChecked()},
+      redump_database.get());
 
   // We have to divide the number of processed bytes with something so it won't make ints overflow
   constexpr int DIVISOR = 0x100;
@@ -109,6 +114,7 @@ void VerifyWidget::Verify()
   while (verifier.GetBytesProcessed() != verifier.GetTotalBytes())
   {
     progress.setValue(verifier.GetBytesProcessed() / DIVISOR);
+    progress.setLabelText(tr("Verifying (%1 MB/s)").arg(verifier.GetBytesPerSecond() / 1000000));
     if (progress.wasCanceled())
       return;
 
@@ -36,6 +36,7 @@
 #include "Core/HW/WiiSave.h"
 #include "Core/WiiUtils.h"
 
+#include "DiscIO/BCZBlob.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Enums.h"
 
@@ -263,7 +264,7 @@ void GameList::ShowContextMenu(const QPoint&)
       if (platform == DiscIO::Platform::GameCubeDisc || platform == DiscIO::Platform::WiiDisc)
       {
         const auto blob_type = game->GetBlobType();
-        if (blob_type == DiscIO::BlobType::GCZ)
+        if (blob_type == DiscIO::BlobType::GCZ || blob_type == DiscIO::BlobType::BCZ)
           decompress = true;
         else if (blob_type == DiscIO::BlobType::PLAIN)
           compress = true;
@@ -306,7 +307,7 @@ void GameList::ShowContextMenu(const QPoint&)
       menu->addAction(tr("Set as &Default ISO"), this, &GameList::SetDefaultISO);
       const auto blob_type = game->GetBlobType();
 
-      if (blob_type == DiscIO::BlobType::GCZ)
+      if (blob_type == DiscIO::BlobType::GCZ || blob_type == DiscIO::BlobType::BCZ)
         menu->addAction(tr("Decompress ISO..."), this, [this] { CompressISO(true); });
       else if (blob_type == DiscIO::BlobType::PLAIN)
         menu->addAction(tr("Compress ISO..."), this, [this] { CompressISO(false); });
@@ -485,7 +486,8 @@ void GameList::CompressISO(bool decompress)
 
     if ((file->GetPlatform() != DiscIO::Platform::GameCubeDisc &&
          file->GetPlatform() != DiscIO::Platform::WiiDisc) ||
-        (decompress && file->GetBlobType() != DiscIO::BlobType::GCZ) ||
+        (decompress && file->GetBlobType() != DiscIO::BlobType::GCZ &&
+         file->GetBlobType() != DiscIO::BlobType::BCZ) ||
         (!decompress && file->GetBlobType() != DiscIO::BlobType::PLAIN))
     {
       it.remove();
@@ -536,7 +538,8 @@ void GameList::CompressISO(bool decompress)
                 QFileInfo(QString::fromStdString(files[0]->GetFilePath())).completeBaseName())
             .append(decompress ? QStringLiteral(".gcm") : QStringLiteral(".gcz")),
         decompress ? tr("Uncompressed GC/Wii images (*.iso *.gcm)") :
-                     tr("Compressed GC/Wii images (*.gcz)"));
+                     tr("Compressed GC/Wii images (*.gcz);;"
+                        "Block-compressed GC/Wii images (*.bcz)"));
 
     if (dst_path.isEmpty())
       return;
@@ -589,9 +592,17 @@ void GameList::CompressISO(bool decompress)
       if (files.size() > 1)
         progress_dialog.setLabelText(tr("Compressing...") + QLatin1Char{'\n'} +
                                      QFileInfo(QString::fromStdString(original_path)).fileName());
-      good = DiscIO::CompressFileToBlob(original_path, dst_path.toStdString(),
-                                        file->GetPlatform() == DiscIO::Platform::WiiDisc ? 1 : 0,
-                                        16384, &CompressCB, &progress_dialog);
+      if (dst_path.endsWith(QStringLiteral(".bcz"), Qt::CaseInsensitive))
+      {
+        good = DiscIO::ConvertToBCZ(original_path, dst_path.toStdString(), 0x20000, 9,
+                                    &CompressCB, &progress_dialog);
+      }
+      else
+      {
+        good = DiscIO::CompressFileToBlob(original_path, dst_path.toStdString(),
+                                          file->GetPlatform() == DiscIO::Platform::WiiDisc ? 1 : 0,
+                                          16384, &CompressCB, &progress_dialog);
+      }
     }
 
     if (!good)
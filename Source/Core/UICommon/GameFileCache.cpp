@@ -27,13 +27,13 @@
 
 namespace UICommon
 {
-static constexpr u32 CACHE_REVISION = 15;  // Last changed in PR 7816
+static constexpr u32 CACHE_REVISION = 16;  // Last changed for the BCZ blob type
 
 std::vector<std::string> FindAllGamePaths(const std::vector<std::string>& directories_to_scan,
                                           bool recursive_scan)
 {
   static const std::vector<std::string> search_extensions = {
-      ".gcm", ".tgc", ".iso", ".ciso", ".gcz", ".wbfs", ".wad", ".dol", ".elf"};
+      ".gcm", ".tgc", ".iso", ".ciso", ".gcz", ".bcz", ".wbfs", ".wad", ".dol", ".elf"};
 
   // TODO: We could process paths iteratively as they are found
   return Common::DoFileSearch(directories_to_scan, search_extensions, recursive_scan);
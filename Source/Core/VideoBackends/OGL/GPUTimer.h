@@ -6,10 +6,6 @@
 
 #include "Common/GL/GLExtensions/GLExtensions.h"
 
-#ifndef GL_TIME_ELAPSED
-#define GL_TIME_ELAPSED 0x88BF
-#endif
-
 namespace OGL
 {
 /*
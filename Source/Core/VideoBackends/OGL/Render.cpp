@@ -5,6 +5,7 @@
 #include "VideoBackends/OGL/Render.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
 #include <cstdio>
@@ -488,6 +489,7 @@ Renderer::Renderer(std::unique_ptr<GLContext> main_gl_context, float backbuffer_
   g_ogl_config.bSupportsImageLoadStore = GLExtensions::Supports("GL_ARB_shader_image_load_store");
   g_ogl_config.bSupportsConservativeDepth = GLExtensions::Supports("GL_ARB_conservative_depth");
   g_ogl_config.bSupportsAniso = GLExtensions::Supports("GL_EXT_texture_filter_anisotropic");
+  g_ogl_config.bSupportsTimestampQueries = GLExtensions::Supports("GL_ARB_timer_query");
   g_Config.backend_info.bSupportsComputeShaders = GLExtensions::Supports("GL_ARB_compute_shader");
   g_Config.backend_info.bSupportsST3CTextures =
       GLExtensions::Supports("GL_EXT_texture_compression_s3tc");
@@ -811,6 +813,11 @@ void Renderer::Shutdown()
 
   glDeleteFramebuffers(1, &m_shared_draw_framebuffer);
   glDeleteFramebuffers(1, &m_shared_read_framebuffer);
+  if (!m_free_timestamp_queries.empty())
+  {
+    glDeleteQueries(static_cast<GLsizei>(m_free_timestamp_queries.size()),
+                    m_free_timestamp_queries.data());
+  }
 }
 
 std::unique_ptr<AbstractTexture> Renderer::CreateTexture(const TextureConfig& config)
@@ -883,6 +890,49 @@ void Renderer::BBoxWrite(int index, u16 value)
   BoundingBox::Set(index, swapped_value);
 }
 
+u32 Renderer::WriteGPUTimestamp()
+{
+  if (!g_ogl_config.bSupportsTimestampQueries)
+    return 0;
+
+  // The clocks drift apart, so calibrate them whenever a new set of timestamps is started.
+  if (m_timestamp_queries_in_use == 0)
+  {
+    GLint64 gpu_time = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+    const auto cpu_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+    m_timestamp_offset = static_cast<s64>(cpu_time.count()) - gpu_time / 1000;
+  }
+
+  GLuint query;
+  if (m_free_timestamp_queries.empty())
+  {
+    glGenQueries(1, &query);
+  }
+  else
+  {
+    query = m_free_timestamp_queries.back();
+    m_free_timestamp_queries.pop_back();
+  }
+
+  glQueryCounter(query, GL_TIMESTAMP);
+  m_timestamp_queries_in_use++;
+  return query;
+}
+
+u64 Renderer::ReadGPUTimestamp(u32 timestamp)
+{
+  if (timestamp == 0)
+    return 0;
+
+  GLuint64 gpu_time = 0;
+  glGetQueryObjectui64v(timestamp, GL_QUERY_RESULT, &gpu_time);
+  m_free_timestamp_queries.push_back(timestamp);
+  m_timestamp_queries_in_use--;
+  return static_cast<u64>(static_cast<s64>(gpu_time / 1000) + m_timestamp_offset);
+}
+
 void Renderer::SetViewport(float x, float y, float width, float height, float near_depth,
                            float far_depth)
 {
@@ -903,6 +953,7 @@ void Renderer::Draw(u32 base_vertex, u32 num_vertices)
 {
   glDrawArrays(static_cast<const OGLPipeline*>(m_current_pipeline)->GetGLPrimitive(), base_vertex,
                num_vertices);
+  StreamBuffer::OnCommandsIssued();
 }
 
 void Renderer::DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex)
@@ -918,6 +969,7 @@ void Renderer::DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex)
     glDrawElements(static_cast<const OGLPipeline*>(m_current_pipeline)->GetGLPrimitive(),
                    num_indices, GL_UNSIGNED_SHORT, static_cast<u16*>(nullptr) + base_index);
   }
+  StreamBuffer::OnCommandsIssued();
 }
 
 void Renderer::DispatchComputeShader(const AbstractShader* shader, u32 groups_x, u32 groups_y,
@@ -925,6 +977,7 @@ void Renderer::DispatchComputeShader(const AbstractShader* shader, u32 groups_x,
 {
   glUseProgram(static_cast<const OGLShader*>(shader)->GetGLComputeProgramID());
   glDispatchCompute(groups_x, groups_y, groups_z);
+  StreamBuffer::OnCommandsIssued();
 
   // We messed up the program binding, so restore it.
   ProgramShaderCache::InvalidateLastProgram();
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <string>
+#include <vector>
 
 #include "Common/GL/GLContext.h"
 #include "Common/GL/GLExtensions/GLExtensions.h"
@@ -70,6 +71,7 @@ struct VideoConfig
   bool bSupportsTextureSubImage;
   EsFbFetchType SupportedFramebufferFetch;
   bool bSupportsShaderThreadShuffleNV;
+  bool bSupportsTimestampQueries;
 
   const char* gl_vendor;
   const char* gl_renderer;
@@ -129,6 +131,9 @@ public:
   u16 BBoxRead(int index) override;
   void BBoxWrite(int index, u16 value) override;
 
+  u32 WriteGPUTimestamp() override;
+  u64 ReadGPUTimestamp(u32 timestamp) override;
+
   void BeginUtilityDrawing() override;
   void EndUtilityDrawing() override;
 
@@ -178,5 +183,11 @@ private:
   BlendingState m_current_blend_state;
   GLuint m_shared_read_framebuffer = 0;
   GLuint m_shared_draw_framebuffer = 0;
+
+  // Timestamp queries which have been read back, and the offset from the GPU clock to the
+  // steady_clock timeline in microseconds, measured when no timestamps are in use.
+  std::vector<GLuint> m_free_timestamp_queries;
+  u32 m_timestamp_queries_in_use = 0;
+  s64 m_timestamp_offset = 0;
 };
 }  // namespace OGL
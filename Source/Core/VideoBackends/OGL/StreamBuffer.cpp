@@ -4,7 +4,15 @@
 
 #include "VideoBackends/OGL/StreamBuffer.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <utility>
+
 #include "Common/Align.h"
+#include "Common/Assert.h"
 #include "Common/GL/GLUtil.h"
 #include "Common/MathUtil.h"
 #include "Common/MemoryUtil.h"
@@ -13,6 +21,8 @@
 
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexManagerBase.h"
 
 namespace OGL
 {
@@ -24,23 +34,123 @@ static u32 GenBuffer()
   return id;
 }
 
+/* Fences are shared between all stream buffers.
+ *
+ * Each fence is identified by a counter, which increases with every fence created. Stream buffers
+ * remember the counter of the fence guarding each of their sync chunks, rather than owning the
+ * fence itself. As fences are signaled in order, waiting for one also completes every fence
+ * before it, which can then be deleted without waiting on them individually.
+ *
+ * A fence only has to be created if commands which may read from a stream buffer have been issued
+ * since the previous one. Otherwise, the previous fence already guards all of the data, so the
+ * streams which are mapped together for a draw share a single fence.
+ */
+class StreamFencePool
+{
+public:
+  u64 InsertFence()
+  {
+    if (!m_commands_issued)
+      return m_next_counter - 1;
+
+    m_fences.emplace_back(m_next_counter, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_commands_issued = false;
+    return m_next_counter++;
+  }
+
+  void WaitForFence(u64 counter)
+  {
+    if (counter <= m_completed_counter)
+      return;
+
+    // Find the fence for this counter. Anything before it is complete once it is signaled.
+    auto it = m_fences.begin();
+    while (it != m_fences.end() && it->first < counter)
+      ++it;
+    ASSERT(it != m_fences.end() && it->first == counter);
+
+    // Check whether we have to block before waiting, so stalls can be counted.
+    GLenum result = glClientWaitSync(it->second, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+      const auto start_time = std::chrono::steady_clock::now();
+      glClientWaitSync(it->second, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+      const auto stall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start_time);
+
+      INCSTAT(g_stats.this_frame.num_stream_buffer_stalls);
+      ADDSTAT(g_stats.this_frame.stream_buffer_stall_time_us,
+              static_cast<int>(stall_time.count()));
+    }
+
+    ++it;
+    for (auto del = m_fences.begin(); del != it; ++del)
+      glDeleteSync(del->second);
+    m_fences.erase(m_fences.begin(), it);
+    m_completed_counter = counter;
+  }
+
+  void OnCommandsIssued() { m_commands_issued = true; }
+
+  // Called when the last stream buffer is destroyed, before the context goes away.
+  void Reset()
+  {
+    for (const auto& fence : m_fences)
+      glDeleteSync(fence.second);
+    m_fences.clear();
+    m_completed_counter = m_next_counter - 1;
+    m_commands_issued = true;
+  }
+
+private:
+  std::deque<std::pair<u64, GLsync>> m_fences;
+  u64 m_next_counter = 1;
+  u64 m_completed_counter = 0;
+  bool m_commands_issued = true;
+};
+
+static StreamFencePool s_fence_pool;
+static u32 s_num_stream_buffers = 0;
+
 StreamBuffer::StreamBuffer(u32 type, u32 size)
     : m_buffer(GenBuffer()), m_buffertype(type), m_size(MathUtil::NextPowerOf2(size)),
+      m_base_offset(0), m_owns_buffer(true),
       m_bit_per_slot(IntLog2(MathUtil::NextPowerOf2(size) / SYNC_POINTS))
 {
   m_iterator = 0;
   m_used_iterator = 0;
   m_free_iterator = 0;
+  s_num_stream_buffers++;
+}
+
+StreamBuffer::StreamBuffer(u32 type, u32 size, u32 buffer, u32 base_offset)
+    : m_buffer(buffer), m_buffertype(type), m_size(MathUtil::NextPowerOf2(size)),
+      m_base_offset(base_offset), m_owns_buffer(false),
+      m_bit_per_slot(IntLog2(MathUtil::NextPowerOf2(size) / SYNC_POINTS))
+{
+  m_iterator = 0;
+  m_used_iterator = 0;
+  m_free_iterator = 0;
+  s_num_stream_buffers++;
 }
 
 StreamBuffer::~StreamBuffer()
 {
-  glDeleteBuffers(1, &m_buffer);
+  if (m_owns_buffer)
+    glDeleteBuffers(1, &m_buffer);
+
+  if (--s_num_stream_buffers == 0)
+    s_fence_pool.Reset();
+}
+
+void StreamBuffer::OnCommandsIssued()
+{
+  s_fence_pool.OnCommandsIssued();
 }
 
 /* Shared synchronization code for ring buffers
  *
- * The next three functions are to create/delete/use the OpenGL synchronization.
+ * The next function uses the OpenGL synchronization, through the shared fence pool.
  * ARB_sync (OpenGL 3.2) is used and required.
  *
  * To reduce overhead, the complete buffer is splitted up into SYNC_POINTS chunks.
@@ -64,38 +174,19 @@ StreamBuffer::~StreamBuffer()
  * As ring buffers have an ugly behavior on rollover, have fun to read this code ;)
  */
 
-void StreamBuffer::CreateFences()
-{
-  for (int i = 0; i < SYNC_POINTS; i++)
-  {
-    m_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-  }
-}
-void StreamBuffer::DeleteFences()
-{
-  for (int i = Slot(m_free_iterator) + 1; i < SYNC_POINTS; i++)
-  {
-    glDeleteSync(m_fences[i]);
-  }
-  for (int i = 0; i < Slot(m_iterator); i++)
-  {
-    glDeleteSync(m_fences[i]);
-  }
-}
 void StreamBuffer::AllocMemory(u32 size)
 {
   // insert waiting slots for used memory
   for (int i = Slot(m_used_iterator); i < Slot(m_iterator); i++)
   {
-    m_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_fences[i] = s_fence_pool.InsertFence();
   }
   m_used_iterator = m_iterator;
 
   // wait for new slots to end of buffer
   for (int i = Slot(m_free_iterator) + 1; i <= Slot(m_iterator + size) && i < SYNC_POINTS; i++)
   {
-    glClientWaitSync(m_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
-    glDeleteSync(m_fences[i]);
+    s_fence_pool.WaitForFence(m_fences[i]);
   }
 
   // If we allocate a large amount of memory (A), commit a smaller amount, then allocate memory
@@ -111,7 +202,7 @@ void StreamBuffer::AllocMemory(u32 size)
     // insert waiting slots in unused space at the end of the buffer
     for (int i = Slot(m_used_iterator); i < SYNC_POINTS; i++)
     {
-      m_fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      m_fences[i] = s_fence_pool.InsertFence();
     }
 
     // move to the start
@@ -120,8 +211,7 @@ void StreamBuffer::AllocMemory(u32 size)
     // wait for space at the start
     for (int i = 0; i <= Slot(m_iterator + size); i++)
     {
-      glClientWaitSync(m_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
-      glDeleteSync(m_fences[i]);
+      s_fence_pool.WaitForFence(m_fences[i]);
     }
     m_free_iterator = m_iterator + size;
   }
@@ -177,12 +267,11 @@ class MapAndSync : public StreamBuffer
 public:
   MapAndSync(u32 type, u32 size) : StreamBuffer(type, size)
   {
-    CreateFences();
     glBindBuffer(m_buffertype, m_buffer);
     glBufferData(m_buffertype, m_size, nullptr, GL_STREAM_DRAW);
   }
 
-  ~MapAndSync() { DeleteFences(); }
+  ~MapAndSync() {}
   std::pair<u8*, u32> Map(u32 size) override
   {
     AllocMemory(size);
@@ -219,7 +308,6 @@ public:
   BufferStorage(u32 type, u32 size, bool _coherent = true)
       : StreamBuffer(type, size), coherent(_coherent)
   {
-    CreateFences();
     glBindBuffer(m_buffertype, m_buffer);
 
     // PERSISTANT_BIT to make sure that the buffer can be used while mapped
@@ -237,7 +325,6 @@ public:
 
   ~BufferStorage()
   {
-    DeleteFences();
     glUnmapBuffer(m_buffertype);
     glBindBuffer(m_buffertype, 0);
   }
@@ -259,6 +346,126 @@ public:
   const bool coherent;
 };
 
+/* Streaming fifos which share a single persistently mapped buffer.
+ *
+ * The vertex, index and uniform streams are regions of one buffer, which is mapped only once.
+ * This saves a buffer binding and a mapping per stream, and as all of them are synchronized
+ * through the shared fence pool, a draw usually only requires a single fence for all three.
+ */
+class StreamArena
+{
+public:
+  ~StreamArena()
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &m_buffer);
+  }
+
+  // Returns the arena shared by all live streams, creating it if there is none.
+  static std::shared_ptr<StreamArena> Get()
+  {
+    static std::weak_ptr<StreamArena> s_arena;
+    std::shared_ptr<StreamArena> arena = s_arena.lock();
+    if (!arena)
+    {
+      arena.reset(new StreamArena());
+      s_arena = arena;
+    }
+    return arena;
+  }
+
+  static bool GetRegion(u32 type, u32* out_base, u32* out_size)
+  {
+    for (const Region& region : GetRegions())
+    {
+      if (region.type == type)
+      {
+        *out_base = region.base;
+        *out_size = region.size;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  u32 GetBuffer() const { return m_buffer; }
+  u8* GetPointer() const { return m_pointer; }
+
+private:
+  struct Region
+  {
+    u32 type;
+    u32 base;
+    u32 size;
+  };
+
+  StreamArena()
+  {
+    const Region& last_region = GetRegions().back();
+    const u32 total_size = last_region.base + last_region.size;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, total_size, nullptr,
+                    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    m_pointer = static_cast<u8*>(glMapBufferRange(
+        GL_COPY_WRITE_BUFFER, 0, total_size,
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  static const std::array<Region, 3>& GetRegions()
+  {
+    static const std::array<Region, 3> regions = [] {
+      // Each region must start at an offset usable for uniform buffer bindings.
+      GLint ubo_align = 256;
+      glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_align);
+      const u32 align = MathUtil::NextPowerOf2(std::max(static_cast<u32>(ubo_align), 256u));
+
+      std::array<Region, 3> result = {
+          {{GL_ARRAY_BUFFER, 0,
+            MathUtil::NextPowerOf2(VertexManagerBase::VERTEX_STREAM_BUFFER_SIZE)},
+           {GL_ELEMENT_ARRAY_BUFFER, 0,
+            MathUtil::NextPowerOf2(VertexManagerBase::INDEX_STREAM_BUFFER_SIZE)},
+           {GL_UNIFORM_BUFFER, 0,
+            MathUtil::NextPowerOf2(VertexManagerBase::UNIFORM_STREAM_BUFFER_SIZE)}}};
+      for (size_t i = 1; i < result.size(); i++)
+        result[i].base = Common::AlignUp(result[i - 1].base + result[i - 1].size, align);
+      return result;
+    }();
+    return regions;
+  }
+
+  u32 m_buffer = 0;
+  u8* m_pointer = nullptr;
+};
+
+class ArenaStreamBuffer : public StreamBuffer
+{
+public:
+  ArenaStreamBuffer(u32 type, u32 size, u32 base_offset, std::shared_ptr<StreamArena> arena)
+      : StreamBuffer(type, size, arena->GetBuffer(), base_offset), m_arena(std::move(arena))
+  {
+    glBindBuffer(m_buffertype, m_buffer);
+  }
+
+  ~ArenaStreamBuffer() { glBindBuffer(m_buffertype, 0); }
+
+  std::pair<u8*, u32> Map(u32 size) override
+  {
+    AllocMemory(size);
+    return std::make_pair(m_arena->GetPointer() + m_base_offset + m_iterator,
+                          m_base_offset + m_iterator);
+  }
+
+  void Unmap(u32 used_size) override { m_iterator += used_size; }
+
+private:
+  std::shared_ptr<StreamArena> m_arena;
+};
+
 /* --- AMD only ---
  * Another streaming fifo without mapping overhead.
  * As we can't orphan without mapping, we have to sync.
@@ -271,7 +478,6 @@ class PinnedMemory : public StreamBuffer
 public:
   PinnedMemory(u32 type, u32 size) : StreamBuffer(type, size)
   {
-    CreateFences();
     m_pointer = static_cast<u8*>(Common::AllocateAlignedMemory(
         Common::AlignUp(m_size, ALIGN_PINNED_MEMORY), ALIGN_PINNED_MEMORY));
     glBindBuffer(GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD, m_buffer);
@@ -283,7 +489,6 @@ public:
 
   ~PinnedMemory()
   {
-    DeleteFences();
     glBindBuffer(m_buffertype, 0);
     glFinish();  // ogl pipeline must be flushed, else this buffer can be in use
     Common::FreeAlignedMemory(m_pointer);
@@ -367,7 +572,17 @@ std::unique_ptr<StreamBuffer> StreamBuffer::Create(u32 type, u32 size)
         !(DriverDetails::HasBug(DriverDetails::BUG_BROKEN_PINNED_MEMORY)))
       return std::make_unique<PinnedMemory>(type, size);
 
-    // buffer storage works well in most situations
+    // buffer storage works well in most situations, and the streams used for every draw can
+    // share a single buffer when none of them is affected by a buffer storage bug
+    u32 arena_base, arena_size;
+    if (g_ogl_config.bSupportsGLBufferStorage &&
+        !DriverDetails::HasBug(DriverDetails::BUG_BROKEN_BUFFER_STORAGE) &&
+        !DriverDetails::HasBug(DriverDetails::BUG_INTEL_BROKEN_BUFFER_STORAGE) &&
+        StreamArena::GetRegion(type, &arena_base, &arena_size) && size <= arena_size)
+    {
+      return std::make_unique<ArenaStreamBuffer>(type, arena_size, arena_base, StreamArena::Get());
+    }
+
     if (g_ogl_config.bSupportsGLBufferStorage &&
         !(DriverDetails::HasBug(DriverDetails::BUG_BROKEN_BUFFER_STORAGE) &&
           type == GL_ARRAY_BUFFER) &&
@@ -21,7 +21,7 @@ public:
 
   u32 GetGLBufferId() const { return m_buffer; }
   u32 GetSize() const { return m_size; }
-  u32 GetCurrentOffset() const { return m_iterator; }
+  u32 GetCurrentOffset() const { return m_base_offset + m_iterator; }
 
   /* This mapping function will return a pair of:
    * - the pointer to the mapped buffer
@@ -36,7 +36,7 @@ public:
 
   std::pair<u8*, u32> Map(u32 size, u32 stride)
   {
-    u32 padding = m_iterator % stride;
+    u32 padding = (m_base_offset + m_iterator) % stride;
     if (padding)
     {
       m_iterator += stride - padding;
@@ -44,16 +44,24 @@ public:
     return Map(size);
   }
 
+  // Must be called after issuing commands which may read from a stream buffer. Fences are
+  // shared between all stream buffers, and a new one is only needed after such a command.
+  static void OnCommandsIssued();
+
   const u32 m_buffer;
 
 protected:
   StreamBuffer(u32 type, u32 size);
-  void CreateFences();
-  void DeleteFences();
+
+  // Uses a region of a buffer which is owned by someone else, starting at base_offset.
+  StreamBuffer(u32 type, u32 size, u32 buffer, u32 base_offset);
+
   void AllocMemory(u32 size);
 
   const u32 m_buffertype;
   const u32 m_size;
+  const u32 m_base_offset;
+  const bool m_owns_buffer;
 
   u32 m_iterator;
   u32 m_used_iterator;
@@ -64,6 +72,7 @@ private:
   int Slot(u32 x) const { return x >> m_bit_per_slot; }
   const int m_bit_per_slot;
 
-  std::array<GLsync, SYNC_POINTS> m_fences{};
+  // Counter of the fence in the shared pool which guards each slot.
+  std::array<u64, SYNC_POINTS> m_fences{};
 };
 }  // namespace OGL
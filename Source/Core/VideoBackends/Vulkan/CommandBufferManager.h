@@ -46,6 +46,8 @@ public:
   {
     return m_frame_resources[m_current_frame].descriptor_pool;
   }
+  // Index of the current set of per-frame resources, in the range [0, NUM_COMMAND_BUFFERS).
+  u32 GetCurrentCommandBufferIndex() const { return m_current_frame; }
   // Allocates a descriptors set from the pool reserved for the current frame.
   VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout set_layout);
 
@@ -6,12 +6,16 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <type_traits>
 
 #include "Common/Assert.h"
 #include "Common/CommonFuncs.h"
-#include "Common/LinearDiskCache.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
 #include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
 
 #include "Core/ConfigManager.h"
 
@@ -31,6 +35,7 @@ ObjectCache::ObjectCache() = default;
 
 ObjectCache::~ObjectCache()
 {
+  DestroyWorkerPipelineCaches();
   DestroyPipelineCache();
   DestroySamplers();
   DestroyPipelineLayouts();
@@ -58,6 +63,10 @@ bool ObjectCache::Initialize()
     return false;
   }
 
+  m_pipeline_cache_writer.Reset([](std::pair<std::string, std::vector<u8>> item) {
+    WritePipelineCacheFile(item.first, item.second);
+  });
+
   if (g_ActiveConfig.bShaderCache)
   {
     if (!LoadPipelineCache())
@@ -440,33 +449,55 @@ void ObjectCache::DestroyRenderPassCache()
   m_render_pass_cache.clear();
 }
 
-class PipelineCacheReadCallback : public LinearDiskCacheReader<u32, u8>
+namespace
 {
-public:
-  PipelineCacheReadCallback(std::vector<u8>* data) : m_data(data) {}
-  void Read(const u32& key, const u8* value, u32 value_size) override
-  {
-    m_data->resize(value_size);
-    if (value_size > 0)
-      memcpy(m_data->data(), value, value_size);
-  }
+// Worker threads which have acquired a pipeline cache, see AcquireWorkerPipelineCache().
+thread_local VkPipelineCache s_worker_pipeline_cache = VK_NULL_HANDLE;
 
-private:
-  std::vector<u8>* m_data;
-};
+// Pipeline cache files are written at most this often while the game is running.
+constexpr std::chrono::seconds PIPELINE_CACHE_SAVE_INTERVAL{30};
 
-class PipelineCacheReadIgnoreCallback : public LinearDiskCacheReader<u32, u8>
+constexpr u32 PIPELINE_CACHE_FILE_MAGIC = 0x43504B56;  // VKPC
+constexpr u32 PIPELINE_CACHE_FILE_VERSION = 1;
+
+// Header prepended to the driver's pipeline cache data. The driver performs its own validation
+// of the data, but not all drivers are robust against corrupted or truncated caches, so we check
+// the size and checksum ourselves. The driver version is also checked, as some drivers do not
+// change their pipeline cache UUID between releases.
+struct PipelineCacheFileHeader
 {
-public:
-  void Read(const u32& key, const u8* value, u32 value_size) override {}
+  u32 magic;
+  u32 version;
+  u32 vendor_id;
+  u32 device_id;
+  u32 driver_version;
+  u8 uuid[VK_UUID_SIZE];
+  u32 data_size;
+  u32 data_checksum;
 };
+static_assert(std::is_trivially_copyable<PipelineCacheFileHeader>::value,
+              "PipelineCacheFileHeader must be trivially copyable");
+}  // namespace
+
+std::string ObjectCache::GetPipelineCacheFileName() const
+{
+  // The driver's pipeline cache UUID is part of the filename, so that switching between GPUs or
+  // driver versions does not throw away the cache for the other.
+  std::string type = "Pipeline-";
+  for (u8 byte : g_vulkan_context->GetDeviceProperties().pipelineCacheUUID)
+    type += StringFromFormat("%02x", byte);
+
+  return GetDiskShaderCacheFileName(APIType::Vulkan, type.c_str(), false, true);
+}
 
 bool ObjectCache::CreatePipelineCache()
 {
   // Vulkan pipeline caches can be shared between games for shader compile time reduction.
   // This assumes that drivers don't create all pipelines in the cache on load time, only
   // when a lookup occurs that matches a pipeline (or pipeline data) in the cache.
-  m_pipeline_cache_filename = GetDiskShaderCacheFileName(APIType::Vulkan, "Pipeline", false, true);
+  m_pipeline_cache_filename = GetPipelineCacheFileName();
+  m_pipeline_cache_dirty.store(false);
+  m_pipeline_cache_last_save = std::chrono::steady_clock::now();
 
   VkPipelineCacheCreateInfo info = {
       VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,  // VkStructureType            sType
@@ -489,13 +520,45 @@ bool ObjectCache::LoadPipelineCache()
 {
   // We have to keep the pipeline cache file name around since when we save it
   // we delete the old one, by which time the game's unique ID is already cleared.
-  m_pipeline_cache_filename = GetDiskShaderCacheFileName(APIType::Vulkan, "Pipeline", false, true);
+  m_pipeline_cache_filename = GetPipelineCacheFileName();
+  m_pipeline_cache_dirty.store(false);
+  m_pipeline_cache_last_save = std::chrono::steady_clock::now();
+
+  // Older versions stored the cache without a header, in a file which was shared between
+  // drivers. It is of no use to us anymore.
+  const std::string legacy_filename =
+      GetDiskShaderCacheFileName(APIType::Vulkan, "Pipeline", false, true);
+  if (File::Exists(legacy_filename))
+    File::Delete(legacy_filename);
 
   std::vector<u8> disk_data;
-  LinearDiskCache<u32, u8> disk_cache;
-  PipelineCacheReadCallback read_callback(&disk_data);
-  if (disk_cache.OpenAndRead(m_pipeline_cache_filename, read_callback) != 1)
-    disk_data.clear();
+  if (File::Exists(m_pipeline_cache_filename))
+  {
+    PipelineCacheFileHeader header;
+    File::IOFile file(m_pipeline_cache_filename, "rb");
+    if (!file.ReadArray(&header, 1) || header.magic != PIPELINE_CACHE_FILE_MAGIC ||
+        header.version != PIPELINE_CACHE_FILE_VERSION ||
+        file.GetSize() != sizeof(header) + header.data_size)
+    {
+      ERROR_LOG(VIDEO, "Pipeline cache failed validation: Invalid file header");
+    }
+    else
+    {
+      disk_data.resize(header.data_size);
+      if (!file.ReadBytes(disk_data.data(), disk_data.size()) ||
+          Common::HashAdler32(disk_data.data(), disk_data.size()) != header.data_checksum)
+      {
+        ERROR_LOG(VIDEO, "Pipeline cache failed validation: Checksum mismatch");
+        disk_data.clear();
+      }
+      else if (header.driver_version != g_vulkan_context->GetDeviceProperties().driverVersion)
+      {
+        INFO_LOG(VIDEO, "Discarding pipeline cache from a different driver version (%08X)",
+                 header.driver_version);
+        disk_data.clear();
+      }
+    }
+  }
 
   if (!disk_data.empty() && !ValidatePipelineCache(disk_data.data(), disk_data.size()))
   {
@@ -515,7 +578,11 @@ bool ObjectCache::LoadPipelineCache()
   VkResult res =
       vkCreatePipelineCache(g_vulkan_context->GetDevice(), &info, nullptr, &m_pipeline_cache);
   if (res == VK_SUCCESS)
+  {
+    INFO_LOG(VIDEO, "Loaded %zu bytes of pipeline cache data from %s", disk_data.size(),
+             m_pipeline_cache_filename.c_str());
     return true;
+  }
 
   // Failed to create pipeline cache, try with it empty.
   LOG_VULKAN_ERROR(res, "vkCreatePipelineCache failed, trying empty cache: ");
@@ -592,46 +659,211 @@ void ObjectCache::DestroyPipelineCache()
   m_pipeline_cache = VK_NULL_HANDLE;
 }
 
-void ObjectCache::SavePipelineCache()
+void ObjectCache::DestroyWorkerPipelineCaches()
+{
+  std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+  ASSERT_MSG(VIDEO, m_free_worker_pipeline_caches.size() == m_worker_pipeline_caches.size(),
+             "Worker pipeline caches are still in use");
+
+  for (VkPipelineCache cache : m_worker_pipeline_caches)
+    vkDestroyPipelineCache(g_vulkan_context->GetDevice(), cache, nullptr);
+  m_worker_pipeline_caches.clear();
+  m_free_worker_pipeline_caches.clear();
+}
+
+VkPipelineCache ObjectCache::GetPipelineCache()
+{
+  m_pipeline_cache_dirty.store(true, std::memory_order_relaxed);
+  return s_worker_pipeline_cache != VK_NULL_HANDLE ? s_worker_pipeline_cache : m_pipeline_cache;
+}
+
+bool ObjectCache::ReserveWorkerPipelineCache()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+    if (!m_free_worker_pipeline_caches.empty())
+      return true;
+  }
+
+  // Seed the new cache with everything we know about so far. Reading the main cache is safe
+  // here, as it is only ever modified on the GPU thread.
+  std::vector<u8> data;
+  if (!GetPipelineCacheData(m_pipeline_cache, &data))
+    data.clear();
+
+  VkPipelineCacheCreateInfo info = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,  // VkStructureType            sType
+      nullptr,                                       // const void*                pNext
+      0,                                             // VkPipelineCacheCreateFlags flags
+      data.size(),                                   // size_t                     initialDataSize
+      data.data()                                    // const void*                pInitialData
+  };
+
+  VkPipelineCache cache;
+  VkResult res = vkCreatePipelineCache(g_vulkan_context->GetDevice(), &info, nullptr, &cache);
+  if (res != VK_SUCCESS)
+  {
+    LOG_VULKAN_ERROR(res, "vkCreatePipelineCache failed: ");
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+  m_worker_pipeline_caches.push_back(cache);
+  m_free_worker_pipeline_caches.push_back(cache);
+  return true;
+}
+
+bool ObjectCache::AcquireWorkerPipelineCache()
+{
+  std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+  if (m_free_worker_pipeline_caches.empty())
+    return false;
+
+  s_worker_pipeline_cache = m_free_worker_pipeline_caches.back();
+  m_free_worker_pipeline_caches.pop_back();
+  return true;
+}
+
+void ObjectCache::ReleaseWorkerPipelineCache()
+{
+  if (s_worker_pipeline_cache == VK_NULL_HANDLE)
+    return;
+
+  std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+  m_free_worker_pipeline_caches.push_back(s_worker_pipeline_cache);
+  s_worker_pipeline_cache = VK_NULL_HANDLE;
+}
+
+void ObjectCache::MergeWorkerPipelineCaches()
+{
+  // Only the destination cache requires external synchronization, so workers can continue
+  // creating pipelines from their caches while they are merged.
+  std::lock_guard<std::mutex> guard(m_worker_pipeline_cache_lock);
+  if (m_worker_pipeline_caches.empty())
+    return;
+
+  VkResult res = vkMergePipelineCaches(g_vulkan_context->GetDevice(), m_pipeline_cache,
+                                       static_cast<u32>(m_worker_pipeline_caches.size()),
+                                       m_worker_pipeline_caches.data());
+  if (res != VK_SUCCESS)
+    LOG_VULKAN_ERROR(res, "vkMergePipelineCaches failed: ");
+}
+
+bool ObjectCache::GetPipelineCacheData(VkPipelineCache cache, std::vector<u8>* data) const
 {
   size_t data_size;
-  VkResult res =
-      vkGetPipelineCacheData(g_vulkan_context->GetDevice(), m_pipeline_cache, &data_size, nullptr);
+  VkResult res = vkGetPipelineCacheData(g_vulkan_context->GetDevice(), cache, &data_size, nullptr);
   if (res != VK_SUCCESS)
   {
     LOG_VULKAN_ERROR(res, "vkGetPipelineCacheData failed: ");
-    return;
+    return false;
   }
 
-  std::vector<u8> data(data_size);
-  res = vkGetPipelineCacheData(g_vulkan_context->GetDevice(), m_pipeline_cache, &data_size,
-                               data.data());
-  if (res != VK_SUCCESS)
+  data->resize(data_size);
+  res = vkGetPipelineCacheData(g_vulkan_context->GetDevice(), cache, &data_size, data->data());
+  if (res != VK_SUCCESS && res != VK_INCOMPLETE)
   {
     LOG_VULKAN_ERROR(res, "vkGetPipelineCacheData failed: ");
+    return false;
+  }
+
+  data->resize(data_size);
+  return true;
+}
+
+void ObjectCache::QueuePipelineCacheWrite(bool force)
+{
+  // Clear the flag before reading the data, so any pipelines created in the meantime are picked
+  // up by the next save.
+  if (!m_pipeline_cache_dirty.exchange(false) && !force)
     return;
+
+  MergeWorkerPipelineCaches();
+
+  std::vector<u8> data;
+  if (!GetPipelineCacheData(m_pipeline_cache, &data))
+    return;
+
+  const VkPhysicalDeviceProperties& props = g_vulkan_context->GetDeviceProperties();
+  PipelineCacheFileHeader header = {};
+  header.magic = PIPELINE_CACHE_FILE_MAGIC;
+  header.version = PIPELINE_CACHE_FILE_VERSION;
+  header.vendor_id = props.vendorID;
+  header.device_id = props.deviceID;
+  header.driver_version = props.driverVersion;
+  std::memcpy(header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+  header.data_size = static_cast<u32>(data.size());
+  header.data_checksum = Common::HashAdler32(data.data(), data.size());
+
+  const u8* header_bytes = reinterpret_cast<const u8*>(&header);
+  data.insert(data.begin(), header_bytes, header_bytes + sizeof(header));
+  m_pipeline_cache_writer.EmplaceItem(m_pipeline_cache_filename, std::move(data));
+  m_pipeline_cache_last_save = std::chrono::steady_clock::now();
+}
+
+void ObjectCache::WritePipelineCacheFile(const std::string& filename, const std::vector<u8>& data)
+{
+  // Write to a temporary file and swap it in, so a crash while saving does not leave behind a
+  // truncated cache.
+  const std::string temp_filename = filename + ".tmp";
+  {
+    File::IOFile file(temp_filename, "wb");
+    if (!file.WriteBytes(data.data(), data.size()))
+    {
+      ERROR_LOG(VIDEO, "Failed to write pipeline cache to %s", temp_filename.c_str());
+      return;
+    }
   }
 
-  // Delete the old cache and re-create.
-  File::Delete(m_pipeline_cache_filename);
+  if (!File::Rename(temp_filename, filename))
+    return;
 
-  // We write a single key of 1, with the entire pipeline cache data.
-  // Not ideal, but our disk cache class does not support just writing a single blob
-  // of data without specifying a key.
-  LinearDiskCache<u32, u8> disk_cache;
-  PipelineCacheReadIgnoreCallback callback;
-  disk_cache.OpenAndRead(m_pipeline_cache_filename, callback);
-  disk_cache.Append(1, data.data(), static_cast<u32>(data.size()));
-  disk_cache.Close();
+  INFO_LOG(VIDEO, "Saved %zu bytes of pipeline cache data to %s",
+           data.size() - sizeof(PipelineCacheFileHeader), filename.c_str());
+}
+
+void ObjectCache::SavePipelineCache()
+{
+  QueuePipelineCacheWrite(true);
+}
+
+void ObjectCache::PeriodicSavePipelineCache()
+{
+  if (!g_ActiveConfig.bShaderCache || m_pipeline_cache == VK_NULL_HANDLE ||
+      std::chrono::steady_clock::now() - m_pipeline_cache_last_save < PIPELINE_CACHE_SAVE_INTERVAL)
+  {
+    return;
+  }
+
+  QueuePipelineCacheWrite(false);
 }
 
 void ObjectCache::ReloadPipelineCache()
 {
-  SavePipelineCache();
+  // The worker caches are kept, pipelines which were compiled for the old host config do no
+  // harm in the new cache, and the workers may still be using them.
+  if (g_ActiveConfig.bShaderCache)
+    SavePipelineCache();
 
+  DestroyPipelineCache();
   if (g_ActiveConfig.bShaderCache)
     LoadPipelineCache();
   else
     CreatePipelineCache();
 }
+
+bool PipelineCacheAsyncShaderCompiler::WorkerThreadInitMainThread(void** param)
+{
+  return g_object_cache->ReserveWorkerPipelineCache();
+}
+
+bool PipelineCacheAsyncShaderCompiler::WorkerThreadInitWorkerThread(void* param)
+{
+  return g_object_cache->AcquireWorkerPipelineCache();
+}
+
+void PipelineCacheAsyncShaderCompiler::WorkerThreadExit(void* param)
+{
+  g_object_cache->ReleaseWorkerPipelineCache();
+}
 }  // namespace Vulkan
@@ -5,18 +5,24 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
-#include "Common/LinearDiskCache.h"
+#include "Common/WorkQueueThread.h"
 
 #include "VideoBackends/Vulkan/Constants.h"
 
+#include "VideoCommon/AsyncShaderCompiler.h"
 #include "VideoCommon/GeometryShaderGen.h"
 #include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/RenderState.h"
@@ -64,15 +70,30 @@ public:
                              VkAttachmentLoadOp load_op);
 
   // Pipeline cache. Used when creating pipelines for drivers to store compiled programs.
-  VkPipelineCache GetPipelineCache() const { return m_pipeline_cache; }
+  // Shader compiler worker threads receive their own cache, so that pipeline creation on one
+  // thread does not contend with the others on the driver's cache lock. The caller is expected
+  // to create a pipeline with the returned cache, which flags it as needing to be saved.
+  VkPipelineCache GetPipelineCache();
+
+  // Makes sure a worker pipeline cache is available for the next call to
+  // AcquireWorkerPipelineCache(). Must be called from the GPU thread.
+  bool ReserveWorkerPipelineCache();
+
+  // Binds a worker pipeline cache to the calling thread, and releases it back to the pool.
+  bool AcquireWorkerPipelineCache();
+  void ReleaseWorkerPipelineCache();
 
   // Clear sampler cache, use when anisotropy mode changes
   // WARNING: Ensure none of the objects from here are in use when calling
   void ClearSamplerCache();
 
-  // Saves the pipeline cache to disk. Call when shutting down.
+  // Merges the worker pipeline caches into the main cache, and saves it to disk.
   void SavePipelineCache();
 
+  // Saves the pipeline cache if pipelines have been created since the last save, and enough
+  // time has passed. The file is written in the background. Call once per frame.
+  void PeriodicSavePipelineCache();
+
   // Reload pipeline cache. Call when host config changes.
   void ReloadPipelineCache();
 
@@ -88,6 +109,12 @@ private:
   bool LoadPipelineCache();
   bool ValidatePipelineCache(const u8* data, size_t data_length);
   void DestroyPipelineCache();
+  void DestroyWorkerPipelineCaches();
+  void MergeWorkerPipelineCaches();
+  std::string GetPipelineCacheFileName() const;
+  bool GetPipelineCacheData(VkPipelineCache cache, std::vector<u8>* data) const;
+  void QueuePipelineCacheWrite(bool force);
+  static void WritePipelineCacheFile(const std::string& filename, const std::vector<u8>& data);
 
   std::array<VkDescriptorSetLayout, NUM_DESCRIPTOR_SET_LAYOUTS> m_descriptor_set_layouts = {};
   std::array<VkPipelineLayout, NUM_PIPELINE_LAYOUTS> m_pipeline_layouts = {};
@@ -109,6 +136,26 @@ private:
   // pipeline cache
   VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
   std::string m_pipeline_cache_filename;
+  std::atomic_bool m_pipeline_cache_dirty{false};
+  std::chrono::steady_clock::time_point m_pipeline_cache_last_save;
+
+  // Caches owned by worker threads. Free caches are kept around so that their contents are not
+  // lost when the number of worker threads changes, and are merged on save along with the rest.
+  std::mutex m_worker_pipeline_cache_lock;
+  std::vector<VkPipelineCache> m_worker_pipeline_caches;
+  std::vector<VkPipelineCache> m_free_worker_pipeline_caches;
+
+  // Writes pipeline cache files, so a periodic save does not stall the GPU thread.
+  Common::WorkQueueThread<std::pair<std::string, std::vector<u8>>> m_pipeline_cache_writer;
+};
+
+// Binds a worker pipeline cache to each shader compiler thread.
+class PipelineCacheAsyncShaderCompiler : public VideoCommon::AsyncShaderCompiler
+{
+protected:
+  bool WorkerThreadInitMainThread(void** param) override;
+  bool WorkerThreadInitWorkerThread(void* param) override;
+  void WorkerThreadExit(void* param) override;
 };
 
 extern std::unique_ptr<ObjectCache> g_object_cache;
@@ -60,8 +60,9 @@ void PerfQuery::EnableQuery(PerfQueryGroup type)
     VkQueryControlFlags flags =
         g_vulkan_context->SupportsPreciseOcclusionQueries() ? VK_QUERY_CONTROL_PRECISE_BIT : 0;
 
-    // Ensure the query starts within a render pass.
-    StateTracker::GetInstance()->BeginRenderPass();
+    // Ensure the query starts within a render pass. Queries are not inherited by secondary
+    // command buffers, so the draws have to be recorded to the primary command buffer.
+    StateTracker::GetInstance()->BeginInlineRenderPass();
     vkCmdBeginQuery(g_command_buffer_mgr->GetCurrentCommandBuffer(), m_query_pool, m_query_next_pos,
                     flags);
   }
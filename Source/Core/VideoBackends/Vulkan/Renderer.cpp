@@ -119,6 +119,11 @@ std::unique_ptr<AbstractPipeline> Renderer::CreatePipeline(const AbstractPipelin
   return VKPipeline::Create(config);
 }
 
+std::unique_ptr<VideoCommon::AsyncShaderCompiler> Renderer::CreateAsyncShaderCompiler()
+{
+  return std::make_unique<PipelineCacheAsyncShaderCompiler>();
+}
+
 std::unique_ptr<AbstractFramebuffer> Renderer::CreateFramebuffer(AbstractTexture* color_attachment,
                                                                  AbstractTexture* depth_attachment)
 {
@@ -250,8 +255,8 @@ void Renderer::ClearScreen(const MathUtil::Rectangle<int>& rc, bool color_enable
       }
       StateTracker::GetInstance()->BeginRenderPass();
 
-      vkCmdClearAttachments(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_clear_attachments,
-                            clear_attachments, 1, &vk_rect);
+      StateTracker::GetInstance()->ClearAttachments(num_clear_attachments, clear_attachments,
+                                                    vk_rect);
     }
   }
 
@@ -321,6 +326,8 @@ void Renderer::PresentBackbuffer()
 
   // New cmdbuffer, so invalidate state.
   StateTracker::GetInstance()->InvalidateCachedState();
+
+  g_object_cache->PeriodicSavePipelineCache();
 }
 
 void Renderer::ExecuteCommandBuffer(bool submit_off_thread, bool wait_for_completion)
@@ -589,7 +596,7 @@ void Renderer::Draw(u32 base_vertex, u32 num_vertices)
   if (!StateTracker::GetInstance()->Bind())
     return;
 
-  vkCmdDraw(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_vertices, 1, base_vertex, 0);
+  StateTracker::GetInstance()->Draw(base_vertex, num_vertices);
 }
 
 void Renderer::DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex)
@@ -597,8 +604,7 @@ void Renderer::DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex)
   if (!StateTracker::GetInstance()->Bind())
     return;
 
-  vkCmdDrawIndexed(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_indices, 1, base_index,
-                   base_vertex, 0);
+  StateTracker::GetInstance()->DrawIndexed(base_index, num_indices, base_vertex);
 }
 
 void Renderer::DispatchComputeShader(const AbstractShader* shader, u32 groups_x, u32 groups_y,
@@ -0,0 +1,267 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoBackends/Vulkan/SecondaryCommandRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Assert.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+
+#include "VideoBackends/Vulkan/CommandBufferManager.h"
+#include "VideoBackends/Vulkan/VulkanContext.h"
+
+namespace Vulkan
+{
+SecondaryCommandRecorder::SecondaryCommandRecorder() = default;
+
+SecondaryCommandRecorder::~SecondaryCommandRecorder()
+{
+  m_exit_flag.Set();
+  for (auto& worker : m_workers)
+  {
+    if (!worker->thread.joinable())
+      continue;
+
+    worker->start_event.Set();
+    worker->thread.join();
+  }
+
+  for (Slot& slot : m_slots)
+  {
+    for (VkCommandPool pool : slot.command_pools)
+    {
+      if (pool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(g_vulkan_context->GetDevice(), pool, nullptr);
+    }
+  }
+}
+
+std::unique_ptr<SecondaryCommandRecorder> SecondaryCommandRecorder::Create()
+{
+  // Leave some cores for the CPU thread, GPU thread and shader compilers.
+  const u32 num_worker_threads =
+      std::clamp(std::thread::hardware_concurrency() / 2, 1u, MAX_WORKER_THREADS);
+
+  auto recorder = std::make_unique<SecondaryCommandRecorder>();
+  if (!recorder->Initialize(num_worker_threads))
+    return nullptr;
+
+  return recorder;
+}
+
+bool SecondaryCommandRecorder::Initialize(u32 num_worker_threads)
+{
+  m_slots.resize(num_worker_threads + 1);
+  for (Slot& slot : m_slots)
+  {
+    for (VkCommandPool& pool : slot.command_pools)
+    {
+      VkCommandPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+                                           VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+                                           g_vulkan_context->GetGraphicsQueueFamilyIndex()};
+      VkResult res =
+          vkCreateCommandPool(g_vulkan_context->GetDevice(), &pool_info, nullptr, &pool);
+      if (res != VK_SUCCESS)
+      {
+        LOG_VULKAN_ERROR(res, "vkCreateCommandPool failed: ");
+        return false;
+      }
+    }
+  }
+
+  for (u32 i = 0; i < num_worker_threads; i++)
+  {
+    m_workers.push_back(std::make_unique<Worker>());
+    m_workers.back()->thread = std::thread(&SecondaryCommandRecorder::WorkerThreadRun, this, i);
+  }
+
+  INFO_LOG(VIDEO, "Recording secondary command buffers with %u worker threads", num_worker_threads);
+  return true;
+}
+
+void SecondaryCommandRecorder::WorkerThreadRun(size_t worker_index)
+{
+  Common::SetCurrentThreadName("Vulkan command recording worker");
+
+  Worker& worker = *m_workers[worker_index];
+  while (true)
+  {
+    worker.start_event.Wait();
+    if (m_exit_flag.IsSet())
+      break;
+
+    RecordJob(worker.job, m_inheritance_info);
+    worker.done_event.Set();
+  }
+}
+
+VkCommandBuffer SecondaryCommandRecorder::AllocateCommandBuffer(Slot& slot, u32 frame_index)
+{
+  std::vector<VkCommandBuffer>& buffers = slot.command_buffers[frame_index];
+  size_t& used = slot.command_buffers_used[frame_index];
+  if (used < buffers.size())
+    return buffers[used++];
+
+  VkCommandBufferAllocateInfo buffer_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                             nullptr, slot.command_pools[frame_index],
+                                             VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1};
+
+  VkCommandBuffer command_buffer;
+  VkResult res =
+      vkAllocateCommandBuffers(g_vulkan_context->GetDevice(), &buffer_info, &command_buffer);
+  if (res != VK_SUCCESS)
+  {
+    LOG_VULKAN_ERROR(res, "vkAllocateCommandBuffers failed: ");
+    return VK_NULL_HANDLE;
+  }
+
+  buffers.push_back(command_buffer);
+  used++;
+  return command_buffer;
+}
+
+bool SecondaryCommandRecorder::Record(const VkCommandBufferInheritanceInfo& inheritance_info,
+                                      const std::vector<GraphicsState>& states,
+                                      const std::vector<Command>& commands,
+                                      std::vector<VkCommandBuffer>* out_command_buffers)
+{
+  const size_t num_buffers =
+      std::min(m_slots.size(), commands.size() / MIN_COMMANDS_PER_BUFFER);
+  if (num_buffers < 2)
+    return false;
+
+  // Recycle the pools for this frame resource once the GPU is done with them.
+  const u32 frame_index = g_command_buffer_mgr->GetCurrentCommandBufferIndex();
+  const u64 fence_counter = g_command_buffer_mgr->GetCurrentFenceCounter();
+  if (m_pool_fence_counters[frame_index] != fence_counter)
+  {
+    for (Slot& slot : m_slots)
+    {
+      vkResetCommandPool(g_vulkan_context->GetDevice(), slot.command_pools[frame_index], 0);
+      slot.command_buffers_used[frame_index] = 0;
+    }
+    m_pool_fence_counters[frame_index] = fence_counter;
+  }
+
+  std::vector<Job> jobs(num_buffers);
+  const size_t commands_per_buffer = (commands.size() + num_buffers - 1) / num_buffers;
+  for (size_t i = 0; i < num_buffers; i++)
+  {
+    // The GPU thread takes the last slot, and the last range of commands.
+    Slot& slot = m_slots[(i == num_buffers - 1) ? (m_slots.size() - 1) : i];
+    jobs[i].command_buffer = AllocateCommandBuffer(slot, frame_index);
+    if (jobs[i].command_buffer == VK_NULL_HANDLE)
+      return false;
+
+    jobs[i].states = &states;
+    jobs[i].begin = commands.data() + std::min(commands.size(), i * commands_per_buffer);
+    jobs[i].end = commands.data() + std::min(commands.size(), (i + 1) * commands_per_buffer);
+  }
+
+  m_inheritance_info = inheritance_info;
+  for (size_t i = 0; i < num_buffers - 1; i++)
+  {
+    m_workers[i]->job = jobs[i];
+    m_workers[i]->start_event.Set();
+  }
+
+  RecordJob(jobs.back(), m_inheritance_info);
+
+  out_command_buffers->clear();
+  for (size_t i = 0; i < num_buffers - 1; i++)
+  {
+    m_workers[i]->done_event.Wait();
+    out_command_buffers->push_back(jobs[i].command_buffer);
+  }
+  out_command_buffers->push_back(jobs.back().command_buffer);
+  return true;
+}
+
+void SecondaryCommandRecorder::RecordJob(const Job& job,
+                                         const VkCommandBufferInheritanceInfo& inheritance_info)
+{
+  VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+                                         VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                             VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+                                         &inheritance_info};
+
+  VkResult res = vkBeginCommandBuffer(job.command_buffer, &begin_info);
+  if (res != VK_SUCCESS)
+    LOG_VULKAN_ERROR(res, "vkBeginCommandBuffer failed: ");
+
+  Replay(job.command_buffer, *job.states, job.begin, job.end);
+
+  res = vkEndCommandBuffer(job.command_buffer);
+  if (res != VK_SUCCESS)
+    LOG_VULKAN_ERROR(res, "vkEndCommandBuffer failed: ");
+}
+
+void SecondaryCommandRecorder::Replay(VkCommandBuffer command_buffer,
+                                      const std::vector<GraphicsState>& states,
+                                      const Command* begin, const Command* end)
+{
+  const GraphicsState* bound = nullptr;
+  for (const Command* cmd = begin; cmd != end; cmd++)
+  {
+    if (cmd->type == Command::Type::ClearAttachments)
+    {
+      vkCmdClearAttachments(command_buffer, cmd->num_clear_attachments,
+                            cmd->clear_attachments.data(), 1, &cmd->clear_rect);
+      continue;
+    }
+
+    const GraphicsState& state = states[cmd->state_index];
+    if (bound != &state)
+    {
+      if (!bound || bound->pipeline != state.pipeline)
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.pipeline);
+
+      if (!bound || bound->pipeline_layout != state.pipeline_layout ||
+          bound->num_descriptor_sets != state.num_descriptor_sets ||
+          bound->descriptor_sets != state.descriptor_sets ||
+          bound->num_dynamic_offsets != state.num_dynamic_offsets ||
+          bound->dynamic_offsets != state.dynamic_offsets)
+      {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                state.pipeline_layout, 0, state.num_descriptor_sets,
+                                state.descriptor_sets.data(), state.num_dynamic_offsets,
+                                state.dynamic_offsets.data());
+      }
+
+      if (!bound || bound->vertex_buffer != state.vertex_buffer ||
+          bound->vertex_buffer_offset != state.vertex_buffer_offset)
+      {
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, &state.vertex_buffer,
+                               &state.vertex_buffer_offset);
+      }
+
+      if (state.index_buffer != VK_NULL_HANDLE &&
+          (!bound || bound->index_buffer != state.index_buffer ||
+           bound->index_buffer_offset != state.index_buffer_offset ||
+           bound->index_type != state.index_type))
+      {
+        vkCmdBindIndexBuffer(command_buffer, state.index_buffer, state.index_buffer_offset,
+                             state.index_type);
+      }
+
+      if (!bound || std::memcmp(&bound->viewport, &state.viewport, sizeof(state.viewport)) != 0)
+        vkCmdSetViewport(command_buffer, 0, 1, &state.viewport);
+
+      if (!bound || std::memcmp(&bound->scissor, &state.scissor, sizeof(state.scissor)) != 0)
+        vkCmdSetScissor(command_buffer, 0, 1, &state.scissor);
+
+      bound = &state;
+    }
+
+    if (cmd->type == Command::Type::Draw)
+      vkCmdDraw(command_buffer, cmd->count, 1, cmd->first, 0);
+    else
+      vkCmdDrawIndexed(command_buffer, cmd->count, 1, cmd->first, cmd->base_vertex, 0);
+  }
+}
+
+}  // namespace Vulkan
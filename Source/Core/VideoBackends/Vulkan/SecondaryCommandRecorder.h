@@ -0,0 +1,132 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
+
+#include "VideoBackends/Vulkan/Constants.h"
+
+namespace Vulkan
+{
+// Records the draws of a render pass into secondary command buffers on multiple threads.
+// The state tracker collects draws as a list of commands, each referring to a snapshot of the
+// bound state, so that any range of the list can be replayed independently of the others.
+class SecondaryCommandRecorder
+{
+public:
+  // Everything which has to be bound to a command buffer before a draw.
+  struct GraphicsState
+  {
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+    std::array<VkDescriptorSet, 3> descriptor_sets;
+    u32 num_descriptor_sets;
+    std::array<u32, NUM_UBO_DESCRIPTOR_SET_BINDINGS> dynamic_offsets;
+    u32 num_dynamic_offsets;
+    VkBuffer vertex_buffer;
+    VkDeviceSize vertex_buffer_offset;
+    VkBuffer index_buffer;
+    VkDeviceSize index_buffer_offset;
+    VkIndexType index_type;
+    VkViewport viewport;
+    VkRect2D scissor;
+  };
+
+  struct Command
+  {
+    enum class Type : u32
+    {
+      Draw,
+      DrawIndexed,
+      ClearAttachments
+    };
+
+    Type type;
+
+    // Index into the state list, only used by draws.
+    u32 state_index;
+
+    // Draw(base_vertex, num_vertices) or DrawIndexed(base_index, num_indices, base_vertex).
+    u32 first;
+    u32 count;
+    s32 base_vertex;
+
+    std::array<VkClearAttachment, 2> clear_attachments;
+    u32 num_clear_attachments;
+    VkClearRect clear_rect;
+  };
+
+  SecondaryCommandRecorder();
+  ~SecondaryCommandRecorder();
+
+  static std::unique_ptr<SecondaryCommandRecorder> Create();
+
+  // Records the given commands to secondary command buffers which continue the render pass
+  // described by inheritance_info. Returns false if there are too few commands to be worth
+  // splitting up, in which case the caller should record them inline with Replay().
+  bool Record(const VkCommandBufferInheritanceInfo& inheritance_info,
+              const std::vector<GraphicsState>& states, const std::vector<Command>& commands,
+              std::vector<VkCommandBuffer>* out_command_buffers);
+
+  // Records a range of commands to a command buffer. Nothing is assumed to be bound.
+  static void Replay(VkCommandBuffer command_buffer, const std::vector<GraphicsState>& states,
+                     const Command* begin, const Command* end);
+
+private:
+  // Commands are only split into multiple command buffers when each receives at least this many.
+  static constexpr size_t MIN_COMMANDS_PER_BUFFER = 32;
+  static constexpr u32 MAX_WORKER_THREADS = 4;
+
+  // A set of command pools, one per frame resource. Each is only used by a single thread.
+  struct Slot
+  {
+    std::array<VkCommandPool, NUM_COMMAND_BUFFERS> command_pools = {};
+    std::array<std::vector<VkCommandBuffer>, NUM_COMMAND_BUFFERS> command_buffers;
+    std::array<size_t, NUM_COMMAND_BUFFERS> command_buffers_used = {};
+  };
+
+  struct Job
+  {
+    const std::vector<GraphicsState>* states;
+    const Command* begin;
+    const Command* end;
+    VkCommandBuffer command_buffer;
+  };
+
+  struct Worker
+  {
+    std::thread thread;
+    Common::Event start_event;
+    Common::Event done_event;
+    Job job;
+  };
+
+  bool Initialize(u32 num_worker_threads);
+  void WorkerThreadRun(size_t worker_index);
+
+  VkCommandBuffer AllocateCommandBuffer(Slot& slot, u32 frame_index);
+  static void RecordJob(const Job& job, const VkCommandBufferInheritanceInfo& inheritance_info);
+
+  // The last slot belongs to the GPU thread, which records a share of the commands itself.
+  std::vector<Slot> m_slots;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  Common::Flag m_exit_flag;
+
+  // Fence counter of the command buffer the pools were last used for. Pools are reset when a
+  // frame resource is reused, at which point the GPU has finished with them.
+  std::array<u64, NUM_COMMAND_BUFFERS> m_pool_fence_counters = {};
+
+  VkCommandBufferInheritanceInfo m_inheritance_info = {};
+};
+
+}  // namespace Vulkan
@@ -4,6 +4,8 @@
 
 #include "VideoBackends/Vulkan/StateTracker.h"
 
+#include <algorithm>
+
 #include "Common/Assert.h"
 
 #include "VideoBackends/Vulkan/CommandBufferManager.h"
@@ -255,19 +257,7 @@ void StateTracker::BeginRenderPass()
   if (InRenderPass())
     return;
 
-  m_current_render_pass = m_framebuffer->GetLoadRenderPass();
-  m_framebuffer_render_area = m_framebuffer->GetRect();
-
-  VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                                      nullptr,
-                                      m_current_render_pass,
-                                      m_framebuffer->GetFB(),
-                                      m_framebuffer_render_area,
-                                      0,
-                                      nullptr};
-
-  vkCmdBeginRenderPass(g_command_buffer_mgr->GetCurrentCommandBuffer(), &begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
+  BeginRenderPass(m_framebuffer->GetLoadRenderPass(), m_framebuffer->GetRect(), nullptr, 0);
 }
 
 void StateTracker::BeginDiscardRenderPass()
@@ -275,19 +265,13 @@ void StateTracker::BeginDiscardRenderPass()
   if (InRenderPass())
     return;
 
-  m_current_render_pass = m_framebuffer->GetDiscardRenderPass();
-  m_framebuffer_render_area = m_framebuffer->GetRect();
-
-  VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                                      nullptr,
-                                      m_current_render_pass,
-                                      m_framebuffer->GetFB(),
-                                      m_framebuffer_render_area,
-                                      0,
-                                      nullptr};
+  BeginRenderPass(m_framebuffer->GetDiscardRenderPass(), m_framebuffer->GetRect(), nullptr, 0);
+}
 
-  vkCmdBeginRenderPass(g_command_buffer_mgr->GetCurrentCommandBuffer(), &begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
+void StateTracker::BeginInlineRenderPass()
+{
+  BeginRenderPass();
+  FlushDeferredRenderPass(false);
 }
 
 void StateTracker::EndRenderPass()
@@ -295,6 +279,7 @@ void StateTracker::EndRenderPass()
   if (!InRenderPass())
     return;
 
+  FlushDeferredRenderPass(true);
   vkCmdEndRenderPass(g_command_buffer_mgr->GetCurrentCommandBuffer());
   m_current_render_pass = VK_NULL_HANDLE;
 }
@@ -304,9 +289,24 @@ void StateTracker::BeginClearRenderPass(const VkRect2D& area, const VkClearValue
 {
   ASSERT(!InRenderPass());
 
-  m_current_render_pass = m_framebuffer->GetClearRenderPass();
+  BeginRenderPass(m_framebuffer->GetClearRenderPass(), area, clear_values, num_clear_values);
+}
+
+void StateTracker::BeginRenderPass(VkRenderPass render_pass, const VkRect2D& area,
+                                   const VkClearValue* clear_values, u32 num_clear_values)
+{
+  m_current_render_pass = render_pass;
   m_framebuffer_render_area = area;
 
+  if (UseParallelRecording())
+  {
+    ASSERT(num_clear_values <= m_deferred_clear_values.size());
+    std::copy_n(clear_values, num_clear_values, m_deferred_clear_values.begin());
+    m_num_deferred_clear_values = num_clear_values;
+    m_render_pass_deferred = true;
+    return;
+  }
+
   VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
                                       nullptr,
                                       m_current_render_pass,
@@ -319,6 +319,119 @@ void StateTracker::BeginClearRenderPass(const VkRect2D& area, const VkClearValue
                        VK_SUBPASS_CONTENTS_INLINE);
 }
 
+bool StateTracker::UseParallelRecording()
+{
+  // The recorder is kept around when the option is disabled, as its command buffers may still
+  // be in use by the GPU.
+  if (!g_ActiveConfig.bParallelCommandRecording || m_secondary_recorder_failed)
+    return false;
+
+  if (!m_secondary_recorder)
+  {
+    m_secondary_recorder = SecondaryCommandRecorder::Create();
+    if (!m_secondary_recorder)
+    {
+      WARN_LOG(VIDEO, "Failed to create secondary command recorder, recording on one thread");
+      m_secondary_recorder_failed = true;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void StateTracker::FlushDeferredRenderPass(bool allow_secondary_command_buffers)
+{
+  if (!m_render_pass_deferred)
+    return;
+
+  m_render_pass_deferred = false;
+
+  // Fall back to recording on this thread when there are not enough draws to be worth the
+  // overhead, or when the caller needs to record its own commands within the render pass.
+  const VkCommandBufferInheritanceInfo inheritance_info = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+      nullptr,
+      m_current_render_pass,
+      0,
+      m_framebuffer->GetFB(),
+      VK_FALSE,
+      0,
+      0};
+  const bool use_secondary_command_buffers =
+      allow_secondary_command_buffers &&
+      m_secondary_recorder->Record(inheritance_info, m_deferred_states, m_deferred_commands,
+                                   &m_secondary_command_buffers);
+
+  VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                                      nullptr,
+                                      m_current_render_pass,
+                                      m_framebuffer->GetFB(),
+                                      m_framebuffer_render_area,
+                                      m_num_deferred_clear_values,
+                                      m_deferred_clear_values.data()};
+
+  const VkCommandBuffer command_buffer = g_command_buffer_mgr->GetCurrentCommandBuffer();
+  if (use_secondary_command_buffers)
+  {
+    vkCmdBeginRenderPass(command_buffer, &begin_info,
+                         VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(command_buffer, static_cast<u32>(m_secondary_command_buffers.size()),
+                         m_secondary_command_buffers.data());
+  }
+  else
+  {
+    vkCmdBeginRenderPass(command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    SecondaryCommandRecorder::Replay(command_buffer, m_deferred_states,
+                                     m_deferred_commands.data(),
+                                     m_deferred_commands.data() + m_deferred_commands.size());
+  }
+
+  m_deferred_states.clear();
+  m_deferred_commands.clear();
+
+  // Nothing which was bound while deferring is bound in the primary command buffer.
+  m_dirty_flags |=
+      DIRTY_FLAG_PIPELINE | DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_VIEWPORT | DIRTY_FLAG_SCISSOR;
+  if (m_vertex_buffer != VK_NULL_HANDLE)
+    m_dirty_flags |= DIRTY_FLAG_VERTEX_BUFFER;
+  if (m_index_buffer != VK_NULL_HANDLE)
+    m_dirty_flags |= DIRTY_FLAG_INDEX_BUFFER;
+}
+
+SecondaryCommandRecorder::GraphicsState StateTracker::GetGraphicsState() const
+{
+  SecondaryCommandRecorder::GraphicsState state = {};
+  state.pipeline = m_pipeline->GetVkPipeline();
+  state.pipeline_layout = m_pipeline->GetVkPipelineLayout();
+  if (m_pipeline->GetUsage() == AbstractPipelineUsage::GX)
+  {
+    std::copy(m_gx_descriptor_sets.begin(), m_gx_descriptor_sets.end(),
+              state.descriptor_sets.begin());
+    state.num_descriptor_sets = g_ActiveConfig.backend_info.bSupportsBBox ?
+                                    NUM_GX_DESCRIPTOR_SETS :
+                                    (NUM_GX_DESCRIPTOR_SETS - 1);
+    state.dynamic_offsets = m_bindings.gx_ubo_offsets;
+    state.num_dynamic_offsets = NUM_UBO_DESCRIPTOR_SET_BINDINGS;
+  }
+  else
+  {
+    std::copy(m_utility_descriptor_sets.begin(), m_utility_descriptor_sets.end(),
+              state.descriptor_sets.begin());
+    state.num_descriptor_sets = NUM_UTILITY_DESCRIPTOR_SETS;
+    state.dynamic_offsets[0] = m_bindings.utility_ubo_offset;
+    state.num_dynamic_offsets = 1;
+  }
+  state.vertex_buffer = m_vertex_buffer;
+  state.vertex_buffer_offset = m_vertex_buffer_offset;
+  state.index_buffer = m_index_buffer;
+  state.index_buffer_offset = m_index_buffer_offset;
+  state.index_type = m_index_type;
+  state.viewport = m_viewport;
+  state.scissor = m_scissor;
+  return state;
+}
+
 void StateTracker::SetViewport(const VkViewport& viewport)
 {
   if (memcmp(&m_viewport, &viewport, sizeof(viewport)) == 0)
@@ -365,8 +478,25 @@ bool StateTracker::Bind()
   if (!InRenderPass())
     BeginRenderPass();
 
+  constexpr u32 GRAPHICS_STATE_DIRTY_FLAGS =
+      DIRTY_FLAG_VERTEX_BUFFER | DIRTY_FLAG_INDEX_BUFFER | DIRTY_FLAG_PIPELINE |
+      DIRTY_FLAG_VIEWPORT | DIRTY_FLAG_SCISSOR | DIRTY_FLAG_DESCRIPTOR_SETS |
+      DIRTY_FLAG_GX_UBO_OFFSETS | DIRTY_FLAG_UTILITY_UBO_OFFSET;
+  if (m_render_pass_deferred)
+  {
+    // Take a snapshot of the state for the following draws, which is bound when they are
+    // recorded at the end of the render pass.
+    if (m_deferred_states.empty() || m_dirty_flags & GRAPHICS_STATE_DIRTY_FLAGS)
+      m_deferred_states.push_back(GetGraphicsState());
+
+    m_dirty_flags &= ~GRAPHICS_STATE_DIRTY_FLAGS;
+    return true;
+  }
+
   // Re-bind parts of the pipeline
   const VkCommandBuffer command_buffer = g_command_buffer_mgr->GetCurrentCommandBuffer();
+  BindDescriptorSets(command_buffer);
+
   if (m_dirty_flags & DIRTY_FLAG_VERTEX_BUFFER)
     vkCmdBindVertexBuffers(command_buffer, 0, 1, &m_vertex_buffer, &m_vertex_buffer_offset);
 
@@ -387,6 +517,60 @@ bool StateTracker::Bind()
   return true;
 }
 
+void StateTracker::Draw(u32 base_vertex, u32 num_vertices)
+{
+  if (!m_render_pass_deferred)
+  {
+    vkCmdDraw(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_vertices, 1, base_vertex, 0);
+    return;
+  }
+
+  SecondaryCommandRecorder::Command cmd = {};
+  cmd.type = SecondaryCommandRecorder::Command::Type::Draw;
+  cmd.state_index = static_cast<u32>(m_deferred_states.size() - 1);
+  cmd.first = base_vertex;
+  cmd.count = num_vertices;
+  m_deferred_commands.push_back(cmd);
+}
+
+void StateTracker::DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex)
+{
+  if (!m_render_pass_deferred)
+  {
+    vkCmdDrawIndexed(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_indices, 1, base_index,
+                     base_vertex, 0);
+    return;
+  }
+
+  SecondaryCommandRecorder::Command cmd = {};
+  cmd.type = SecondaryCommandRecorder::Command::Type::DrawIndexed;
+  cmd.state_index = static_cast<u32>(m_deferred_states.size() - 1);
+  cmd.first = base_index;
+  cmd.count = num_indices;
+  cmd.base_vertex = static_cast<s32>(base_vertex);
+  m_deferred_commands.push_back(cmd);
+}
+
+void StateTracker::ClearAttachments(u32 num_attachments, const VkClearAttachment* attachments,
+                                    const VkClearRect& rect)
+{
+  ASSERT(InRenderPass());
+  if (!m_render_pass_deferred)
+  {
+    vkCmdClearAttachments(g_command_buffer_mgr->GetCurrentCommandBuffer(), num_attachments,
+                          attachments, 1, &rect);
+    return;
+  }
+
+  SecondaryCommandRecorder::Command cmd = {};
+  cmd.type = SecondaryCommandRecorder::Command::Type::ClearAttachments;
+  ASSERT(num_attachments <= cmd.clear_attachments.size());
+  std::copy_n(attachments, num_attachments, cmd.clear_attachments.begin());
+  cmd.num_clear_attachments = num_attachments;
+  cmd.clear_rect = rect;
+  m_deferred_commands.push_back(cmd);
+}
+
 bool StateTracker::BindCompute()
 {
   if (!m_compute_shader)
@@ -535,26 +719,6 @@ bool StateTracker::UpdateGXDescriptorSet()
   if (num_writes > 0)
     vkUpdateDescriptorSets(g_vulkan_context->GetDevice(), num_writes, writes.data(), 0, nullptr);
 
-  if (m_dirty_flags & DIRTY_FLAG_DESCRIPTOR_SETS)
-  {
-    vkCmdBindDescriptorSets(g_command_buffer_mgr->GetCurrentCommandBuffer(),
-                            VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->GetVkPipelineLayout(), 0,
-                            g_ActiveConfig.backend_info.bSupportsBBox ?
-                                NUM_GX_DESCRIPTOR_SETS :
-                                (NUM_GX_DESCRIPTOR_SETS - 1),
-                            m_gx_descriptor_sets.data(), NUM_UBO_DESCRIPTOR_SET_BINDINGS,
-                            m_bindings.gx_ubo_offsets.data());
-    m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_GX_UBO_OFFSETS);
-  }
-  else if (m_dirty_flags & DIRTY_FLAG_GX_UBO_OFFSETS)
-  {
-    vkCmdBindDescriptorSets(g_command_buffer_mgr->GetCurrentCommandBuffer(),
-                            VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->GetVkPipelineLayout(), 0,
-                            1, m_gx_descriptor_sets.data(), NUM_UBO_DESCRIPTOR_SET_BINDINGS,
-                            m_bindings.gx_ubo_offsets.data());
-    m_dirty_flags &= ~DIRTY_FLAG_GX_UBO_OFFSETS;
-  }
-
   return true;
 }
 
@@ -620,23 +784,50 @@ bool StateTracker::UpdateUtilityDescriptorSet()
   if (writes > 0)
     vkUpdateDescriptorSets(g_vulkan_context->GetDevice(), writes, dswrites.data(), 0, nullptr);
 
-  if (m_dirty_flags & DIRTY_FLAG_DESCRIPTOR_SETS)
+  return true;
+}
+
+void StateTracker::BindDescriptorSets(VkCommandBuffer command_buffer)
+{
+  if (m_pipeline->GetUsage() == AbstractPipelineUsage::GX)
   {
-    vkCmdBindDescriptorSets(g_command_buffer_mgr->GetCurrentCommandBuffer(),
-                            VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->GetVkPipelineLayout(), 0,
-                            NUM_UTILITY_DESCRIPTOR_SETS, m_utility_descriptor_sets.data(), 1,
-                            &m_bindings.utility_ubo_offset);
-    m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_UTILITY_UBO_OFFSET);
+    if (m_dirty_flags & DIRTY_FLAG_DESCRIPTOR_SETS)
+    {
+      vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_pipeline->GetVkPipelineLayout(), 0,
+                              g_ActiveConfig.backend_info.bSupportsBBox ?
+                                  NUM_GX_DESCRIPTOR_SETS :
+                                  (NUM_GX_DESCRIPTOR_SETS - 1),
+                              m_gx_descriptor_sets.data(), NUM_UBO_DESCRIPTOR_SET_BINDINGS,
+                              m_bindings.gx_ubo_offsets.data());
+      m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_GX_UBO_OFFSETS);
+    }
+    else if (m_dirty_flags & DIRTY_FLAG_GX_UBO_OFFSETS)
+    {
+      vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_pipeline->GetVkPipelineLayout(), 0, 1,
+                              m_gx_descriptor_sets.data(), NUM_UBO_DESCRIPTOR_SET_BINDINGS,
+                              m_bindings.gx_ubo_offsets.data());
+      m_dirty_flags &= ~DIRTY_FLAG_GX_UBO_OFFSETS;
+    }
   }
-  else if (m_dirty_flags & DIRTY_FLAG_UTILITY_UBO_OFFSET)
+  else
   {
-    vkCmdBindDescriptorSets(g_command_buffer_mgr->GetCurrentCommandBuffer(),
-                            VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline->GetVkPipelineLayout(), 0,
-                            1, m_utility_descriptor_sets.data(), 1, &m_bindings.utility_ubo_offset);
-    m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_UTILITY_UBO_OFFSET);
+    if (m_dirty_flags & DIRTY_FLAG_DESCRIPTOR_SETS)
+    {
+      vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_pipeline->GetVkPipelineLayout(), 0, NUM_UTILITY_DESCRIPTOR_SETS,
+                              m_utility_descriptor_sets.data(), 1, &m_bindings.utility_ubo_offset);
+      m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_UTILITY_UBO_OFFSET);
+    }
+    else if (m_dirty_flags & DIRTY_FLAG_UTILITY_UBO_OFFSET)
+    {
+      vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_pipeline->GetVkPipelineLayout(), 0, 1,
+                              m_utility_descriptor_sets.data(), 1, &m_bindings.utility_ubo_offset);
+      m_dirty_flags &= ~(DIRTY_FLAG_DESCRIPTOR_SETS | DIRTY_FLAG_UTILITY_UBO_OFFSET);
+    }
   }
-
-  return true;
 }
 
 bool StateTracker::UpdateComputeDescriptorSet()
@@ -7,9 +7,11 @@
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "VideoBackends/Vulkan/Constants.h"
+#include "VideoBackends/Vulkan/SecondaryCommandRecorder.h"
 #include "VideoCommon/RenderBase.h"
 
 namespace Vulkan
@@ -59,6 +61,13 @@ public:
   void BeginDiscardRenderPass();
   void EndRenderPass();
 
+  // When parallel command recording is enabled, render passes are not started in the command
+  // buffer until they end, so that their draws can be recorded to secondary command buffers.
+  // This begins a render pass if needed, and ensures it has been started in the primary command
+  // buffer so that commands can be recorded to it directly. Draws which were deferred so far
+  // are recorded on the calling thread.
+  void BeginInlineRenderPass();
+
   // Ends the current render pass if it was a clear render pass.
   void BeginClearRenderPass(const VkRect2D& area, const VkClearValue* clear_values,
                             u32 num_clear_values);
@@ -71,6 +80,14 @@ public:
   // If this returns false, you should not issue the draw.
   bool Bind();
 
+  // Records a draw with the state bound by the last successful call to Bind().
+  void Draw(u32 base_vertex, u32 num_vertices);
+  void DrawIndexed(u32 base_index, u32 num_indices, u32 base_vertex);
+
+  // Clears attachments of the framebuffer within the current render pass.
+  void ClearAttachments(u32 num_attachments, const VkClearAttachment* attachments,
+                        const VkClearRect& rect);
+
   // Binds all dirty compute state to the command buffer.
   // If this returns false, you should not dispatch the shader.
   bool BindCompute();
@@ -113,6 +130,16 @@ private:
 
   bool Initialize();
 
+  void BeginRenderPass(VkRenderPass render_pass, const VkRect2D& area,
+                       const VkClearValue* clear_values, u32 num_clear_values);
+
+  // Returns true if draws in new render passes should be deferred to secondary command buffers.
+  bool UseParallelRecording();
+
+  // Starts the deferred render pass in the primary command buffer, and records its draws.
+  void FlushDeferredRenderPass(bool allow_secondary_command_buffers);
+  SecondaryCommandRecorder::GraphicsState GetGraphicsState() const;
+
   // Check that the specified viewport is within the render area.
   // If not, ends the render pass if it is a clear render pass.
   bool IsViewportWithinRenderArea() const;
@@ -121,6 +148,7 @@ private:
   bool UpdateGXDescriptorSet();
   bool UpdateUtilityDescriptorSet();
   bool UpdateComputeDescriptorSet();
+  void BindDescriptorSets(VkCommandBuffer command_buffer);
 
   // Which bindings/state has to be updated before the next draw.
   u32 m_dirty_flags = 0;
@@ -162,5 +190,15 @@ private:
   VKFramebuffer* m_framebuffer = nullptr;
   VkRenderPass m_current_render_pass = VK_NULL_HANDLE;
   VkRect2D m_framebuffer_render_area = {};
+
+  // parallel command recording
+  std::unique_ptr<SecondaryCommandRecorder> m_secondary_recorder;
+  bool m_secondary_recorder_failed = false;
+  bool m_render_pass_deferred = false;
+  std::array<VkClearValue, 2> m_deferred_clear_values = {};
+  u32 m_num_deferred_clear_values = 0;
+  std::vector<SecondaryCommandRecorder::GraphicsState> m_deferred_states;
+  std::vector<SecondaryCommandRecorder::Command> m_deferred_commands;
+  std::vector<VkCommandBuffer> m_secondary_command_buffers;
 };
 }  // namespace Vulkan
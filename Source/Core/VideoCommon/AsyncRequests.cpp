@@ -4,7 +4,10 @@
 
 #include <mutex>
 
+#include "Common/Timer.h"
+
 #include "VideoCommon/AsyncRequests.h"
+#include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/Statistics.h"
@@ -48,6 +51,7 @@ void AsyncRequests::PullEventsInternal()
         d.x = e.efb_poke.x;
         d.y = e.efb_poke.y;
         m_merged_efb_pokes.push_back(d);
+        INCSTAT(g_stats.this_frame.num_efb_pokes);
 
         m_queue.pop();
       } while (!m_queue.empty() && m_queue.front().type == first_event.type);
@@ -72,21 +76,21 @@ void AsyncRequests::PullEventsInternal()
   }
 }
 
-void AsyncRequests::PushEvent(const AsyncRequests::Event& event, bool blocking)
+bool AsyncRequests::PushEvent(const AsyncRequests::Event& event, bool blocking)
 {
   std::unique_lock<std::mutex> lock(m_mutex);
 
   if (m_passthrough)
   {
     HandleEvent(event);
-    return;
+    return true;
   }
 
   m_empty.Clear();
   m_wake_me_up_again |= blocking;
 
   if (!m_enable)
-    return;
+    return false;
 
   m_queue.push(event);
 
@@ -95,6 +99,8 @@ void AsyncRequests::PushEvent(const AsyncRequests::Event& event, bool blocking)
   {
     m_cond.wait(lock, [this] { return m_queue.empty(); });
   }
+
+  return true;
 }
 
 void AsyncRequests::SetEnable(bool enable)
@@ -107,6 +113,7 @@ void AsyncRequests::SetEnable(bool enable)
     // flush the queue on disabling
     while (!m_queue.empty())
       m_queue.pop();
+    BoundingBox::readback_pending = false;
     if (m_wake_me_up_again)
       m_cond.notify_all();
   }
@@ -149,7 +156,22 @@ void AsyncRequests::HandleEvent(const AsyncRequests::Event& e)
     break;
 
   case Event::BBOX_READ:
+  {
     *e.bbox.data = g_renderer->BBoxRead(e.bbox.index);
+    BoundingBox::readback_values[e.bbox.index] = *e.bbox.data;
+
+    // The CPU thread has been waiting since the event was created.
+    INCSTAT(g_stats.this_frame.num_bbox_syncs);
+    ADDSTAT(g_stats.this_frame.bbox_stall_time_us,
+            static_cast<int>(Common::Timer::GetTimeUs() - e.time));
+  }
+  break;
+
+  case Event::BBOX_READBACK:
+    INCSTAT(g_stats.this_frame.num_bbox_readbacks);
+    for (size_t i = 0; i < BoundingBox::readback_values.size(); i++)
+      BoundingBox::readback_values[i] = g_renderer->BBoxRead(static_cast<int>(i));
+    BoundingBox::readback_pending = false;
     break;
 
   case Event::PERF_QUERY:
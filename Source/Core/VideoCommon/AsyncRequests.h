@@ -28,6 +28,7 @@ public:
       EFB_PEEK_Z,
       SWAP_EVENT,
       BBOX_READ,
+      BBOX_READBACK,
       PERF_QUERY,
       DO_SAVE_STATE,
     } type;
@@ -81,7 +82,8 @@ public:
     if (!m_empty.IsSet())
       PullEventsInternal();
   }
-  void PushEvent(const Event& event, bool blocking = false);
+  // Returns false if the event was dropped because requests are disabled.
+  bool PushEvent(const Event& event, bool blocking = false);
   void SetEnable(bool enable);
   void SetPassthrough(bool enable);
 
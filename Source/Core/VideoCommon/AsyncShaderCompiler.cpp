@@ -3,7 +3,11 @@
 // Refer to the license.txt file included.
 
 #include "VideoCommon/AsyncShaderCompiler.h"
+
+#include <algorithm>
+#include <iterator>
 #include <thread>
+
 #include "Common/Assert.h"
 #include "Common/Logging/Log.h"
 
@@ -11,6 +15,9 @@ namespace VideoCommon
 {
 AsyncShaderCompiler::AsyncShaderCompiler()
 {
+  // There is always at least one queue, so that work which is queued while the worker threads
+  // are being resized is not lost.
+  m_worker_queues.push_back(std::make_unique<WorkerQueue>());
 }
 
 AsyncShaderCompiler::~AsyncShaderCompiler()
@@ -20,41 +27,73 @@ AsyncShaderCompiler::~AsyncShaderCompiler()
   ASSERT(!HasWorkerThreads());
 }
 
-void AsyncShaderCompiler::QueueWorkItem(WorkItemPtr item, u32 priority)
+void AsyncShaderCompiler::QueueWorkItem(WorkItemPtr item, Priority priority)
 {
+  QueuedItem queued_item{std::move(item), priority, Clock::now(), false};
+
   // If no worker threads are available, compile synchronously.
   if (!HasWorkerThreads())
   {
-    item->Compile();
-    m_completed_work.push_back(std::move(item));
+    if (queued_item.item->Compile())
+      PushCompletedItem(std::move(queued_item));
+    return;
   }
-  else
+
+  // Distribute new work round-robin, idle workers will steal from busy ones.
+  WorkerQueue& queue = *m_worker_queues[m_next_worker_queue];
+  m_next_worker_queue = (m_next_worker_queue + 1) % m_worker_queues.size();
   {
-    std::lock_guard<std::mutex> guard(m_pending_work_lock);
-    m_pending_work.emplace(priority, std::move(item));
-    m_worker_thread_wake.notify_one();
+    std::lock_guard<std::mutex> guard(queue.lock);
+    queue.lanes[static_cast<size_t>(priority)].push_back(std::move(queued_item));
+    m_pending_counts[static_cast<size_t>(priority)]++;
   }
+
+  {
+    std::lock_guard<std::mutex> guard(m_wake_lock);
+    m_wake_counter++;
+  }
+  m_worker_thread_wake.notify_one();
 }
 
 void AsyncShaderCompiler::RetrieveWorkItems()
 {
-  std::deque<WorkItemPtr> completed_work;
+  std::deque<QueuedItem> completed_work;
   {
     std::lock_guard<std::mutex> guard(m_completed_work_lock);
     m_completed_work.swap(completed_work);
   }
 
+  const Clock::time_point now = Clock::now();
   while (!completed_work.empty())
   {
-    completed_work.front()->Retrieve();
+    QueuedItem& queued_item = completed_work.front();
+    LaneMetrics& metrics = m_metrics[static_cast<size_t>(queued_item.priority)];
+    if (queued_item.cancelled)
+    {
+      queued_item.item->Cancel();
+      metrics.items_cancelled++;
+    }
+    else
+    {
+      queued_item.item->Retrieve();
+
+      const u64 latency_us = static_cast<u64>(
+          std::chrono::duration_cast<std::chrono::microseconds>(now - queued_item.queue_time)
+              .count());
+      metrics.items_retrieved++;
+      metrics.total_latency_us += latency_us;
+      metrics.max_latency_us = std::max(metrics.max_latency_us, latency_us);
+    }
+
     completed_work.pop_front();
   }
 }
 
 bool AsyncShaderCompiler::HasPendingWork()
 {
-  std::lock_guard<std::mutex> guard(m_pending_work_lock);
-  return !m_pending_work.empty() || m_busy_workers.load() != 0;
+  // Workers increment the busy count before removing an item from the queues, so checking the
+  // queues first guarantees we can't miss an item in transit.
+  return GetPendingItemCount() != 0 || m_busy_workers.load() != 0;
 }
 
 bool AsyncShaderCompiler::HasCompletedWork()
@@ -63,6 +102,33 @@ bool AsyncShaderCompiler::HasCompletedWork()
   return !m_completed_work.empty();
 }
 
+void AsyncShaderCompiler::CancelPendingWork(Priority priority)
+{
+  const size_t lane = static_cast<size_t>(priority);
+  for (auto& queue : m_worker_queues)
+  {
+    std::deque<QueuedItem> cancelled_items;
+    {
+      std::lock_guard<std::mutex> guard(queue->lock);
+      queue->lanes[lane].swap(cancelled_items);
+      m_pending_counts[lane] -= cancelled_items.size();
+    }
+
+    std::lock_guard<std::mutex> guard(m_completed_work_lock);
+    for (QueuedItem& queued_item : cancelled_items)
+    {
+      queued_item.cancelled = true;
+      m_completed_work.push_back(std::move(queued_item));
+    }
+  }
+}
+
+void AsyncShaderCompiler::CancelPendingWork()
+{
+  for (size_t i = 0; i < NUM_PRIORITIES; i++)
+    CancelPendingWork(static_cast<Priority>(i));
+}
+
 void AsyncShaderCompiler::WaitUntilCompletion()
 {
   while (HasPendingWork())
@@ -89,33 +155,42 @@ void AsyncShaderCompiler::WaitUntilCompletion(
   // Grab the number of pending items. We use this to work out how many are left.
   size_t total_items = 0;
   {
-    // Safe to hold both locks here, since nowhere else does.
-    std::lock_guard<std::mutex> pending_guard(m_pending_work_lock);
     std::lock_guard<std::mutex> completed_guard(m_completed_work_lock);
-    total_items = m_completed_work.size() + m_pending_work.size() + m_busy_workers.load() + 1;
+    total_items = m_completed_work.size() + GetPendingItemCount() + m_busy_workers.load() + 1;
   }
 
   // Update progress while the compiles complete.
-  for (;;)
+  while (HasPendingWork())
   {
-    size_t remaining_items;
-    {
-      std::lock_guard<std::mutex> pending_guard(m_pending_work_lock);
-      if (m_pending_work.empty() && !m_busy_workers.load())
-        break;
-      remaining_items = m_pending_work.size();
-    }
-
+    const size_t remaining_items = std::min(GetPendingItemCount(), total_items);
     progress_callback(total_items - remaining_items, total_items);
     std::this_thread::sleep_for(CHECK_INTERVAL);
   }
 }
 
+AsyncShaderCompiler::Metrics AsyncShaderCompiler::GetMetrics() const
+{
+  Metrics metrics = m_metrics;
+  for (size_t i = 0; i < NUM_PRIORITIES; i++)
+    metrics[i].queue_depth = m_pending_counts[i].load();
+  return metrics;
+}
+
+void AsyncShaderCompiler::ResetMetrics()
+{
+  m_metrics = {};
+}
+
 bool AsyncShaderCompiler::StartWorkerThreads(u32 num_worker_threads)
 {
   if (num_worker_threads == 0)
     return true;
 
+  // Each worker gets its own queue. Any work left over from a previous set of workers stays in
+  // the first queue, and is spread out by stealing.
+  while (m_worker_queues.size() < num_worker_threads)
+    m_worker_queues.push_back(std::make_unique<WorkerQueue>());
+
   for (u32 i = 0; i < num_worker_threads; i++)
   {
     void* thread_param = nullptr;
@@ -127,7 +202,8 @@ bool AsyncShaderCompiler::StartWorkerThreads(u32 num_worker_threads)
 
     m_worker_thread_start_result.store(false);
 
-    std::thread thr(&AsyncShaderCompiler::WorkerThreadEntryPoint, this, thread_param);
+    std::thread thr(&AsyncShaderCompiler::WorkerThreadEntryPoint, this, thread_param,
+                    static_cast<size_t>(i));
     m_init_event.Wait();
 
     if (!m_worker_thread_start_result.load())
@@ -164,16 +240,30 @@ void AsyncShaderCompiler::StopWorkerThreads()
 
   // Signal worker threads to stop, and wake all of them.
   {
-    std::lock_guard<std::mutex> guard(m_pending_work_lock);
+    std::lock_guard<std::mutex> guard(m_wake_lock);
     m_exit_flag.Set();
-    m_worker_thread_wake.notify_all();
   }
+  m_worker_thread_wake.notify_all();
 
   // Wait for worker threads to exit.
   for (std::thread& thr : m_worker_threads)
     thr.join();
   m_worker_threads.clear();
   m_exit_flag.Clear();
+
+  // Fold any remaining work back into the first queue, preserving the order within each lane.
+  WorkerQueue& first_queue = *m_worker_queues.front();
+  for (size_t i = 1; i < m_worker_queues.size(); i++)
+  {
+    for (size_t lane = 0; lane < NUM_PRIORITIES; lane++)
+    {
+      auto& src = m_worker_queues[i]->lanes[lane];
+      auto& dst = first_queue.lanes[lane];
+      std::move(src.begin(), src.end(), std::back_inserter(dst));
+    }
+  }
+  m_worker_queues.resize(1);
+  m_next_worker_queue = 0;
 }
 
 bool AsyncShaderCompiler::WorkerThreadInitMainThread(void** param)
@@ -190,7 +280,7 @@ void AsyncShaderCompiler::WorkerThreadExit(void* param)
 {
 }
 
-void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param)
+void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param, size_t worker_index)
 {
   // Initialize worker thread with backend-specific method.
   if (!WorkerThreadInitWorkerThread(param))
@@ -204,36 +294,95 @@ void AsyncShaderCompiler::WorkerThreadEntryPoint(void* param)
   m_worker_thread_start_result.store(true);
   m_init_event.Set();
 
-  WorkerThreadRun();
+  WorkerThreadRun(worker_index);
 
   WorkerThreadExit(param);
 }
 
-void AsyncShaderCompiler::WorkerThreadRun()
+void AsyncShaderCompiler::WorkerThreadRun(size_t worker_index)
 {
-  std::unique_lock<std::mutex> pending_lock(m_pending_work_lock);
-  while (!m_exit_flag.IsSet())
+  for (;;)
   {
-    m_worker_thread_wake.wait(pending_lock);
+    u64 observed_wake_counter;
+    {
+      std::lock_guard<std::mutex> guard(m_wake_lock);
+      if (m_exit_flag.IsSet())
+        break;
+      observed_wake_counter = m_wake_counter;
+    }
 
-    while (!m_pending_work.empty() && !m_exit_flag.IsSet())
+    // Flag ourselves as busy before taking the item, see HasPendingWork().
+    m_busy_workers++;
+    QueuedItem queued_item;
+    if (TryTakeWorkItem(worker_index, &queued_item))
     {
-      m_busy_workers++;
-      auto iter = m_pending_work.begin();
-      WorkItemPtr item(std::move(iter->second));
-      m_pending_work.erase(iter);
-      pending_lock.unlock();
+      if (queued_item.item->Compile())
+        PushCompletedItem(std::move(queued_item));
+
+      m_busy_workers--;
+      continue;
+    }
+    m_busy_workers--;
+
+    // Nothing to do, sleep until something new is queued.
+    std::unique_lock<std::mutex> wake_lock(m_wake_lock);
+    m_worker_thread_wake.wait(wake_lock, [&] {
+      return m_exit_flag.IsSet() || m_wake_counter != observed_wake_counter;
+    });
+  }
+}
 
-      if (item->Compile())
+bool AsyncShaderCompiler::TryTakeWorkItem(size_t worker_index, QueuedItem* out_item)
+{
+  const size_t num_queues = m_worker_queues.size();
+  for (size_t lane = 0; lane < NUM_PRIORITIES; lane++)
+  {
+    if (m_pending_counts[lane].load() == 0)
+      continue;
+
+    // Own queue first, oldest item first.
+    {
+      WorkerQueue& queue = *m_worker_queues[worker_index];
+      std::lock_guard<std::mutex> guard(queue.lock);
+      if (!queue.lanes[lane].empty())
       {
-        std::lock_guard<std::mutex> completed_guard(m_completed_work_lock);
-        m_completed_work.push_back(std::move(item));
+        *out_item = std::move(queue.lanes[lane].front());
+        queue.lanes[lane].pop_front();
+        m_pending_counts[lane]--;
+        return true;
       }
+    }
 
-      pending_lock.lock();
-      m_busy_workers--;
+    // Steal the newest item from another worker, so the owner keeps its queue order.
+    for (size_t i = 1; i < num_queues; i++)
+    {
+      WorkerQueue& queue = *m_worker_queues[(worker_index + i) % num_queues];
+      std::lock_guard<std::mutex> guard(queue.lock);
+      if (!queue.lanes[lane].empty())
+      {
+        *out_item = std::move(queue.lanes[lane].back());
+        queue.lanes[lane].pop_back();
+        m_pending_counts[lane]--;
+        return true;
+      }
     }
   }
+
+  return false;
+}
+
+void AsyncShaderCompiler::PushCompletedItem(QueuedItem item)
+{
+  std::lock_guard<std::mutex> guard(m_completed_work_lock);
+  m_completed_work.push_back(std::move(item));
+}
+
+size_t AsyncShaderCompiler::GetPendingItemCount() const
+{
+  size_t count = 0;
+  for (const auto& lane_count : m_pending_counts)
+    count += lane_count.load();
+  return count;
 }
 
 }  // namespace VideoCommon
@@ -4,11 +4,12 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <functional>
-#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -30,10 +31,41 @@ public:
     virtual ~WorkItem() = default;
     virtual bool Compile() = 0;
     virtual void Retrieve() = 0;
+
+    // Called instead of Retrieve() when the item was cancelled before it was compiled.
+    // Implementations should undo any bookkeeping which marks the item as in-flight.
+    virtual void Cancel() {}
   };
 
   using WorkItemPtr = std::unique_ptr<WorkItem>;
 
+  // Work items are placed in one of several lanes. Workers always drain a higher priority lane
+  // completely before taking anything from a lower priority lane, so a pipeline which is required
+  // for the current frame never waits behind speculative or precompile work.
+  enum class Priority : u32
+  {
+    OnDemand,
+    Predicted,
+    UberShader,
+    Precompile,
+    Count
+  };
+  static constexpr size_t NUM_PRIORITIES = static_cast<size_t>(Priority::Count);
+
+  struct LaneMetrics
+  {
+    // Number of items waiting for a worker thread.
+    size_t queue_depth = 0;
+
+    // Items retrieved since the last call to ResetMetrics(), and the time they spent between
+    // being queued and being retrieved on the calling thread.
+    u64 items_retrieved = 0;
+    u64 items_cancelled = 0;
+    u64 total_latency_us = 0;
+    u64 max_latency_us = 0;
+  };
+  using Metrics = std::array<LaneMetrics, NUM_PRIORITIES>;
+
   AsyncShaderCompiler();
   virtual ~AsyncShaderCompiler();
 
@@ -43,19 +75,29 @@ public:
     return std::make_unique<T>(std::forward<Params>(params)...);
   }
 
-  // Queues a new work item to the compiler threads. The lower the priority, the sooner
-  // this work item will be compiled, relative to the other work items.
-  void QueueWorkItem(WorkItemPtr item, u32 priority);
+  // Queues a new work item to the compiler threads. Items in the same lane are compiled in
+  // roughly the order they were queued.
+  void QueueWorkItem(WorkItemPtr item, Priority priority);
   void RetrieveWorkItems();
   bool HasPendingWork();
   bool HasCompletedWork();
 
+  // Removes all items which have not yet started compiling from the given lane, or from every
+  // lane if no priority is given. Cancelled items have Cancel() called on them by the next
+  // call to RetrieveWorkItems().
+  void CancelPendingWork(Priority priority);
+  void CancelPendingWork();
+
   // Simpler version without progress updates.
   void WaitUntilCompletion();
 
   // Calls progress_callback periodically, with completed_items, and total_items.
   void WaitUntilCompletion(const std::function<void(size_t, size_t)>& progress_callback);
 
+  // Metrics are accumulated by RetrieveWorkItems(), and should be read from the same thread.
+  Metrics GetMetrics() const;
+  void ResetMetrics();
+
   // Needed because of calling virtual methods in shutdown procedure.
   bool StartWorkerThreads(u32 num_worker_threads);
   bool ResizeWorkerThreads(u32 num_worker_threads);
@@ -68,8 +110,29 @@ protected:
   virtual void WorkerThreadExit(void* param);
 
 private:
-  void WorkerThreadEntryPoint(void* param);
-  void WorkerThreadRun();
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedItem
+  {
+    WorkItemPtr item;
+    Priority priority;
+    Clock::time_point queue_time;
+    bool cancelled;
+  };
+
+  // Each worker owns a set of deques, one per lane. The owner takes from the front of its own
+  // deques, and idle workers steal from the back of the others'.
+  struct WorkerQueue
+  {
+    std::mutex lock;
+    std::array<std::deque<QueuedItem>, NUM_PRIORITIES> lanes;
+  };
+
+  void WorkerThreadEntryPoint(void* param, size_t worker_index);
+  void WorkerThreadRun(size_t worker_index);
+  bool TryTakeWorkItem(size_t worker_index, QueuedItem* out_item);
+  void PushCompletedItem(QueuedItem item);
+  size_t GetPendingItemCount() const;
 
   Common::Flag m_exit_flag;
   Common::Event m_init_event;
@@ -77,15 +140,21 @@ private:
   std::vector<std::thread> m_worker_threads;
   std::atomic_bool m_worker_thread_start_result{false};
 
-  // A multimap is used to store the work items. We can't use a priority_queue here, because
-  // there's no way to obtain a non-const reference, which we need for the unique_ptr.
-  std::multimap<u32, WorkItemPtr> m_pending_work;
-  std::mutex m_pending_work_lock;
+  std::vector<std::unique_ptr<WorkerQueue>> m_worker_queues;
+  size_t m_next_worker_queue = 0;
+  std::array<std::atomic_size_t, NUM_PRIORITIES> m_pending_counts{};
+
+  // Sleeping workers wait on this. The counter is incremented every time work is queued, so a
+  // worker which observed an empty queue can tell whether it missed a wakeup.
+  std::mutex m_wake_lock;
   std::condition_variable m_worker_thread_wake;
+  u64 m_wake_counter = 0;
   std::atomic_size_t m_busy_workers{0};
 
-  std::deque<WorkItemPtr> m_completed_work;
+  std::deque<QueuedItem> m_completed_work;
   std::mutex m_completed_work_lock;
+
+  Metrics m_metrics{};
 };
 
 }  // namespace VideoCommon
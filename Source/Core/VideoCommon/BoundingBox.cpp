@@ -3,6 +3,10 @@
 // Refer to the license.txt file included.
 
 #include "VideoCommon/BoundingBox.h"
+
+#include <array>
+#include <atomic>
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 
@@ -11,12 +15,21 @@ namespace BoundingBox
 // External vars
 bool active = false;
 u16 coords[4] = {0x80, 0xA0, 0x80, 0xA0};
+// Starts out with the same values as coords, until the first readback
+std::array<std::atomic<u16>, 4> readback_values{{0x80, 0xA0, 0x80, 0xA0}};
+std::atomic<bool> readback_pending{false};
 
 // Save state
 void DoState(PointerWrap& p)
 {
   p.Do(active);
   p.Do(coords);
+  for (std::atomic<u16>& value : readback_values)
+    p.Do(value);
+
+  // Readback requests are not saved, so a new one has to be made after loading
+  if (p.GetMode() == PointerWrap::MODE_READ)
+    readback_pending = false;
 }
 
 }  // namespace BoundingBox
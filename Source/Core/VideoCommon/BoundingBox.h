@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+
 #include "Common/CommonTypes.h"
 
 class PointerWrap;
@@ -17,6 +20,11 @@ extern bool active;
 // Bounding box current coordinates
 extern u16 coords[4];
 
+// Values from the last readback of the GPU bounding box, and whether a readback has been requested
+// but not yet handled by the GPU thread. Used by asynchronous readback.
+extern std::array<std::atomic<u16>, 4> readback_values;
+extern std::atomic<bool> readback_pending;
+
 enum
 {
   LEFT = 0,
@@ -6,13 +6,21 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 }
 
@@ -20,6 +28,7 @@ extern "C" {
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
+#include "Common/WorkQueueThread.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/SystemTimers.h"
@@ -36,13 +45,30 @@ extern "C" {
 #define av_frame_free avcodec_free_frame
 #endif
 
+// Number of slices FFV1 splits each frame into. Must be a valid slice configuration for FFV1.
+constexpr int FFV1_SLICES = 12;
+
+// Colour conversion is split into horizontal bands, which are converted in parallel, each with its
+// own context. Frames are never scaled, so the bands can be converted independently. Bands shorter
+// than the minimum height are not worth converting on a separate thread. Every band except the
+// first has a worker thread, which lives from Start to Stop. The first band is converted by the
+// thread that dumps the frame.
+constexpr int MAX_CONVERSION_BANDS = 8;
+constexpr int MIN_CONVERSION_BAND_HEIGHT = 64;
+
 static AVFormatContext* s_format_context = nullptr;
 static AVStream* s_stream = nullptr;
 static AVCodecContext* s_codec_context = nullptr;
 static AVFrame* s_src_frame = nullptr;
 static AVFrame* s_scaled_frame = nullptr;
 static AVPixelFormat s_pix_fmt = AV_PIX_FMT_BGR24;
-static SwsContext* s_sws_context = nullptr;
+static std::array<SwsContext*, MAX_CONVERSION_BANDS> s_sws_contexts = {};
+static int s_num_conversion_bands = 1;
+// The items are the row alignment of the bands
+static std::vector<std::unique_ptr<Common::WorkQueueThread<int>>> s_conversion_threads;
+static std::mutex s_conversion_mutex;
+static std::condition_variable s_conversion_done;
+static int s_pending_conversion_bands = 0;
 static int s_width;
 static int s_height;
 static u64 s_last_frame;
@@ -94,8 +120,11 @@ bool FrameDump::Start(int w, int h)
   {
     CloseVideoFile();
     OSD::AddMessage("FrameDump Start failed");
+    return false;
   }
-  return success;
+
+  StartConversionThreads();
+  return true;
 }
 
 static std::string GetDumpPath(const std::string& format)
@@ -124,6 +153,26 @@ static std::string GetDumpPath(const std::string& format)
   return dump_path;
 }
 
+static AVPixelFormat GetCodecPixelFormat(const AVCodec* codec)
+{
+  if (g_Config.bUseFFV1)
+    return AV_PIX_FMT_BGR0;
+
+  // Codecs which can take the frames as they are read back, such as rawvideo, skip the colour
+  // conversion entirely. This makes them suitable as a fast, lossless intermediate format.
+  // Codecs without a list of pixel formats, like rawvideo, accept any format.
+  if (!codec->pix_fmts)
+    return s_pix_fmt;
+
+  for (const AVPixelFormat* fmt = codec->pix_fmts; *fmt != AV_PIX_FMT_NONE; fmt++)
+  {
+    if (*fmt == s_pix_fmt)
+      return s_pix_fmt;
+  }
+
+  return AV_PIX_FMT_YUV420P;
+}
+
 bool FrameDump::CreateVideoFile()
 {
   const std::string& format = g_Config.sDumpFormat;
@@ -191,7 +240,19 @@ bool FrameDump::CreateVideoFile()
   s_codec_context->time_base.num = 1;
   s_codec_context->time_base.den = VideoInterface::GetTargetRefreshRate();
   s_codec_context->gop_size = 1;
-  s_codec_context->pix_fmt = g_Config.bUseFFV1 ? AV_PIX_FMT_BGR0 : AV_PIX_FMT_YUV420P;
+  s_codec_context->pix_fmt = GetCodecPixelFormat(codec);
+
+  // Let the codec pick the number of threads, and use both frame and slice threading if it can.
+  s_codec_context->thread_count = 0;
+  s_codec_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+  // FFV1 can only encode slices in parallel from version 3 onwards, and only uses a single slice
+  // unless told otherwise.
+  if (codec->id == AV_CODEC_ID_FFV1)
+  {
+    s_codec_context->level = 3;
+    s_codec_context->slices = FFV1_SLICES;
+  }
 
   if (output_format->flags & AVFMT_GLOBALHEADER)
     s_codec_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -205,17 +266,25 @@ bool FrameDump::CreateVideoFile()
   s_src_frame = av_frame_alloc();
   s_scaled_frame = av_frame_alloc();
 
+  const int num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  s_num_conversion_bands = std::clamp(std::min(num_threads, s_height / MIN_CONVERSION_BAND_HEIGHT),
+                                      1, MAX_CONVERSION_BANDS);
+
   s_scaled_frame->format = s_codec_context->pix_fmt;
   s_scaled_frame->width = s_width;
   s_scaled_frame->height = s_height;
 
+  // Frames which don't need to be converted are passed to the encoder directly.
+  if (s_codec_context->pix_fmt != s_pix_fmt)
+  {
 #if LIBAVCODEC_VERSION_MAJOR >= 55
-  if (av_frame_get_buffer(s_scaled_frame, 1))
-    return false;
+    if (av_frame_get_buffer(s_scaled_frame, 1))
+      return false;
 #else
-  if (avcodec_default_get_buffer(s_codec_context, s_scaled_frame))
-    return false;
+    if (avcodec_default_get_buffer(s_codec_context, s_scaled_frame))
+      return false;
 #endif
+  }
 
   s_stream = avformat_new_stream(s_format_context, codec);
   if (!s_stream || !AVStreamCopyContext(s_stream, s_codec_context))
@@ -254,7 +323,7 @@ static int ReceivePacket(AVCodecContext* avctx, AVPacket* pkt, int* got_packet)
   int error = avcodec_receive_packet(avctx, pkt);
   if (!error)
     *got_packet = 1;
-  if (error == AVERROR(EAGAIN))
+  if (error == AVERROR(EAGAIN) || error == AVERROR_EOF)
     return 0;
 
   return error;
@@ -295,6 +364,88 @@ static void WritePacket(AVPacket& pkt)
   av_interleaved_write_frame(s_format_context, &pkt);
 }
 
+static void ConvertBand(int band, int alignment)
+{
+  const int height = s_src_frame->height;
+  const int first_row = (height * band / s_num_conversion_bands) & ~(alignment - 1);
+  const int end_row = (band == s_num_conversion_bands - 1) ?
+                          height :
+                          (height * (band + 1) / s_num_conversion_bands) & ~(alignment - 1);
+  const int band_height = end_row - first_row;
+
+  SwsContext*& context = s_sws_contexts[band];
+  context = sws_getCachedContext(context, s_width, band_height, s_pix_fmt, s_width, band_height,
+                                 s_codec_context->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
+  if (!context)
+    return;
+
+  const u8* src[AV_NUM_DATA_POINTERS] = {s_src_frame->data[0] +
+                                         first_row * s_src_frame->linesize[0]};
+  u8* dst[AV_NUM_DATA_POINTERS] = {};
+  const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(s_codec_context->pix_fmt);
+  for (int plane = 0; plane < AV_NUM_DATA_POINTERS && s_scaled_frame->data[plane]; plane++)
+  {
+    const int row_shift = (plane == 1 || plane == 2) ? desc->log2_chroma_h : 0;
+    dst[plane] =
+        s_scaled_frame->data[plane] + (first_row >> row_shift) * s_scaled_frame->linesize[plane];
+  }
+
+  sws_scale(context, src, s_src_frame->linesize, 0, band_height, dst, s_scaled_frame->linesize);
+}
+
+void FrameDump::StartConversionThreads()
+{
+  for (int band = 1; band < s_num_conversion_bands; band++)
+  {
+    s_conversion_threads.emplace_back(
+        std::make_unique<Common::WorkQueueThread<int>>([band](int alignment) {
+          ConvertBand(band, alignment);
+
+          std::lock_guard<std::mutex> lk(s_conversion_mutex);
+          if (--s_pending_conversion_bands == 0)
+            s_conversion_done.notify_one();
+        }));
+  }
+}
+
+void FrameDump::StopConversionThreads()
+{
+  // Destroying the threads waits for them to finish
+  s_conversion_threads.clear();
+}
+
+static bool ConvertFrame()
+{
+#if LIBAVCODEC_VERSION_MAJOR >= 55
+  // The encoder may still hold a reference to the previous frame's buffer, so convert into a new
+  // buffer instead of copying the old one only to overwrite it.
+  av_frame_unref(s_scaled_frame);
+  s_scaled_frame->format = s_codec_context->pix_fmt;
+  s_scaled_frame->width = s_width;
+  s_scaled_frame->height = s_height;
+  if (av_frame_get_buffer(s_scaled_frame, 1))
+  {
+    ERROR_LOG(VIDEO, "Could not allocate a frame");
+    return false;
+  }
+#endif
+
+  // Bands have to start on a row which has its own chroma samples.
+  const int alignment = 1 << av_pix_fmt_desc_get(s_codec_context->pix_fmt)->log2_chroma_h;
+
+  {
+    std::lock_guard<std::mutex> lk(s_conversion_mutex);
+    s_pending_conversion_bands = static_cast<int>(s_conversion_threads.size());
+  }
+  for (auto& thread : s_conversion_threads)
+    thread->EmplaceItem(alignment);
+  ConvertBand(0, alignment);
+
+  std::unique_lock<std::mutex> lk(s_conversion_mutex);
+  s_conversion_done.wait(lk, [] { return s_pending_conversion_bands == 0; });
+  return true;
+}
+
 void FrameDump::AddFrame(const u8* data, int width, int height, int stride, const Frame& state)
 {
   // Assume that the timing is valid, if the savestate id of the new frame
@@ -312,14 +463,21 @@ void FrameDump::AddFrame(const u8* data, int width, int height, int stride, cons
   s_src_frame->width = s_width;
   s_src_frame->height = s_height;
 
-  // Convert image from {BGR24, RGBA} to desired pixel format
-  s_sws_context =
-      sws_getCachedContext(s_sws_context, width, height, s_pix_fmt, s_width, s_height,
-                           s_codec_context->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
-  if (s_sws_context)
+  // Convert image from {BGR24, RGBA} to desired pixel format. If the resolution of the frame is
+  // invalid, the last image is encoded again instead.
+  AVFrame* frame = s_scaled_frame;
+  if (s_codec_context->pix_fmt == s_pix_fmt)
   {
-    sws_scale(s_sws_context, s_src_frame->data, s_src_frame->linesize, 0, height,
-              s_scaled_frame->data, s_scaled_frame->linesize);
+    // Without a copy of the last image, frames with an invalid resolution have to be dropped.
+    if (width != s_width || height != s_height)
+      return;
+
+    frame = s_src_frame;
+  }
+  else if (width == s_width && height == s_height)
+  {
+    if (!ConvertFrame())
+      return;
   }
 
   // Encode and write the image.
@@ -349,16 +507,24 @@ void FrameDump::AddFrame(const u8* data, int width, int height, int stride, cons
     last_pts = (s_last_pts * s_codec_context->time_base.den) / state.ticks_per_second;
   }
   u64 pts_in_ticks = s_last_pts + delta;
-  s_scaled_frame->pts = (pts_in_ticks * s_codec_context->time_base.den) / state.ticks_per_second;
-  if (s_scaled_frame->pts != last_pts)
+  frame->pts = (pts_in_ticks * s_codec_context->time_base.den) / state.ticks_per_second;
+  if (frame->pts != last_pts)
   {
     s_last_frame = state.ticks;
     s_last_pts = pts_in_ticks;
-    error = SendFrameAndReceivePacket(s_codec_context, &pkt, s_scaled_frame, &got_packet);
+    error = SendFrameAndReceivePacket(s_codec_context, &pkt, frame, &got_packet);
   }
-  if (!error && got_packet)
+
+  // Threaded encoders return packets with a delay, and may return several at once.
+  while (!error && got_packet)
   {
     WritePacket(pkt);
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57, 37, 100)
+    break;
+#else
+    PreparePacket(&pkt);
+    error = ReceivePacket(s_codec_context, &pkt, &got_packet);
+#endif
   }
   if (error)
     ERROR_LOG(VIDEO, "Error while encoding video: %d", error);
@@ -368,6 +534,11 @@ static void HandleDelayedPackets()
 {
   AVPacket pkt;
 
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 37, 100)
+  // Switch the encoder to draining mode, so that it returns the frames it is still holding on to.
+  avcodec_send_frame(s_codec_context, nullptr);
+#endif
+
   while (true)
   {
     PreparePacket(&pkt);
@@ -388,6 +559,7 @@ static void HandleDelayedPackets()
 
 void FrameDump::Stop()
 {
+  StopConversionThreads();
   HandleDelayedPackets();
   av_write_trailer(s_format_context);
   CloseVideoFile();
@@ -410,10 +582,13 @@ void FrameDump::CloseVideoFile()
   avformat_free_context(s_format_context);
   s_format_context = nullptr;
 
-  if (s_sws_context)
+  for (SwsContext*& context : s_sws_contexts)
   {
-    sws_freeContext(s_sws_context);
-    s_sws_context = nullptr;
+    if (context)
+    {
+      sws_freeContext(context);
+      context = nullptr;
+    }
   }
 }
 
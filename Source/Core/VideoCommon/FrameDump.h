@@ -12,6 +12,8 @@ private:
   static bool CreateVideoFile();
   static void CloseVideoFile();
   static void CheckResolution(int width, int height);
+  static void StartConversionThreads();
+  static void StopConversionThreads();
 
 public:
   struct Frame
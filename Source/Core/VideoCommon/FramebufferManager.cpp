@@ -18,6 +18,7 @@
 #include "VideoCommon/AbstractTexture.h"
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/RenderBase.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 
 // Maximum number of pixels poked in one batch * 6
@@ -371,6 +372,8 @@ u32 FramebufferManager::PeekEFBColor(u32 x, u32 y)
   u32 tile_index;
   if (!IsEFBCacheTilePresent(false, x, y, &tile_index))
     PopulateEFBCache(false, tile_index);
+  if (IsUsingTiledEFBCache())
+    m_efb_color_cache.tiles_read[tile_index] = true;
 
   u32 value;
   m_efb_color_cache.readback_texture->ReadTexel(x, y, &value);
@@ -386,6 +389,8 @@ float FramebufferManager::PeekEFBDepth(u32 x, u32 y)
   u32 tile_index;
   if (!IsEFBCacheTilePresent(true, x, y, &tile_index))
     PopulateEFBCache(true, tile_index);
+  if (IsUsingTiledEFBCache())
+    m_efb_depth_cache.tiles_read[tile_index] = true;
 
   float value;
   m_efb_depth_cache.readback_texture->ReadTexel(x, y, &value);
@@ -435,6 +440,18 @@ void FramebufferManager::FlagPeekCacheAsOutOfDate()
     InvalidatePeekCache();
 }
 
+void FramebufferManager::OnEndFrame()
+{
+  if (!IsUsingTiledEFBCache())
+    return;
+
+  for (EFBCacheData* data : {&m_efb_color_cache, &m_efb_depth_cache})
+  {
+    data->tiles_read_last_frame.swap(data->tiles_read);
+    std::fill(data->tiles_read.begin(), data->tiles_read.end(), false);
+  }
+}
+
 bool FramebufferManager::CompileReadbackPipelines()
 {
   AbstractPipelineConfig config = {};
@@ -547,10 +564,12 @@ bool FramebufferManager::CreateReadbackFramebuffer()
     const u32 tiles_wide = ((EFB_WIDTH + (m_efb_cache_tile_size - 1)) / m_efb_cache_tile_size);
     const u32 tiles_high = ((EFB_HEIGHT + (m_efb_cache_tile_size - 1)) / m_efb_cache_tile_size);
     const u32 total_tiles = tiles_wide * tiles_high;
-    m_efb_color_cache.tiles.resize(total_tiles);
-    std::fill(m_efb_color_cache.tiles.begin(), m_efb_color_cache.tiles.end(), false);
-    m_efb_depth_cache.tiles.resize(total_tiles);
-    std::fill(m_efb_depth_cache.tiles.begin(), m_efb_depth_cache.tiles.end(), false);
+    for (EFBCacheData* data : {&m_efb_color_cache, &m_efb_depth_cache})
+    {
+      data->tiles.assign(total_tiles, false);
+      data->tiles_read.assign(total_tiles, false);
+      data->tiles_read_last_frame.assign(total_tiles, false);
+    }
     m_efb_cache_tiles_wide = tiles_wide;
   }
 
@@ -573,6 +592,35 @@ void FramebufferManager::PopulateEFBCache(bool depth, u32 tile_index)
 {
   g_vertex_manager->OnCPUEFBAccess();
 
+  EFBCacheData& data = depth ? m_efb_depth_cache : m_efb_color_cache;
+  CopyEFBCacheTile(depth, tile_index);
+
+  // Games tend to read the same pixels every frame, e.g. to test lens flare occlusion. Copy the
+  // tiles which were read in the last frame as well, so that they don't each need another sync.
+  if (IsUsingTiledEFBCache() && g_ActiveConfig.bEFBAccessPrefetchTiles)
+  {
+    for (u32 i = 0; i < static_cast<u32>(data.tiles.size()); i++)
+    {
+      if (i == tile_index || !data.tiles_read_last_frame[i] || data.tiles[i])
+        continue;
+
+      CopyEFBCacheTile(depth, i);
+      data.tiles[i] = true;
+      INCSTAT(g_stats.this_frame.num_efb_tiles_prefetched);
+    }
+  }
+
+  // Wait until the copies are complete.
+  data.readback_texture->Flush();
+  INCSTAT(g_stats.this_frame.num_efb_peek_syncs);
+  data.valid = true;
+  data.out_of_date = false;
+  if (IsUsingTiledEFBCache())
+    data.tiles[tile_index] = true;
+}
+
+void FramebufferManager::CopyEFBCacheTile(bool depth, u32 tile_index)
+{
   // Force the path through the intermediate texture, as we can't do an image copy from a depth
   // buffer directly to a staging texture (must be the whole resource).
   const bool force_intermediate_copy =
@@ -625,13 +673,6 @@ void FramebufferManager::PopulateEFBCache(bool depth, u32 tile_index)
   {
     data.readback_texture->CopyFromTexture(src_texture, rect, 0, 0, rect);
   }
-
-  // Wait until the copy is complete.
-  data.readback_texture->Flush();
-  data.valid = true;
-  data.out_of_date = false;
-  if (IsUsingTiledEFBCache())
-    data.tiles[tile_index] = true;
 }
 
 void FramebufferManager::ClearEFB(const MathUtil::Rectangle<int>& rc, bool clear_color,
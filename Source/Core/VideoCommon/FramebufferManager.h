@@ -92,6 +92,9 @@ public:
   void InvalidatePeekCache(bool forced = true);
   void FlagPeekCacheAsOutOfDate();
 
+  // Remembers which tiles were read during the frame, to prefetch them in the next frame.
+  void OnEndFrame();
+
   // Writes a value to the framebuffer. This will never block, and writes will be batched.
   void PokeEFBColor(u32 x, u32 y, u32 color);
   void PokeEFBDepth(u32 x, u32 y, float depth);
@@ -117,6 +120,8 @@ protected:
     std::unique_ptr<AbstractStagingTexture> readback_texture;
     std::unique_ptr<AbstractPipeline> copy_pipeline;
     std::vector<bool> tiles;
+    std::vector<bool> tiles_read;
+    std::vector<bool> tiles_read_last_frame;
     bool out_of_date;
     bool valid;
   };
@@ -143,6 +148,7 @@ protected:
   bool IsEFBCacheTilePresent(bool depth, u32 x, u32 y, u32* tile_index) const;
   MathUtil::Rectangle<int> GetEFBCacheTileRect(u32 tile_index) const;
   void PopulateEFBCache(bool depth, u32 tile_index);
+  void CopyEFBCacheTile(bool depth, u32 tile_index);
 
   void CreatePokeVertices(std::vector<EFBPokeVertex>* destination_list, u32 x, u32 y, float z,
                           u32 color);
@@ -2,11 +2,14 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <array>
 #include <cstddef>
 #include <cstring>
 
+#include "Common/Assert.h"
 #include "Common/CommonTypes.h"
 #include "Common/Compiler.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/OpcodeDecoding.h"
@@ -21,6 +24,97 @@ static const u16 s_primitive_restart = UINT16_MAX;
 
 static u16* (*primitive_table[8])(u16*, u32, u32);
 
+/* Vectorized generation
+ *
+ * Apart from fans, every index a generator writes is the index of the first vertex plus an offset
+ * which only depends on the position in the loop, and advances by the same amount with every
+ * iteration. So a fixed number of iterations can be captured once by running the scalar code,
+ * and replayed for any starting vertex with a vector addition. Fans also refer to their center
+ * vertex, which stays the same, and restart indices are kept as they are.
+ */
+static bool s_use_simd = false;
+
+namespace
+{
+struct IndexPattern
+{
+  static constexpr u32 MAX_VECTORS = 5;
+  static constexpr u32 INDICES_PER_VECTOR = 8;
+
+  alignas(16) std::array<u16, MAX_VECTORS * INDICES_PER_VECTOR> offsets;
+  alignas(16) std::array<u16, MAX_VECTORS * INDICES_PER_VECTOR> vary_mask;
+  alignas(16) std::array<u16, MAX_VECTORS * INDICES_PER_VECTOR> restart_mask;
+  u32 num_vectors;
+};
+
+// Indexed by the primitive restart template parameter.
+std::array<IndexPattern, 2> s_list_pattern;
+std::array<IndexPattern, 2> s_quad_pattern;
+std::array<IndexPattern, 2> s_fan_pattern;
+IndexPattern s_strip_pattern;
+
+// Number of loop iterations covered by each pattern.
+constexpr u32 LIST_PATTERN_TRIANGLES = 8;
+constexpr u32 STRIP_PATTERN_TRIANGLES = 8;
+constexpr u32 FAN_PATTERN_TRIANGLES = 8;
+constexpr u32 FAN_PR_PATTERN_GROUPS = 4;
+constexpr u32 QUAD_PATTERN_QUADS = 4;
+constexpr u32 QUAD_PR_PATTERN_QUADS = 8;
+
+IndexPattern CreatePattern(u16* (*generator)(u16*, u32, u32), u32 num_verts, bool is_fan)
+{
+  std::array<u16, IndexPattern::MAX_VECTORS * IndexPattern::INDICES_PER_VECTOR> indices{};
+  const u16* end = generator(indices.data(), num_verts, 0);
+  const u32 num_indices = static_cast<u32>(end - indices.data());
+  ASSERT(num_indices % IndexPattern::INDICES_PER_VECTOR == 0 && num_indices <= indices.size());
+
+  IndexPattern pattern = {};
+  pattern.num_vectors = num_indices / IndexPattern::INDICES_PER_VECTOR;
+  for (u32 i = 0; i < num_indices; i++)
+  {
+    const bool is_restart = indices[i] == s_primitive_restart;
+    const bool is_center = is_fan && indices[i] == 0;
+    pattern.offsets[i] = is_restart ? 0 : indices[i];
+    pattern.vary_mask[i] = (is_restart || is_center) ? 0 : 0xFFFF;
+    pattern.restart_mask[i] = is_restart ? 0xFFFF : 0;
+  }
+  return pattern;
+}
+
+// Writes the pattern for the iteration at loop position i, where the pattern was captured at
+// loop position first_i.
+DOLPHIN_FORCE_INLINE u16* WritePattern(u16* Iptr, const IndexPattern& pattern, u32 index, u32 i,
+                                       u32 first_i)
+{
+#ifdef _M_X86
+  const __m128i base = _mm_set1_epi16(static_cast<s16>(index));
+  const __m128i delta = _mm_set1_epi16(static_cast<s16>(i - first_i));
+  for (u32 v = 0; v < pattern.num_vectors; v++)
+  {
+    const u32 offset = v * IndexPattern::INDICES_PER_VECTOR;
+    const __m128i offsets =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.offsets[offset]));
+    const __m128i vary =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.vary_mask[offset]));
+    const __m128i restart =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(&pattern.restart_mask[offset]));
+
+    __m128i result = _mm_add_epi16(_mm_add_epi16(base, offsets), _mm_and_si128(delta, vary));
+    result = _mm_or_si128(result, restart);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(Iptr + offset), result);
+  }
+#else
+  const u16 delta = static_cast<u16>(i - first_i);
+  for (u32 j = 0; j < pattern.num_vectors * IndexPattern::INDICES_PER_VECTOR; j++)
+  {
+    Iptr[j] = (static_cast<u16>(index + pattern.offsets[j] + (delta & pattern.vary_mask[j]))) |
+              pattern.restart_mask[j];
+  }
+#endif
+  return Iptr + pattern.num_vectors * IndexPattern::INDICES_PER_VECTOR;
+}
+}  // Anonymous namespace
+
 void IndexGenerator::Init()
 {
   if (g_Config.backend_info.bSupportsPrimitiveRestart)
@@ -42,6 +136,23 @@ void IndexGenerator::Init()
   primitive_table[OpcodeDecoder::GX_DRAW_LINES] = &AddLineList;
   primitive_table[OpcodeDecoder::GX_DRAW_LINE_STRIP] = &AddLineStrip;
   primitive_table[OpcodeDecoder::GX_DRAW_POINTS] = &AddPoints;
+
+  // Capture the patterns from the scalar generators, for exactly one pattern's worth of
+  // iterations of the loop which is vectorized.
+  s_use_simd = false;
+  s_list_pattern[false] = CreatePattern(AddList<false>, 2 + 3 * LIST_PATTERN_TRIANGLES, false);
+  s_list_pattern[true] = CreatePattern(AddList<true>, 2 + 3 * LIST_PATTERN_TRIANGLES, false);
+  s_strip_pattern = CreatePattern(AddStrip<false>, 2 + STRIP_PATTERN_TRIANGLES, false);
+  s_fan_pattern[false] = CreatePattern(AddFan<false>, 2 + FAN_PATTERN_TRIANGLES, true);
+  s_fan_pattern[true] = CreatePattern(AddFan<true>, 2 + 3 * FAN_PR_PATTERN_GROUPS, true);
+  s_quad_pattern[false] = CreatePattern(AddQuads<false>, 4 * QUAD_PATTERN_QUADS, false);
+  s_quad_pattern[true] = CreatePattern(AddQuads<true>, 4 * QUAD_PR_PATTERN_QUADS, false);
+  s_use_simd = true;
+}
+
+void IndexGenerator::SetUseSIMD(bool enable)
+{
+  s_use_simd = enable;
 }
 
 void IndexGenerator::Start(u16* Indexptr)
@@ -80,7 +191,14 @@ DOLPHIN_FORCE_INLINE u16* IndexGenerator::WriteTriangle(u16* Iptr, u32 index1, u
 template <bool pr>
 u16* IndexGenerator::AddList(u16* Iptr, u32 const numVerts, u32 index)
 {
-  for (u32 i = 2; i < numVerts; i += 3)
+  u32 i = 2;
+  if (s_use_simd)
+  {
+    for (; i + 3 * (LIST_PATTERN_TRIANGLES - 1) < numVerts; i += 3 * LIST_PATTERN_TRIANGLES)
+      Iptr = WritePattern(Iptr, s_list_pattern[pr], index, i, 2);
+  }
+
+  for (; i < numVerts; i += 3)
   {
     Iptr = WriteTriangle<pr>(Iptr, index + i - 2, index + i - 1, index + i);
   }
@@ -92,7 +210,21 @@ u16* IndexGenerator::AddStrip(u16* Iptr, u32 const numVerts, u32 index)
 {
   if (pr)
   {
-    for (u32 i = 0; i < numVerts; ++i)
+    u32 i = 0;
+#ifdef _M_X86
+    if (s_use_simd)
+    {
+      const __m128i ramp = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+      for (; i + 8 <= numVerts; i += 8)
+      {
+        const __m128i base = _mm_set1_epi16(static_cast<s16>(index + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Iptr), _mm_add_epi16(base, ramp));
+        Iptr += 8;
+      }
+    }
+#endif
+
+    for (; i < numVerts; ++i)
     {
       *Iptr++ = index + i;
     }
@@ -100,8 +232,16 @@ u16* IndexGenerator::AddStrip(u16* Iptr, u32 const numVerts, u32 index)
   }
   else
   {
+    // Patterns cover an even number of triangles, so the winding is the same at the start of each.
+    u32 i = 2;
+    if (s_use_simd)
+    {
+      for (; i + (STRIP_PATTERN_TRIANGLES - 1) < numVerts; i += STRIP_PATTERN_TRIANGLES)
+        Iptr = WritePattern(Iptr, s_strip_pattern, index, i, 2);
+    }
+
     bool wind = false;
-    for (u32 i = 2; i < numVerts; ++i)
+    for (; i < numVerts; ++i)
     {
       Iptr = WriteTriangle<pr>(Iptr, index + i - 2, index + i - !wind, index + i - wind);
 
@@ -137,6 +277,12 @@ u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
 
   if (pr)
   {
+    if (s_use_simd)
+    {
+      for (; i + 3 * FAN_PR_PATTERN_GROUPS <= numVerts; i += 3 * FAN_PR_PATTERN_GROUPS)
+        Iptr = WritePattern(Iptr, s_fan_pattern[true], index, i, 2);
+    }
+
     for (; i + 3 <= numVerts; i += 3)
     {
       *Iptr++ = index + i - 1;
@@ -156,6 +302,11 @@ u16* IndexGenerator::AddFan(u16* Iptr, u32 numVerts, u32 index)
       *Iptr++ = s_primitive_restart;
     }
   }
+  else if (s_use_simd)
+  {
+    for (; i + (FAN_PATTERN_TRIANGLES - 1) < numVerts; i += FAN_PATTERN_TRIANGLES)
+      Iptr = WritePattern(Iptr, s_fan_pattern[false], index, i, 2);
+  }
 
   for (; i < numVerts; ++i)
   {
@@ -185,6 +336,13 @@ template <bool pr>
 u16* IndexGenerator::AddQuads(u16* Iptr, u32 numVerts, u32 index)
 {
   u32 i = 3;
+  if (s_use_simd)
+  {
+    constexpr u32 num_quads = pr ? QUAD_PR_PATTERN_QUADS : QUAD_PATTERN_QUADS;
+    for (; i + 4 * (num_quads - 1) < numVerts; i += 4 * num_quads)
+      Iptr = WritePattern(Iptr, s_quad_pattern[pr], index, i, 3);
+  }
+
   for (; i < numVerts; i += 4)
   {
     if (pr)
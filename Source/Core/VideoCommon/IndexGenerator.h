@@ -14,6 +14,10 @@ class IndexGenerator
 public:
   // Init
   static void Init();
+
+  // The vectorized generators produce the same indices as the scalar ones, and are enabled by
+  // Init(). Disabling them is only useful for testing and benchmarking.
+  static void SetUseSIMD(bool enable);
   static void Start(u16* Indexptr);
 
   static void AddIndices(int primitive, u32 numVertices);
@@ -25,6 +29,9 @@ public:
   static u32 GetIndexLen() { return (u32)(index_buffer_current - BASEIptr); }
   static u32 GetRemainingIndices();
 
+  // Shrinks the current batch after primitives have been removed from it in place.
+  static void SetIndexLen(u32 num_indices) { index_buffer_current = BASEIptr + num_indices; }
+
 private:
   // Triangles
   template <bool pr>
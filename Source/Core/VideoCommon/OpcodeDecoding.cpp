@@ -26,6 +26,7 @@
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/TimelineProfiler.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/XFMemory.h"
@@ -83,6 +84,7 @@ void Init()
 template <bool is_preprocess>
 u8* Run(DataReader src, u32* cycles, bool in_display_list)
 {
+  TimelineProfiler::Scope timeline_scope(is_preprocess ? "Opcode preprocess" : "Opcode decode");
   u32 totalCycles = 0;
   u8* opcodeStart;
   while (true)
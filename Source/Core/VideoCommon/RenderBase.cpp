@@ -17,18 +17,22 @@
 #include <algorithm>
 #include <cinttypes>
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
 
 #include <imgui.h>
+#include <xxhash.h>
 
 #include "Common/Assert.h"
 #include "Common/ChunkFile.h"
+#include "Common/CommonPaths.h"
 #include "Common/CommonTypes.h"
 #include "Common/Config/Config.h"
 #include "Common/Event.h"
+#include "Common/File.h"
 #include "Common/FileUtil.h"
 #include "Common/Flag.h"
 #include "Common/Logging/Log.h"
@@ -71,6 +75,7 @@
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/TimelineProfiler.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -111,6 +116,7 @@ bool Renderer::Initialize()
   if (!m_post_processor->Initialize(m_backbuffer_format))
     return false;
 
+  TimelineProfiler::OnFrameBegin(m_frame_count);
   return true;
 }
 
@@ -119,6 +125,7 @@ void Renderer::Shutdown()
   // First stop any framedumping, which might need to dump the last xfb frame. This process
   // can require additional graphics sub-systems so it needs to be done first
   ShutdownFrameDumping();
+  TimelineProfiler::Shutdown();
   ShutdownImGui();
   m_post_processor.reset();
 }
@@ -1219,10 +1226,13 @@ void Renderer::Swap(u32 xfb_addr, u32 fb_width, u32 fb_stride, u32 fb_height, u6
       m_aspect_wide = flush_count_anamorphic > 0.75 * flush_total;
   }
 
-  // Ensure the last frame was written to the dump.
-  // This is required even if frame dumping has stopped, since the frame dump is one frame
-  // behind the renderer.
-  FlushFrameDump();
+  // Queue frames whose readback has completed for encoding. This is required even if frame dumping
+  // has stopped, since the frame dump is a few frames behind the renderer. Screenshots are
+  // flushed immediately, to keep their latency down.
+  if (IsReadingBackAllFrames())
+    QueueFrameDumpReadbacks(NUM_FRAME_DUMP_READBACK_TEXTURES - 1);
+  else
+    FlushFrameDump();
 
   if (xfb_addr && fb_width && fb_stride && fb_height)
   {
@@ -1266,6 +1276,7 @@ void Renderer::Swap(u32 xfb_addr, u32 fb_width, u32 fb_stride, u32 fb_height, u6
 
         // Present to the window system.
         {
+          TimelineProfiler::Scope present_scope("Present", true);
           std::lock_guard<std::mutex> guard(m_swap_mutex);
           PresentBackbuffer();
         }
@@ -1288,9 +1299,11 @@ void Renderer::Swap(u32 xfb_addr, u32 fb_width, u32 fb_stride, u32 fb_height, u6
 
       // Begin new frame
       m_frame_count++;
+      TimelineProfiler::OnFrameBegin(m_frame_count);
       g_stats.ResetFrame();
       g_shader_cache->RetrieveAsyncShaders();
       g_vertex_manager->OnEndFrame();
+      g_framebuffer_manager->OnEndFrame();
       BeginImGuiFrame();
 
       // We invalidate the pipeline object at the start of the frame.
@@ -1355,10 +1368,12 @@ bool Renderer::IsFrameDumping() const
   if (m_screenshot_request.IsSet())
     return true;
 
-  if (SConfig::GetInstance().m_DumpFrames)
-    return true;
+  return IsReadingBackAllFrames();
+}
 
-  return false;
+bool Renderer::IsReadingBackAllFrames() const
+{
+  return SConfig::GetInstance().m_DumpFrames || g_ActiveConfig.bLogFrameChecksums;
 }
 
 void Renderer::DumpCurrentFrame(const AbstractTexture* src_texture,
@@ -1367,7 +1382,10 @@ void Renderer::DumpCurrentFrame(const AbstractTexture* src_texture,
   int source_width = src_rect.GetWidth();
   int source_height = src_rect.GetHeight();
   int target_width, target_height;
-  if (!g_ActiveConfig.bInternalResolutionFrameDumps && !IsHeadless())
+  // Checksums are always taken at internal resolution, so the log of two runs can be compared even
+  // if the window was a different size.
+  if (!g_ActiveConfig.bInternalResolutionFrameDumps && !g_ActiveConfig.bLogFrameChecksums &&
+      !IsHeadless())
   {
     auto target_rect = GetTargetRectangle();
     target_width = target_rect.GetWidth();
@@ -1391,17 +1409,18 @@ void Renderer::DumpCurrentFrame(const AbstractTexture* src_texture,
     copy_rect = src_texture->GetRect();
   }
 
-  // Index 0 was just sent to FFMPEG dump. Swap with the second texture.
-  if (m_frame_dump_readback_textures[0])
-    std::swap(m_frame_dump_readback_textures[0], m_frame_dump_readback_textures[1]);
-
+  // Present() queues the oldest frame if every readback texture is in use, so the head is free.
   if (!CheckFrameDumpReadbackTexture(target_width, target_height))
     return;
 
-  m_frame_dump_readback_textures[0]->CopyFromTexture(src_texture, copy_rect, 0, 0,
-                                                     m_frame_dump_readback_textures[0]->GetRect());
-  m_last_frame_state = FrameDump::FetchState(ticks);
-  m_last_frame_exported = true;
+  const u32 index = m_frame_dump_readback_head;
+  m_frame_dump_readback_textures[index]->CopyFromTexture(
+      src_texture, copy_rect, 0, 0, m_frame_dump_readback_textures[index]->GetRect());
+  m_frame_dump_readback_states[index] = {FrameDump::FetchState(ticks),
+                                          SConfig::GetInstance().m_DumpFrames,
+                                          g_ActiveConfig.bLogFrameChecksums};
+  m_frame_dump_readback_head = (index + 1) % NUM_FRAME_DUMP_READBACK_TEXTURES;
+  m_frame_dump_readback_pending++;
 }
 
 bool Renderer::CheckFrameDumpRenderTexture(u32 target_width, u32 target_height)
@@ -1432,7 +1451,8 @@ bool Renderer::CheckFrameDumpRenderTexture(u32 target_width, u32 target_height)
 
 bool Renderer::CheckFrameDumpReadbackTexture(u32 target_width, u32 target_height)
 {
-  std::unique_ptr<AbstractStagingTexture>& rbtex = m_frame_dump_readback_textures[0];
+  std::unique_ptr<AbstractStagingTexture>& rbtex =
+      m_frame_dump_readback_textures[m_frame_dump_readback_head];
   if (rbtex && rbtex->GetWidth() == target_width && rbtex->GetHeight() == target_height)
     return true;
 
@@ -1446,26 +1466,38 @@ bool Renderer::CheckFrameDumpReadbackTexture(u32 target_width, u32 target_height
   return true;
 }
 
-void Renderer::FlushFrameDump()
+void Renderer::QueueFrameDumpReadbacks(u32 max_pending)
 {
-  if (!m_last_frame_exported)
-    return;
+  while (m_frame_dump_readback_pending > max_pending)
+  {
+    const u32 index = (m_frame_dump_readback_head + NUM_FRAME_DUMP_READBACK_TEXTURES -
+                       m_frame_dump_readback_pending) %
+                      NUM_FRAME_DUMP_READBACK_TEXTURES;
+    m_frame_dump_readback_pending--;
 
-  // Ensure the previously-queued frame was encoded.
-  FinishFrameData();
+    // Frames which are neither dumped, logged nor saved as a screenshot don't need to be read.
+    const FrameDumpReadbackState& readback_state = m_frame_dump_readback_states[index];
+    const bool save_screenshot = m_screenshot_request.TestAndClear();
+    const bool dump_frame = readback_state.dump_frame;
+    const bool log_checksum = readback_state.log_checksum;
+    if (!save_screenshot && !dump_frame && !log_checksum)
+      continue;
 
-  // Queue encoding of the last frame dumped.
-  std::unique_ptr<AbstractStagingTexture>& rbtex = m_frame_dump_readback_textures[0];
-  rbtex->Flush();
-  if (rbtex->Map())
-  {
-    DumpFrameData(reinterpret_cast<u8*>(rbtex->GetMappedPointer()), rbtex->GetConfig().width,
-                  rbtex->GetConfig().height, static_cast<int>(rbtex->GetMappedStride()),
-                  m_last_frame_state);
-    rbtex->Unmap();
+    std::unique_ptr<AbstractStagingTexture>& rbtex = m_frame_dump_readback_textures[index];
+    rbtex->Flush();
+    if (rbtex->Map())
+    {
+      DumpFrameData(reinterpret_cast<u8*>(rbtex->GetMappedPointer()), rbtex->GetConfig().width,
+                    rbtex->GetConfig().height, static_cast<int>(rbtex->GetMappedStride()),
+                    readback_state.state, save_screenshot, dump_frame, log_checksum);
+      rbtex->Unmap();
+    }
   }
+}
 
-  m_last_frame_exported = false;
+void Renderer::FlushFrameDump()
+{
+  QueueFrameDumpReadbacks(0);
 
   // Shutdown frame dumping if it is no longer active.
   if (!IsFrameDumping())
@@ -1475,30 +1507,42 @@ void Renderer::FlushFrameDump()
 void Renderer::ShutdownFrameDumping()
 {
   // Ensure the last queued readback has been sent to the encoder.
-  FlushFrameDump();
+  QueueFrameDumpReadbacks(0);
 
   if (!m_frame_dump_thread_running.IsSet())
     return;
 
-  // Ensure previous frame has been encoded.
+  // Ensure all queued frames have been encoded.
   FinishFrameData();
 
   // Wake thread up, and wait for it to exit.
-  m_frame_dump_thread_running.Clear();
-  m_frame_dump_start.Set();
+  {
+    std::lock_guard<std::mutex> guard(m_frame_dump_queue_lock);
+    m_frame_dump_thread_running.Clear();
+  }
+  m_frame_dump_queue_changed.notify_all();
   if (m_frame_dump_thread.joinable())
     m_frame_dump_thread.join();
+
+  if (m_frame_dump_stalls > 0)
+  {
+    WARN_LOG(VIDEO, "Frame dumping fell behind, emulation waited for the encoder %u times",
+             m_frame_dump_stalls);
+    m_frame_dump_stalls = 0;
+  }
+
+  m_frame_dump_free_buffers.clear();
   m_frame_dump_render_framebuffer.reset();
   m_frame_dump_render_texture.reset();
   for (auto& tex : m_frame_dump_readback_textures)
     tex.reset();
+  m_frame_dump_readback_head = 0;
 }
 
 void Renderer::DumpFrameData(const u8* data, int w, int h, int stride,
-                             const FrameDump::Frame& state)
+                             const FrameDump::Frame& state, bool save_screenshot, bool dump_frame,
+                             bool log_checksum)
 {
-  m_frame_dump_config = FrameDumpConfig{data, w, h, stride, state};
-
   if (!m_frame_dump_thread_running.IsSet())
   {
     if (m_frame_dump_thread.joinable())
@@ -1507,18 +1551,65 @@ void Renderer::DumpFrameData(const u8* data, int w, int h, int stride,
     m_frame_dump_thread = std::thread(&Renderer::RunFrameDumps, this);
   }
 
-  // Wake worker thread up.
-  m_frame_dump_start.Set();
-  m_frame_dump_frame_running = true;
+  QueuedFrameDump frame;
+  {
+    // Only wait for the dump thread when it has fallen behind by a whole queue of frames.
+    const u32 max_queued_frames = static_cast<u32>(std::max(g_ActiveConfig.iFrameDumpQueueSize, 1));
+    std::unique_lock<std::mutex> lock(m_frame_dump_queue_lock);
+    if (m_frame_dump_frames_pending >= max_queued_frames)
+    {
+      m_frame_dump_stalls++;
+      m_frame_dump_queue_changed.wait(
+          lock, [&] { return m_frame_dump_frames_pending < max_queued_frames; });
+    }
+
+    if (!m_frame_dump_free_buffers.empty())
+    {
+      frame.data = std::move(m_frame_dump_free_buffers.back());
+      m_frame_dump_free_buffers.pop_back();
+    }
+  }
+
+  frame.data.resize(static_cast<size_t>(stride) * h);
+  std::memcpy(frame.data.data(), data, frame.data.size());
+  frame.config = FrameDumpConfig{frame.data.data(), w, h, stride, state};
+  frame.save_screenshot = save_screenshot;
+  frame.dump_frame = dump_frame;
+  frame.log_checksum = log_checksum;
+
+  {
+    std::lock_guard<std::mutex> guard(m_frame_dump_queue_lock);
+    m_frame_dump_queue.push_back(std::move(frame));
+    m_frame_dump_frames_pending++;
+  }
+  m_frame_dump_queue_changed.notify_all();
 }
 
 void Renderer::FinishFrameData()
 {
-  if (!m_frame_dump_frame_running)
-    return;
+  std::unique_lock<std::mutex> lock(m_frame_dump_queue_lock);
+  m_frame_dump_queue_changed.wait(lock, [this] { return m_frame_dump_frames_pending == 0; });
+}
+
+// Hashes the colour of each pixel in an RGBA8 frame. Alpha is ignored, as it is not part of the
+// output, and row padding is skipped, since it depends on the backend.
+static u64 HashFrame(const u8* data, int width, int height, int stride)
+{
+  XXH64_state_t* const state = XXH64_createState();
+  XXH64_reset(state, 0);
 
-  m_frame_dump_done.Wait();
-  m_frame_dump_frame_running = false;
+  std::vector<u32> row(width);
+  for (int y = 0; y < height; y++)
+  {
+    std::memcpy(row.data(), data + y * stride, row.size() * sizeof(u32));
+    for (u32& pixel : row)
+      pixel |= 0xFF000000;
+    XXH64_update(state, row.data(), row.size() * sizeof(u32));
+  }
+
+  const u64 hash = XXH64_digest(state);
+  XXH64_freeState(state);
+  return hash;
 }
 
 void Renderer::RunFrameDumps()
@@ -1526,6 +1617,12 @@ void Renderer::RunFrameDumps()
   Common::SetCurrentThreadName("FrameDumping");
   bool dump_to_ffmpeg = !g_ActiveConfig.bDumpFramesAsImages;
   bool frame_dump_started = false;
+  bool frame_dump_failed = false;
+
+  // The checksum log is started with the first frame, and numbers frames from there.
+  File::IOFile checksum_file;
+  bool checksum_log_started = false;
+  u32 checksum_frame_number = 0;
 
 // If Dolphin was compiled without ffmpeg, we only support dumping to images.
 #if !defined(HAVE_FFMPEG)
@@ -1539,14 +1636,23 @@ void Renderer::RunFrameDumps()
 
   while (true)
   {
-    m_frame_dump_start.Wait();
-    if (!m_frame_dump_thread_running.IsSet())
-      break;
+    QueuedFrameDump frame;
+    {
+      std::unique_lock<std::mutex> lock(m_frame_dump_queue_lock);
+      m_frame_dump_queue_changed.wait(lock, [this] {
+        return !m_frame_dump_queue.empty() || !m_frame_dump_thread_running.IsSet();
+      });
+      if (m_frame_dump_queue.empty())
+        break;
+
+      frame = std::move(m_frame_dump_queue.front());
+      m_frame_dump_queue.pop_front();
+    }
 
-    auto config = m_frame_dump_config;
+    const FrameDumpConfig& config = frame.config;
 
     // Save screenshot
-    if (m_screenshot_request.TestAndClear())
+    if (frame.save_screenshot)
     {
       std::lock_guard<std::mutex> lk(m_screenshot_lock);
 
@@ -1559,7 +1665,32 @@ void Renderer::RunFrameDumps()
       m_screenshot_completed.Set();
     }
 
-    if (SConfig::GetInstance().m_DumpFrames)
+    if (frame.log_checksum)
+    {
+      if (!checksum_log_started)
+      {
+        checksum_log_started = true;
+        const std::string filename = File::GetUserPath(D_DUMPFRAMES_IDX) + FRAME_CHECKSUM_LOG;
+        File::CreateFullPath(filename);
+        if (checksum_file.Open(filename, "w"))
+          NOTICE_LOG(VIDEO, "Logging frame checksums to %s", filename.c_str());
+        else
+          ERROR_LOG(VIDEO, "Could not open frame checksum log %s", filename.c_str());
+      }
+
+      // One line per frame: frame number, emulated time in ticks, resolution and checksum.
+      const std::string line = StringFromFormat(
+          "%u %" PRIu64 " %dx%d %016" PRIx64 "\n", checksum_frame_number++, config.state.ticks,
+          config.width, config.height,
+          HashFrame(config.data, config.width, config.height, config.stride));
+      checksum_file.WriteBytes(line.data(), line.size());
+    }
+
+    // Frames which were queued before dumping was stopped are still written, the dumper is only
+    // stopped once the queue has drained and the thread exits.
+    if (!frame.dump_frame)
+      frame_dump_failed = false;
+    else if (!frame_dump_failed)
     {
       if (!frame_dump_started)
       {
@@ -1568,9 +1699,12 @@ void Renderer::RunFrameDumps()
         else
           frame_dump_started = StartFrameDumpToImage(config);
 
-        // Stop frame dumping if we fail to start.
+        // Stop frame dumping if we fail to start, and don't retry for the frames already queued.
         if (!frame_dump_started)
+        {
+          frame_dump_failed = true;
           SConfig::GetInstance().m_DumpFrames = false;
+        }
       }
 
       // If we failed to start frame dumping, don't write a frame.
@@ -1583,7 +1717,13 @@ void Renderer::RunFrameDumps()
       }
     }
 
-    m_frame_dump_done.Set();
+    // Return the buffer, so the next frame doesn't have to allocate one.
+    {
+      std::lock_guard<std::mutex> guard(m_frame_dump_queue_lock);
+      m_frame_dump_free_buffers.push_back(std::move(frame.data));
+      m_frame_dump_frames_pending--;
+    }
+    m_frame_dump_queue_changed.notify_all();
   }
 
   if (frame_dump_started)
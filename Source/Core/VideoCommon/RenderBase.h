@@ -15,6 +15,8 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -215,6 +217,12 @@ public:
   virtual void BBoxWrite(int index, u16 value) = 0;
   virtual void BBoxFlush() {}
 
+  // Timestamps for the timeline profiler. WriteGPUTimestamp() records when the host GPU reaches
+  // this point in the command stream, returning 0 if the backend can't. ReadGPUTimestamp() waits
+  // for the timestamp and releases it, returning it in microseconds on the steady_clock timeline.
+  virtual u32 WriteGPUTimestamp() { return 0; }
+  virtual u64 ReadGPUTimestamp(u32 timestamp) { return 0; }
+
   virtual void Flush() {}
   virtual void WaitForGPUIdle() {}
 
@@ -336,11 +344,8 @@ private:
 
   // frame dumping
   std::thread m_frame_dump_thread;
-  Common::Event m_frame_dump_start;
-  Common::Event m_frame_dump_done;
   Common::Flag m_frame_dump_thread_running;
   u32 m_frame_dump_image_counter = 0;
-  bool m_frame_dump_frame_running = false;
   struct FrameDumpConfig
   {
     const u8* data;
@@ -348,14 +353,52 @@ private:
     int height;
     int stride;
     FrameDump::Frame state;
-  } m_frame_dump_config;
+  };
+
+  // Frames waiting for the frame dumping thread. The image is copied out of the readback texture,
+  // so that the texture can be reused while the frame is being encoded.
+  struct QueuedFrameDump
+  {
+    std::vector<u8> data;
+    FrameDumpConfig config;
+    bool save_screenshot;
+    bool dump_frame;
+    bool log_checksum;
+  };
+  std::deque<QueuedFrameDump> m_frame_dump_queue;
+  std::vector<std::vector<u8>> m_frame_dump_free_buffers;
+  std::mutex m_frame_dump_queue_lock;
+  std::condition_variable m_frame_dump_queue_changed;
+
+  // Number of frames which have been queued, but not yet written. Includes the frame currently
+  // being encoded, which is no longer in the queue.
+  u32 m_frame_dump_frames_pending = 0;
+
+  // Number of times the queue was full, and the GPU thread had to wait for the dump thread.
+  u32 m_frame_dump_stalls = 0;
 
   // Texture used for screenshot/frame dumping
   std::unique_ptr<AbstractTexture> m_frame_dump_render_texture;
   std::unique_ptr<AbstractFramebuffer> m_frame_dump_render_framebuffer;
-  std::array<std::unique_ptr<AbstractStagingTexture>, 2> m_frame_dump_readback_textures;
-  FrameDump::Frame m_last_frame_state;
-  bool m_last_frame_exported = false;
+
+  // Frames are copied to a ring of readback textures, and only mapped a few frames later, by
+  // which point the GPU has finished the copy and mapping does not stall.
+  static constexpr u32 NUM_FRAME_DUMP_READBACK_TEXTURES = 3;
+  std::array<std::unique_ptr<AbstractStagingTexture>, NUM_FRAME_DUMP_READBACK_TEXTURES>
+      m_frame_dump_readback_textures;
+
+  // Whether a frame is dumped or logged is decided when it is copied, so that frames which were
+  // in flight when dumping was stopped are still written out.
+  struct FrameDumpReadbackState
+  {
+    FrameDump::Frame state;
+    bool dump_frame;
+    bool log_checksum;
+  };
+  std::array<FrameDumpReadbackState, NUM_FRAME_DUMP_READBACK_TEXTURES>
+      m_frame_dump_readback_states;
+  u32 m_frame_dump_readback_head = 0;
+  u32 m_frame_dump_readback_pending = 0;
 
   // Tracking of XFB textures so we don't render duplicate frames.
   u64 m_last_xfb_id = std::numeric_limits<u64>::max();
@@ -376,18 +419,27 @@ private:
 
   bool IsFrameDumping() const;
 
+  // Returns true if every frame is read back, rather than only the next one for a screenshot.
+  bool IsReadingBackAllFrames() const;
+
   // Checks that the frame dump render texture exists and is the correct size.
   bool CheckFrameDumpRenderTexture(u32 target_width, u32 target_height);
 
-  // Checks that the frame dump readback texture exists and is the correct size.
+  // Checks that the frame dump readback texture at the head of the ring exists and is the correct
+  // size.
   bool CheckFrameDumpReadbackTexture(u32 target_width, u32 target_height);
 
   // Fills the frame dump staging texture with the current XFB texture.
   void DumpCurrentFrame(const AbstractTexture* src_texture,
                         const MathUtil::Rectangle<int>& src_rect, u64 ticks);
 
-  // Asynchronously encodes the specified pointer of frame data to the frame dump.
-  void DumpFrameData(const u8* data, int w, int h, int stride, const FrameDump::Frame& state);
+  // Copies the specified frame data to the queue of the frame dumping thread. Only blocks if the
+  // queue is full.
+  void DumpFrameData(const u8* data, int w, int h, int stride, const FrameDump::Frame& state,
+                     bool save_screenshot, bool dump_frame, bool log_checksum);
+
+  // Queues the oldest read back frames for encoding, until at most max_pending remain.
+  void QueueFrameDumpReadbacks(u32 max_pending);
 
   // Ensures all rendered frames are queued for encoding.
   void FlushFrameDump();
@@ -4,6 +4,9 @@
 
 #include "VideoCommon/ShaderCache.h"
 
+#include <algorithm>
+#include <cinttypes>
+
 #include "Common/Assert.h"
 #include "Common/FileUtil.h"
 #include "Common/MsgHandler.h"
@@ -49,6 +52,8 @@ void ShaderCache::InitializeShaderCache()
   {
     LoadCaches();
     LoadPipelineUIDCache();
+    if (g_ActiveConfig.bPredictPipelines)
+      LoadPipelineHintCache();
   }
 
   // Queue ubershader precompiling if required.
@@ -66,10 +71,21 @@ void ShaderCache::InitializeShaderCache()
 
 void ShaderCache::Reload()
 {
+  // Anything which hasn't started compiling yet was generated for the old host config, so there
+  // is no point in waiting for it. Items already on a worker still have to finish.
+  m_async_shader_compiler->CancelPendingWork();
   WaitForAsyncCompiler();
   ClosePipelineUIDCache();
   ClearCaches();
 
+  // The cancelled pipelines are no longer pending, so close their fallback episodes. Pipelines
+  // which were predicted before have to be predictable again, as their compiles may have been
+  // cancelled or dropped with the caches.
+  for (const auto& it : m_gx_pipeline_usage)
+    EndUberShaderFallback(it.first);
+  m_current_fallback_usage = nullptr;
+  m_predicted_pipelines.clear();
+
   if (g_ActiveConfig.bShaderCache)
     LoadCaches();
 
@@ -88,6 +104,20 @@ void ShaderCache::Reload()
 void ShaderCache::RetrieveAsyncShaders()
 {
   m_async_shader_compiler->RetrieveWorkItems();
+  m_frame_counter++;
+
+  // Publish the compiler metrics for the statistics window. Latencies are per frame.
+  static_assert(AsyncShaderCompiler::NUM_PRIORITIES ==
+                std::tuple_size_v<decltype(g_stats.num_pending_compiles)>);
+  const AsyncShaderCompiler::Metrics metrics = m_async_shader_compiler->GetMetrics();
+  for (size_t i = 0; i < AsyncShaderCompiler::NUM_PRIORITIES; i++)
+  {
+    SETSTAT(g_stats.num_pending_compiles[i], metrics[i].queue_depth);
+    SETSTAT(g_stats.this_frame.num_compiles_retrieved[i], metrics[i].items_retrieved);
+    SETSTAT(g_stats.this_frame.max_compile_latency_ms[i], metrics[i].max_latency_us / 1000);
+  }
+  m_async_shader_compiler->ResetMetrics();
+  SETSTAT(g_stats.num_ubershader_pipelines, m_num_ubershader_pipelines);
 }
 
 void ShaderCache::Shutdown()
@@ -97,7 +127,9 @@ void ShaderCache::Shutdown()
   if (m_async_shader_compiler)
     m_async_shader_compiler->StopWorkerThreads();
 
+  LogPipelineUsageSummary();
   ClosePipelineUIDCache();
+  ClosePipelineHintCache();
 }
 
 const AbstractPipeline* ShaderCache::GetPipelineForUid(const GXPipelineUid& uid)
@@ -118,14 +150,20 @@ const AbstractPipeline* ShaderCache::GetPipelineForUid(const GXPipelineUid& uid)
 
 std::optional<const AbstractPipeline*> ShaderCache::GetPipelineForUidAsync(const GXPipelineUid& uid)
 {
+  if (g_ActiveConfig.bPredictPipelines)
+    QueuePredictedPipelines(uid);
+
+  // Draws are only attributed to this pipeline once the caller falls back to the ubershader.
+  m_current_fallback_usage = nullptr;
+
   auto it = m_gx_pipeline_cache.find(uid);
   if (it != m_gx_pipeline_cache.end())
   {
     // .second is the pending flag, i.e. compiling in the background.
     if (!it->second.second)
       return it->second.first.get();
-    else
-      return {};
+
+    return {};
   }
 
   AppendGXPipelineUID(uid);
@@ -133,6 +171,22 @@ std::optional<const AbstractPipeline*> ShaderCache::GetPipelineForUidAsync(const
   return {};
 }
 
+void ShaderCache::RecordUberShaderFallbackDraw()
+{
+  INCSTAT(g_stats.this_frame.num_ubershader_draws);
+
+  GXPipelineUsage* usage = m_current_fallback_usage;
+  if (!usage || !usage->on_ubershader)
+    return;
+
+  usage->ubershader_draws++;
+  if (usage->last_draw_frame != m_frame_counter)
+  {
+    usage->last_draw_frame = m_frame_counter;
+    usage->ubershader_frames++;
+  }
+}
+
 const AbstractPipeline* ShaderCache::GetUberPipelineForUid(const GXUberPipelineUid& uid)
 {
   auto it = m_gx_uber_pipeline_cache.find(uid);
@@ -650,6 +704,7 @@ const AbstractPipeline* ShaderCache::InsertGXPipeline(const GXPipelineUid& confi
 {
   auto& entry = m_gx_pipeline_cache[config];
   entry.second = false;
+  EndUberShaderFallback(config);
   if (!entry.first && pipeline)
   {
     entry.first = std::move(pipeline);
@@ -804,7 +859,228 @@ void ShaderCache::AppendGXPipelineUID(const GXPipelineUid& config)
   }
 }
 
-void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority)
+void ShaderCache::BeginUberShaderFallback(const GXPipelineUid& uid)
+{
+  GXPipelineUsage& usage = m_gx_pipeline_usage[uid];
+  if (!usage.on_ubershader)
+  {
+    usage.on_ubershader = true;
+    usage.pending_since = std::chrono::steady_clock::now();
+    usage.fallback_episodes++;
+    m_num_ubershader_pipelines++;
+  }
+
+  m_current_fallback_usage = &usage;
+}
+
+void ShaderCache::EndUberShaderFallback(const GXPipelineUid& uid)
+{
+  // Most pipelines are inserted by the precompiler without ever being requested.
+  if (m_num_ubershader_pipelines == 0)
+    return;
+
+  auto iter = m_gx_pipeline_usage.find(uid);
+  if (iter == m_gx_pipeline_usage.end() || !iter->second.on_ubershader)
+    return;
+
+  GXPipelineUsage& usage = iter->second;
+  usage.on_ubershader = false;
+  usage.ubershader_time_us += static_cast<u64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                            usage.pending_since)
+          .count());
+  m_num_ubershader_pipelines--;
+}
+
+void ShaderCache::LogPipelineUsageSummary() const
+{
+  if (m_gx_pipeline_usage.empty())
+    return;
+
+  u64 total_time_us = 0;
+  u64 max_time_us = 0;
+  u64 total_draws = 0;
+  u64 total_frames = 0;
+  size_t recurring_pipelines = 0;
+  for (const auto& it : m_gx_pipeline_usage)
+  {
+    const GXPipelineUsage& usage = it.second;
+    total_time_us += usage.ubershader_time_us;
+    max_time_us = std::max(max_time_us, usage.ubershader_time_us);
+    total_draws += usage.ubershader_draws;
+    total_frames += usage.ubershader_frames;
+    if (usage.fallback_episodes > 1)
+      recurring_pipelines++;
+  }
+
+  INFO_LOG(VIDEO,
+           "%zu pipelines used ubershaders while compiling: %" PRIu64 " ms total, %" PRIu64
+           " ms worst, %" PRIu64 " draws over %" PRIu64 " pipeline-frames, %zu recurred",
+           m_gx_pipeline_usage.size(), total_time_us / 1000, max_time_us / 1000, total_draws,
+           total_frames, recurring_pipelines);
+}
+
+void ShaderCache::LoadPipelineHintCache()
+{
+  constexpr u32 CACHE_FILE_MAGIC = 0x544E4850;  // PHNT
+  constexpr size_t CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
+  constexpr size_t CACHE_ENTRY_SIZE = sizeof(SerializedGXPipelineUid) * 2;
+  std::string filename =
+      File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID() + ".pipelinehints";
+  if (m_gx_pipeline_hint_file.Open(filename, "rb+"))
+  {
+    u32 existing_magic;
+    u32 existing_version;
+    bool hint_file_valid = false;
+    if (m_gx_pipeline_hint_file.ReadBytes(&existing_magic, sizeof(existing_magic)) &&
+        m_gx_pipeline_hint_file.ReadBytes(&existing_version, sizeof(existing_version)) &&
+        existing_magic == CACHE_FILE_MAGIC && existing_version == GX_PIPELINE_UID_VERSION)
+    {
+      // A trailing partial entry (e.g. from a crash while appending) is ignored, and overwritten
+      // by the next append.
+      const u64 file_size = m_gx_pipeline_hint_file.GetSize();
+      const size_t entry_count =
+          static_cast<size_t>(file_size - CACHE_HEADER_SIZE) / CACHE_ENTRY_SIZE;
+      hint_file_valid = true;
+      for (size_t i = 0; i < entry_count; i++)
+      {
+        std::array<SerializedGXPipelineUid, 2> entry;
+        if (!m_gx_pipeline_hint_file.ReadBytes(entry.data(), CACHE_ENTRY_SIZE))
+        {
+          hint_file_valid = false;
+          break;
+        }
+
+        GXPipelineUid from, to;
+        UnserializePipelineUid(entry[0], from);
+        UnserializePipelineUid(entry[1], to);
+        AddPipelineTransition(from, to, PIPELINE_PREDICTION_THRESHOLD, false);
+      }
+
+      if (hint_file_valid)
+      {
+        hint_file_valid = m_gx_pipeline_hint_file.Seek(
+            CACHE_HEADER_SIZE + entry_count * CACHE_ENTRY_SIZE, SEEK_SET);
+      }
+    }
+
+    if (!hint_file_valid)
+      m_gx_pipeline_hint_file.Close();
+  }
+
+  if (!m_gx_pipeline_hint_file.IsOpen())
+  {
+    if (m_gx_pipeline_hint_file.Open(filename, "wb"))
+    {
+      m_gx_pipeline_hint_file.WriteBytes(&CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+      m_gx_pipeline_hint_file.WriteBytes(&GX_PIPELINE_UID_VERSION,
+                                         sizeof(GX_PIPELINE_UID_VERSION));
+
+      // Keep any transitions which were read before the file turned out to be invalid.
+      for (const auto& it : m_gx_pipeline_successors)
+      {
+        for (const GXPipelineSuccessor& successor : it.second)
+        {
+          if (successor.count >= PIPELINE_PREDICTION_THRESHOLD)
+            AppendPipelineHint(it.first, successor.uid);
+        }
+      }
+    }
+  }
+
+  INFO_LOG(VIDEO, "Read pipeline hints for %u pipelines from %s",
+           static_cast<unsigned>(m_gx_pipeline_successors.size()), filename.c_str());
+}
+
+void ShaderCache::ClosePipelineHintCache()
+{
+  m_gx_pipeline_hint_file.Close();
+}
+
+void ShaderCache::AddPipelineTransition(const GXPipelineUid& from, const GXPipelineUid& to,
+                                        u32 count, bool append_to_cache)
+{
+  std::vector<GXPipelineSuccessor>& successors = m_gx_pipeline_successors[from];
+  auto iter =
+      std::find_if(successors.begin(), successors.end(),
+                   [&to](const GXPipelineSuccessor& successor) { return successor.uid == to; });
+  if (iter == successors.end())
+  {
+    if (successors.size() < MAX_PIPELINE_SUCCESSORS)
+    {
+      iter = successors.insert(successors.end(), GXPipelineSuccessor{to, 0});
+    }
+    else
+    {
+      // Only transitions which haven't been confirmed yet are replaced, so that a stream of
+      // one-off transitions can't push out the established ones.
+      iter = std::min_element(successors.begin(), successors.end(),
+                              [](const GXPipelineSuccessor& lhs, const GXPipelineSuccessor& rhs) {
+                                return lhs.count < rhs.count;
+                              });
+      if (iter->count >= PIPELINE_PREDICTION_THRESHOLD)
+        return;
+
+      *iter = GXPipelineSuccessor{to, 0};
+    }
+  }
+
+  const u32 previous_count = iter->count;
+  iter->count += count;
+  if (append_to_cache && previous_count < PIPELINE_PREDICTION_THRESHOLD &&
+      iter->count >= PIPELINE_PREDICTION_THRESHOLD)
+  {
+    AppendPipelineHint(from, to);
+  }
+}
+
+void ShaderCache::AppendPipelineHint(const GXPipelineUid& from, const GXPipelineUid& to)
+{
+  if (!m_gx_pipeline_hint_file.IsOpen())
+    return;
+
+  std::array<SerializedGXPipelineUid, 2> entry;
+  SerializePipelineUid(from, entry[0]);
+  SerializePipelineUid(to, entry[1]);
+  if (!m_gx_pipeline_hint_file.WriteBytes(entry.data(), sizeof(entry)))
+  {
+    WARN_LOG(VIDEO, "Writing pipeline hint to cache failed, closing file.");
+    m_gx_pipeline_hint_file.Close();
+  }
+}
+
+void ShaderCache::QueuePredictedPipelines(const GXPipelineUid& uid)
+{
+  if (m_last_requested_pipeline && *m_last_requested_pipeline != uid)
+    AddPipelineTransition(*m_last_requested_pipeline, uid, 1, true);
+  m_last_requested_pipeline = uid;
+
+  auto iter = m_gx_pipeline_successors.find(uid);
+  if (iter == m_gx_pipeline_successors.end())
+    return;
+
+  for (const GXPipelineSuccessor& successor : iter->second)
+  {
+    if (successor.count < PIPELINE_PREDICTION_THRESHOLD ||
+        !m_predicted_pipelines.insert(successor.uid).second)
+    {
+      continue;
+    }
+
+    // A pipeline which is still waiting in the precompile lane is queued again at the predicted
+    // priority. Whichever copy completes first is kept, InsertGXPipeline() discards the other.
+    auto cache_iter = m_gx_pipeline_cache.find(successor.uid);
+    if (cache_iter == m_gx_pipeline_cache.end())
+      AppendGXPipelineUID(successor.uid);
+    else if (!cache_iter->second.second)
+      continue;
+
+    QueuePipelineCompile(successor.uid, COMPILE_PRIORITY_PREDICTED_PIPELINE);
+    INCSTAT(g_stats.num_predicted_pipelines);
+  }
+}
+
+void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, CompilePriority priority)
 {
   class VertexShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -822,6 +1098,15 @@ void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 prior
 
     void Retrieve() override { shader_cache->InsertVertexShader(uid, std::move(shader)); }
 
+    void Cancel() override
+    {
+      // Drop the pending entry, so the stage is queued again when a pipeline next needs it.
+      auto& shader_map = shader_cache->m_vs_cache.shader_map;
+      auto iter = shader_map.find(uid);
+      if (iter != shader_map.end() && !iter->second.shader)
+        shader_map.erase(iter);
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
@@ -833,7 +1118,8 @@ void ShaderCache::QueueVertexShaderCompile(const VertexShaderUid& uid, u32 prior
   m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
 }
 
-void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority)
+void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid,
+                                               CompilePriority priority)
 {
   class VertexUberShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -851,6 +1137,15 @@ void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid
 
     void Retrieve() override { shader_cache->InsertVertexUberShader(uid, std::move(shader)); }
 
+    void Cancel() override
+    {
+      // Drop the pending entry, so the stage is queued again when a pipeline next needs it.
+      auto& shader_map = shader_cache->m_uber_vs_cache.shader_map;
+      auto iter = shader_map.find(uid);
+      if (iter != shader_map.end() && !iter->second.shader)
+        shader_map.erase(iter);
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
@@ -862,7 +1157,7 @@ void ShaderCache::QueueVertexUberShaderCompile(const UberShader::VertexShaderUid
   m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
 }
 
-void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priority)
+void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, CompilePriority priority)
 {
   class PixelShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -880,6 +1175,15 @@ void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priorit
 
     void Retrieve() override { shader_cache->InsertPixelShader(uid, std::move(shader)); }
 
+    void Cancel() override
+    {
+      // Drop the pending entry, so the stage is queued again when a pipeline next needs it.
+      auto& shader_map = shader_cache->m_ps_cache.shader_map;
+      auto iter = shader_map.find(uid);
+      if (iter != shader_map.end() && !iter->second.shader)
+        shader_map.erase(iter);
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
@@ -891,7 +1195,8 @@ void ShaderCache::QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priorit
   m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
 }
 
-void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority)
+void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid,
+                                              CompilePriority priority)
 {
   class PixelUberShaderWorkItem final : public AsyncShaderCompiler::WorkItem
   {
@@ -909,6 +1214,15 @@ void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid&
 
     void Retrieve() override { shader_cache->InsertPixelUberShader(uid, std::move(shader)); }
 
+    void Cancel() override
+    {
+      // Drop the pending entry, so the stage is queued again when a pipeline next needs it.
+      auto& shader_map = shader_cache->m_uber_ps_cache.shader_map;
+      auto iter = shader_map.find(uid);
+      if (iter != shader_map.end() && !iter->second.shader)
+        shader_map.erase(iter);
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractShader> shader;
@@ -920,12 +1234,13 @@ void ShaderCache::QueuePixelUberShaderCompile(const UberShader::PixelShaderUid&
   m_async_shader_compiler->QueueWorkItem(std::move(wi), priority);
 }
 
-void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
+void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, CompilePriority priority)
 {
   class PipelineWorkItem final : public AsyncShaderCompiler::WorkItem
   {
   public:
-    PipelineWorkItem(ShaderCache* shader_cache_, const GXPipelineUid& uid_, u32 priority_)
+    PipelineWorkItem(ShaderCache* shader_cache_, const GXPipelineUid& uid_,
+                     CompilePriority priority_)
         : shader_cache(shader_cache_), uid(uid_), priority(priority_)
     {
       // Check if all the stages required for this pipeline have been compiled.
@@ -976,11 +1291,20 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
       }
     }
 
+    void Cancel() override
+    {
+      // Leave the UID in the map with a null pipeline, CompileMissingPipelines() will queue it
+      // again after the caches are reloaded.
+      auto iter = shader_cache->m_gx_pipeline_cache.find(uid);
+      if (iter != shader_cache->m_gx_pipeline_cache.end())
+        iter->second.second = false;
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractPipeline> pipeline;
     GXPipelineUid uid;
-    u32 priority;
+    CompilePriority priority;
     std::optional<AbstractPipelineConfig> config;
     bool stages_ready;
   };
@@ -990,12 +1314,14 @@ void ShaderCache::QueuePipelineCompile(const GXPipelineUid& uid, u32 priority)
   m_gx_pipeline_cache[uid].second = true;
 }
 
-void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 priority)
+void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid,
+                                           CompilePriority priority)
 {
   class UberPipelineWorkItem final : public AsyncShaderCompiler::WorkItem
   {
   public:
-    UberPipelineWorkItem(ShaderCache* shader_cache_, const GXUberPipelineUid& uid_, u32 priority_)
+    UberPipelineWorkItem(ShaderCache* shader_cache_, const GXUberPipelineUid& uid_,
+                         CompilePriority priority_)
         : shader_cache(shader_cache_), uid(uid_), priority(priority_)
     {
       // Check if all the stages required for this UberPipeline have been compiled.
@@ -1049,11 +1375,18 @@ void ShaderCache::QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 pri
       }
     }
 
+    void Cancel() override
+    {
+      auto iter = shader_cache->m_gx_uber_pipeline_cache.find(uid);
+      if (iter != shader_cache->m_gx_uber_pipeline_cache.end())
+        iter->second.second = false;
+    }
+
   private:
     ShaderCache* shader_cache;
     std::unique_ptr<AbstractPipeline> UberPipeline;
     GXUberPipelineUid uid;
-    u32 priority;
+    CompilePriority priority;
     std::optional<AbstractPipelineConfig> config;
     bool stages_ready;
   };
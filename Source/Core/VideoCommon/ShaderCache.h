@@ -5,14 +5,17 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
 #include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
@@ -69,6 +72,11 @@ public:
   // The optional will be empty if this pipeline is now background compiling.
   std::optional<const AbstractPipeline*> GetPipelineForUidAsync(const GXPipelineUid& uid);
 
+  // Called when an ubershader is used in place of a pipeline which GetPipelineForUidAsync() found
+  // to still be compiling, and for every draw made with it until the pipeline is ready.
+  void BeginUberShaderFallback(const GXPipelineUid& uid);
+  void RecordUberShaderFallbackDraw();
+
   // Shared shaders
   const AbstractShader* GetScreenQuadVertexShader() const
   {
@@ -115,6 +123,19 @@ public:
 private:
   static constexpr size_t NUM_PALETTE_CONVERSION_SHADERS = 3;
 
+  // Priorities for compiling. The shader cache is compiled last, as it is the least likely to be
+  // required. On demand shaders are always compiled before pending ubershaders, as we want to use
+  // the ubershader for as few frames as possible, otherwise we risk framerate drops. Predicted
+  // pipelines are likely to be needed within the next few draws, so they come right after.
+  using CompilePriority = AsyncShaderCompiler::Priority;
+  static constexpr CompilePriority COMPILE_PRIORITY_ONDEMAND_PIPELINE = CompilePriority::OnDemand;
+  static constexpr CompilePriority COMPILE_PRIORITY_PREDICTED_PIPELINE =
+      CompilePriority::Predicted;
+  static constexpr CompilePriority COMPILE_PRIORITY_UBERSHADER_PIPELINE =
+      CompilePriority::UberShader;
+  static constexpr CompilePriority COMPILE_PRIORITY_SHADERCACHE_PIPELINE =
+      CompilePriority::Precompile;
+
   void WaitForAsyncCompiler();
   void LoadCaches();
   void ClearCaches();
@@ -160,13 +181,27 @@ private:
   void AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid);
   void AppendGXPipelineUID(const GXPipelineUid& config);
 
+  // Hybrid ubershader instrumentation
+  void EndUberShaderFallback(const GXPipelineUid& uid);
+  void LogPipelineUsageSummary() const;
+
+  // Predictive pipeline compilation
+  void LoadPipelineHintCache();
+  void ClosePipelineHintCache();
+  void AddPipelineTransition(const GXPipelineUid& from, const GXPipelineUid& to, u32 count,
+                             bool append_to_cache);
+  void AppendPipelineHint(const GXPipelineUid& from, const GXPipelineUid& to);
+  void QueuePredictedPipelines(const GXPipelineUid& uid);
+
   // ASync Compiler Methods
-  void QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority);
-  void QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid, u32 priority);
-  void QueuePixelShaderCompile(const PixelShaderUid& uid, u32 priority);
-  void QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid, u32 priority);
-  void QueuePipelineCompile(const GXPipelineUid& uid, u32 priority);
-  void QueueUberPipelineCompile(const GXUberPipelineUid& uid, u32 priority);
+  void QueueVertexShaderCompile(const VertexShaderUid& uid, CompilePriority priority);
+  void QueueVertexUberShaderCompile(const UberShader::VertexShaderUid& uid,
+                                    CompilePriority priority);
+  void QueuePixelShaderCompile(const PixelShaderUid& uid, CompilePriority priority);
+  void QueuePixelUberShaderCompile(const UberShader::PixelShaderUid& uid,
+                                   CompilePriority priority);
+  void QueuePipelineCompile(const GXPipelineUid& uid, CompilePriority priority);
+  void QueueUberPipelineCompile(const GXUberPipelineUid& uid, CompilePriority priority);
 
   // Populating various caches.
   template <ShaderStage stage, typename K, typename T>
@@ -179,17 +214,6 @@ private:
   template <typename T, typename Y>
   void ClearPipelineCache(T& cache, Y& disk_cache);
 
-  // Priorities for compiling. The lower the value, the sooner the pipeline is compiled.
-  // The shader cache is compiled last, as it is the least likely to be required. On demand
-  // shaders are always compiled before pending ubershaders, as we want to use the ubershader
-  // for as few frames as possible, otherwise we risk framerate drops.
-  enum : u32
-  {
-    COMPILE_PRIORITY_ONDEMAND_PIPELINE = 100,
-    COMPILE_PRIORITY_UBERSHADER_PIPELINE = 200,
-    COMPILE_PRIORITY_SHADERCACHE_PIPELINE = 300
-  };
-
   // Configuration bits.
   APIType m_api_type = APIType::Nothing;
   ShaderHostConfig m_host_config = {};
@@ -230,6 +254,38 @@ private:
   LinearDiskCache<SerializedGXPipelineUid, u8> m_gx_pipeline_disk_cache;
   LinearDiskCache<SerializedGXUberPipelineUid, u8> m_gx_uber_pipeline_disk_cache;
 
+  // Time and draws spent on the ubershader while each specialized pipeline was compiling.
+  // An episode starts when the ubershader is first used for a pending pipeline, and ends when it is inserted.
+  struct GXPipelineUsage
+  {
+    std::chrono::steady_clock::time_point pending_since;
+    u64 ubershader_time_us = 0;
+    u64 ubershader_draws = 0;
+    u64 last_draw_frame = 0;
+    u32 ubershader_frames = 0;
+    u32 fallback_episodes = 0;
+    bool on_ubershader = false;
+  };
+  std::map<GXPipelineUid, GXPipelineUsage> m_gx_pipeline_usage;
+  GXPipelineUsage* m_current_fallback_usage = nullptr;
+  u32 m_num_ubershader_pipelines = 0;
+  u64 m_frame_counter = 1;
+
+  // Pipelines which followed each pipeline, with the number of times the transition was seen.
+  // Transitions which are seen PIPELINE_PREDICTION_THRESHOLD times are written to the hint cache,
+  // and used for prediction in later sessions.
+  static constexpr size_t MAX_PIPELINE_SUCCESSORS = 4;
+  static constexpr u32 PIPELINE_PREDICTION_THRESHOLD = 2;
+  struct GXPipelineSuccessor
+  {
+    GXPipelineUid uid;
+    u32 count;
+  };
+  std::map<GXPipelineUid, std::vector<GXPipelineSuccessor>> m_gx_pipeline_successors;
+  std::set<GXPipelineUid> m_predicted_pipelines;
+  std::optional<GXPipelineUid> m_last_requested_pipeline;
+  File::IOFile m_gx_pipeline_hint_file;
+
   // EFB copy to VRAM/RAM pipelines
   std::map<TextureConversionShaderGen::TCShaderUid, std::unique_ptr<AbstractPipeline>>
       m_efb_copy_to_vram_pipelines;
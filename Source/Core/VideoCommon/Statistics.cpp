@@ -83,9 +83,27 @@ void Statistics::Display() const
   draw_statistic("Vertex streamed", "%i kB", this_frame.bytes_vertex_streamed / 1024);
   draw_statistic("Index streamed", "%i kB", this_frame.bytes_index_streamed / 1024);
   draw_statistic("Uniform streamed", "%i kB", this_frame.bytes_uniform_streamed / 1024);
+  draw_statistic("Stream buffer stalls", "%d (%.2f ms)", this_frame.num_stream_buffer_stalls,
+                 this_frame.stream_buffer_stall_time_us / 1000.0f);
   draw_statistic("Vertex Loaders", "%d", num_vertex_loaders);
   draw_statistic("EFB peeks:", "%d", this_frame.num_efb_peeks);
   draw_statistic("EFB pokes:", "%d", this_frame.num_efb_pokes);
+  draw_statistic("EFB peek syncs:", "%d", this_frame.num_efb_peek_syncs);
+  draw_statistic("EFB tiles prefetched:", "%d", this_frame.num_efb_tiles_prefetched);
+  draw_statistic("BBox syncs:", "%d (%.2f ms)", this_frame.num_bbox_syncs,
+                 this_frame.bbox_stall_time_us / 1000.0f);
+  draw_statistic("BBox async readbacks:", "%d", this_frame.num_bbox_readbacks);
+  draw_statistic("Pending compiles", "%d / %d / %d / %d", num_pending_compiles[0],
+                 num_pending_compiles[1], num_pending_compiles[2], num_pending_compiles[3]);
+  draw_statistic("Compiles retrieved", "%d / %d / %d / %d", this_frame.num_compiles_retrieved[0],
+                 this_frame.num_compiles_retrieved[1], this_frame.num_compiles_retrieved[2],
+                 this_frame.num_compiles_retrieved[3]);
+  draw_statistic("Max compile latency", "%d / %d / %d / %d ms",
+                 this_frame.max_compile_latency_ms[0], this_frame.max_compile_latency_ms[1],
+                 this_frame.max_compile_latency_ms[2], this_frame.max_compile_latency_ms[3]);
+  draw_statistic("Ubershader pipelines", "%d", num_ubershader_pipelines);
+  draw_statistic("Ubershader draws", "%d", this_frame.num_ubershader_draws);
+  draw_statistic("Predicted pipelines", "%d", num_predicted_pipelines);
 
   ImGui::Columns(1);
 
@@ -19,6 +19,14 @@ struct Statistics
 
   int num_vertex_loaders;
 
+  // Indexed by AsyncShaderCompiler::Priority.
+  std::array<int, 4> num_pending_compiles;
+
+  // Specialized pipelines currently substituted by ubershaders, and pipelines compiled ahead of
+  // use by the predictive compiler.
+  int num_ubershader_pipelines;
+  int num_predicted_pipelines;
+
   std::array<float, 6> proj;
   std::array<float, 16> gproj;
   std::array<float, 16> g2proj;
@@ -46,6 +54,9 @@ struct Statistics
     int bytes_index_streamed;
     int bytes_uniform_streamed;
 
+    int num_stream_buffer_stalls;
+    int stream_buffer_stall_time_us;
+
     int num_triangles_clipped;
     int num_triangles_in;
     int num_triangles_rejected;
@@ -59,6 +70,16 @@ struct Statistics
 
     int num_efb_peeks;
     int num_efb_pokes;
+    int num_efb_peek_syncs;
+    int num_efb_tiles_prefetched;
+
+    int num_bbox_syncs;
+    int bbox_stall_time_us;
+    int num_bbox_readbacks;
+
+    std::array<int, 4> num_compiles_retrieved;
+    std::array<int, 4> max_compile_latency_ms;
+    int num_ubershader_draws;
   };
   ThisFrame this_frame;
   void ResetFrame();
@@ -0,0 +1,254 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/TimelineProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/RenderBase.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace TimelineProfiler
+{
+namespace
+{
+struct CPUEvent
+{
+  const char* name;
+  u64 start_time;
+  u64 end_time;
+  u32 thread_id;
+};
+
+struct GPUEvent
+{
+  const char* name;
+  u32 start_timestamp;
+  u32 end_timestamp;
+};
+
+struct FrameMarker
+{
+  int frame_number;
+  u64 time;
+};
+
+// Process IDs in the trace, which are shown as separate groups of tracks.
+constexpr int CPU_PROCESS_ID = 1;
+constexpr int GPU_PROCESS_ID = 2;
+
+std::atomic<bool> s_capturing{false};
+std::atomic<u32> s_next_thread_id{1};
+
+// Protects the event lists, which scopes on any thread add to.
+std::mutex s_mutex;
+std::vector<CPUEvent> s_cpu_events;
+std::vector<GPUEvent> s_gpu_events;
+std::vector<FrameMarker> s_frame_markers;
+u64 s_capture_start_time = 0;
+int s_capture_first_frame = 0;
+u32 s_gpu_thread_id = 0;
+
+u64 GetTime()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Small sequential IDs make the trace easier to read than the OS thread IDs.
+u32 GetThreadID()
+{
+  thread_local u32 thread_id = s_next_thread_id++;
+  return thread_id;
+}
+
+s64 GetTraceTime(u64 time)
+{
+  return static_cast<s64>(time - s_capture_start_time);
+}
+
+std::string GetTracePath(int first_frame, int last_frame)
+{
+  return StringFromFormat("%stimeline_%s_%d-%d.json", File::GetUserPath(D_DUMP_IDX).c_str(),
+                          SConfig::GetInstance().GetGameID().c_str(), first_frame, last_frame);
+}
+
+void StartCapture(int frame_number)
+{
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_cpu_events.clear();
+  s_gpu_events.clear();
+  s_frame_markers.clear();
+  s_capture_start_time = GetTime();
+  s_capture_first_frame = frame_number;
+  s_gpu_thread_id = GetThreadID();
+  s_frame_markers.push_back({frame_number, s_capture_start_time});
+  s_capturing = true;
+
+  INFO_LOG(VIDEO, "Capturing timeline from frame %d", frame_number);
+}
+
+void WriteTrace(const std::string& path, const std::vector<CPUEvent>& cpu_events,
+                const std::vector<CPUEvent>& gpu_events)
+{
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  json += StringFromFormat(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Dolphin\"}},\n",
+      CPU_PROCESS_ID);
+  json += StringFromFormat(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Host GPU\"}},\n",
+      GPU_PROCESS_ID);
+  json += StringFromFormat("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                           "\"args\":{\"name\":\"GPU thread\"}},\n",
+                           CPU_PROCESS_ID, s_gpu_thread_id);
+
+  for (const FrameMarker& marker : s_frame_markers)
+  {
+    json += StringFromFormat("{\"name\":\"Frame %d\",\"ph\":\"i\",\"s\":\"g\",\"pid\":%d,"
+                             "\"tid\":%u,\"ts\":%" PRId64 "},\n",
+                             marker.frame_number, CPU_PROCESS_ID, s_gpu_thread_id,
+                             GetTraceTime(marker.time));
+  }
+
+  const auto write_events = [&json](const std::vector<CPUEvent>& events, int process_id) {
+    for (const CPUEvent& event : events)
+    {
+      json += StringFromFormat("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                               "\"ts\":%" PRId64 ",\"dur\":%" PRIu64 "},\n",
+                               event.name, process_id, event.thread_id,
+                               GetTraceTime(event.start_time), event.end_time - event.start_time);
+    }
+  };
+  write_events(cpu_events, CPU_PROCESS_ID);
+  write_events(gpu_events, GPU_PROCESS_ID);
+
+  // Trailing commas are not valid JSON.
+  json.erase(json.size() - 2);
+  json += "\n]}\n";
+
+  File::CreateFullPath(path);
+  File::IOFile file(path, "wb");
+  if (!file.WriteBytes(json.data(), json.size()))
+  {
+    ERROR_LOG(VIDEO, "Failed to write timeline to %s", path.c_str());
+    return;
+  }
+
+  OSD::AddMessage(StringFromFormat("Timeline saved to %s", path.c_str()));
+}
+
+void FinishCapture(int frame_number)
+{
+  s_capturing = false;
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+
+  // GPU timestamps are only read back now, so that the capture doesn't stall the GPU. They are
+  // written out the same way as the CPU events, on a single track as the GPU executes in order.
+  std::vector<CPUEvent> gpu_events;
+  gpu_events.reserve(s_gpu_events.size());
+  for (const GPUEvent& event : s_gpu_events)
+  {
+    const u64 start_time = g_renderer->ReadGPUTimestamp(event.start_timestamp);
+    const u64 end_time = g_renderer->ReadGPUTimestamp(event.end_timestamp);
+    if (end_time >= start_time)
+      gpu_events.push_back({event.name, start_time, end_time, 1});
+  }
+
+  WriteTrace(GetTracePath(s_capture_first_frame, frame_number - 1), s_cpu_events, gpu_events);
+  s_cpu_events.clear();
+  s_gpu_events.clear();
+  s_frame_markers.clear();
+}
+}  // Anonymous namespace
+
+bool IsCapturing()
+{
+  return s_capturing.load(std::memory_order_relaxed);
+}
+
+void OnFrameBegin(int frame_number)
+{
+  const int first_frame = g_ActiveConfig.iTimelineCaptureFirstFrame;
+  const int num_frames = g_ActiveConfig.iTimelineCaptureFrames;
+  if (!s_capturing)
+  {
+    if (num_frames > 0 && frame_number == first_frame)
+      StartCapture(frame_number);
+    return;
+  }
+
+  if (num_frames <= 0 || frame_number >= s_capture_first_frame + num_frames)
+  {
+    FinishCapture(frame_number);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_frame_markers.push_back({frame_number, GetTime()});
+}
+
+void Shutdown()
+{
+  s_capturing = false;
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  for (const GPUEvent& event : s_gpu_events)
+  {
+    g_renderer->ReadGPUTimestamp(event.start_timestamp);
+    g_renderer->ReadGPUTimestamp(event.end_timestamp);
+  }
+  s_cpu_events.clear();
+  s_gpu_events.clear();
+  s_frame_markers.clear();
+}
+
+Scope::Scope(const char* name, bool gpu_work) : m_name(name)
+{
+  if (!IsCapturing())
+    return;
+
+  m_active = true;
+  m_start_time = GetTime();
+  if (gpu_work)
+    m_gpu_start_timestamp = g_renderer->WriteGPUTimestamp();
+}
+
+Scope::~Scope()
+{
+  if (!m_active)
+    return;
+
+  const u64 end_time = GetTime();
+  const u32 gpu_end_timestamp = m_gpu_start_timestamp ? g_renderer->WriteGPUTimestamp() : 0;
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (!IsCapturing())
+  {
+    // The capture finished while this scope was open, so the timestamps just need releasing.
+    if (m_gpu_start_timestamp)
+    {
+      g_renderer->ReadGPUTimestamp(m_gpu_start_timestamp);
+      g_renderer->ReadGPUTimestamp(gpu_end_timestamp);
+    }
+    return;
+  }
+
+  s_cpu_events.push_back({m_name, m_start_time, end_time, GetThreadID()});
+  if (m_gpu_start_timestamp)
+    s_gpu_events.push_back({m_name, m_gpu_start_timestamp, gpu_end_timestamp});
+}
+}  // namespace TimelineProfiler
@@ -0,0 +1,42 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Records where the GPU thread and the host GPU spend their time over a range of frames, and
+// writes it to the Dump directory in the Chrome trace event format, which can be viewed with
+// chrome://tracing or Perfetto.
+namespace TimelineProfiler
+{
+// Returns true if scopes are currently being recorded. Called from any thread.
+bool IsCapturing();
+
+// Starts or finishes a capture, depending on the configured frame range. Called by the renderer
+// on the GPU thread when it starts a new frame, counting from zero.
+void OnFrameBegin(int frame_number);
+
+// Discards a capture which is in progress, e.g. when the renderer is shut down.
+void Shutdown();
+
+// Records the time taken between construction and destruction. Scopes which submit work to the
+// host GPU also record backend timestamps, if the backend supports them. Those must only be used
+// on the GPU thread.
+class Scope
+{
+public:
+  explicit Scope(const char* name, bool gpu_work = false);
+  ~Scope();
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const char* m_name;
+  u64 m_start_time = 0;
+  u32 m_gpu_start_timestamp = 0;
+  bool m_active = false;
+};
+}  // namespace TimelineProfiler
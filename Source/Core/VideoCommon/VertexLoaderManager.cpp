@@ -24,6 +24,7 @@
 #include "VideoCommon/NativeVertexFormat.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/TimelineProfiler.h"
 #include "VideoCommon/VertexLoaderBase.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
@@ -254,6 +255,7 @@ int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bo
   if (!count)
     return 0;
 
+  TimelineProfiler::Scope timeline_scope("Vertex load");
   VertexLoaderBase* loader = RefreshLoader(vtx_attr_group, is_preprocess);
 
   int size = count * loader->m_VertexSize;
@@ -4,13 +4,16 @@
 
 #include "VideoCommon/VertexManagerBase.h"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <memory>
 
 #include "Common/BitSet.h"
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "Common/MathUtil.h"
 
@@ -30,6 +33,7 @@
 #include "VideoCommon/SamplerCommon.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureCacheBase.h"
+#include "VideoCommon/TimelineProfiler.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/VideoBackendBase.h"
@@ -147,11 +151,25 @@ DataReader VertexManagerBase::PrepareForAdditionalData(int primitive, u32 count,
       m_end_buffer_pointer = m_base_buffer_pointer + m_cpu_vertex_buffer.size();
       IndexGenerator::Start(m_cpu_index_buffer.data());
     }
+    else if (g_ActiveConfig.bCPUCull)
+    {
+      // Mapped GPU memory may be write-only, or very slow to read, so build the batch in CPU
+      // memory and only copy the primitives which survive culling to the GPU when flushing.
+      if (m_cull_vertex_buffer.empty())
+      {
+        m_cull_vertex_buffer.resize(MAXVBUFFERSIZE);
+        m_cull_index_buffer.resize(MAXIBUFFERSIZE);
+      }
+      m_cur_buffer_pointer = m_base_buffer_pointer = m_cull_vertex_buffer.data();
+      m_end_buffer_pointer = m_base_buffer_pointer + m_cull_vertex_buffer.size();
+      IndexGenerator::Start(m_cull_index_buffer.data());
+    }
     else
     {
       ResetBuffer(stride);
     }
 
+    m_cull_on_cpu = !cullall && g_ActiveConfig.bCPUCull;
     m_is_flushed = false;
   }
 
@@ -337,6 +355,7 @@ void VertexManagerBase::Flush()
     return;
 
   m_is_flushed = true;
+  TimelineProfiler::Scope timeline_scope("Flush", true);
 
 #if defined(_DEBUG) || defined(DEBUGFAST)
   PRIM_LOG("frame%d:\n texgen=%u, numchan=%u, dualtex=%u, ztex=%u, cole=%u, alpe=%u, ze=%u",
@@ -411,43 +430,65 @@ void VertexManagerBase::Flush()
 
   if (!m_cull_all)
   {
+    const NativeVertexFormat* vertex_format = VertexLoaderManager::GetCurrentVertexFormat();
+    const u32 vertex_stride = vertex_format->GetVertexStride();
+    if (m_cull_on_cpu)
+    {
+      // Drop triangles which cannot produce any pixels before they are uploaded.
+      CullPrimitives(vertex_format);
+
+      // Copy what is left of the batch from CPU memory to the GPU buffers.
+      const u32 num_vertices = IndexGenerator::GetNumVerts();
+      const u32 num_culled_indices = IndexGenerator::GetIndexLen();
+      ResetBuffer(vertex_stride);
+      std::memcpy(m_cur_buffer_pointer, m_cull_vertex_buffer.data(), num_vertices * vertex_stride);
+      m_cur_buffer_pointer += num_vertices * vertex_stride;
+      IndexGenerator::AddExternalIndices(m_cull_index_buffer.data(), num_culled_indices,
+                                         num_vertices);
+    }
+
     // Now the vertices can be flushed to the GPU. Everything following the CommitBuffer() call
     // must be careful to not upload any utility vertices, as the binding will be lost otherwise.
     const u32 num_indices = IndexGenerator::GetIndexLen();
     u32 base_vertex, base_index;
-    CommitBuffer(IndexGenerator::GetNumVerts(),
-                 VertexLoaderManager::GetCurrentVertexFormat()->GetVertexStride(), num_indices,
-                 &base_vertex, &base_index);
-
-    // Texture loading can cause palettes to be applied (-> uniforms -> draws).
-    // Palette application does not use vertices, only a full-screen quad, so this is okay.
-    // Same with GPU texture decoding, which uses compute shaders.
-    LoadTextures();
-
-    // Now we can upload uniforms, as nothing else will override them.
-    GeometryShaderManager::SetConstants();
-    PixelShaderManager::SetConstants();
-    UploadUniforms();
-
-    // Update the pipeline, or compile one if needed.
-    UpdatePipelineConfig();
-    UpdatePipelineObject();
-    if (m_current_pipeline_object)
+    CommitBuffer(IndexGenerator::GetNumVerts(), vertex_stride, num_indices, &base_vertex,
+                 &base_index);
+
+    // Nothing is left to draw if every primitive was culled on the CPU.
+    if (num_indices > 0)
     {
-      g_renderer->SetPipeline(m_current_pipeline_object);
-      if (PerfQueryBase::ShouldEmulate())
-        g_perf_query->EnableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
+      // Texture loading can cause palettes to be applied (-> uniforms -> draws).
+      // Palette application does not use vertices, only a full-screen quad, so this is okay.
+      // Same with GPU texture decoding, which uses compute shaders.
+      LoadTextures();
+
+      // Now we can upload uniforms, as nothing else will override them.
+      GeometryShaderManager::SetConstants();
+      PixelShaderManager::SetConstants();
+      UploadUniforms();
+
+      // Update the pipeline, or compile one if needed.
+      UpdatePipelineConfig();
+      UpdatePipelineObject();
+      if (m_current_pipeline_object)
+      {
+        g_renderer->SetPipeline(m_current_pipeline_object);
+        if (PerfQueryBase::ShouldEmulate())
+          g_perf_query->EnableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
 
-      DrawCurrentBatch(base_index, num_indices, base_vertex);
-      INCSTAT(g_stats.this_frame.num_draw_calls);
+        DrawCurrentBatch(base_index, num_indices, base_vertex);
+        INCSTAT(g_stats.this_frame.num_draw_calls);
+        if (m_using_ubershader_fallback)
+          g_shader_cache->RecordUberShaderFallbackDraw();
 
-      if (PerfQueryBase::ShouldEmulate())
-        g_perf_query->DisableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
+        if (PerfQueryBase::ShouldEmulate())
+          g_perf_query->DisableQuery(bpmem.zcontrol.early_ztest ? PQG_ZCOMP_ZCOMPLOC : PQG_ZCOMP);
 
-      OnDraw();
+        OnDraw();
 
-      // The EFB cache is now potentially stale.
-      g_framebuffer_manager->FlagPeekCacheAsOutOfDate();
+        // The EFB cache is now potentially stale.
+        g_framebuffer_manager->FlagPeekCacheAsOutOfDate();
+      }
     }
   }
 
@@ -538,6 +579,189 @@ void VertexManagerBase::CalculateZSlope(NativeVertexFormat* format)
   m_zslope.dirty = true;
 }
 
+namespace
+{
+enum ClipOutcode : u8
+{
+  CLIP_POS_X = 1 << 0,
+  CLIP_NEG_X = 1 << 1,
+  CLIP_POS_Y = 1 << 2,
+  CLIP_NEG_Y = 1 << 3,
+};
+
+void TransformPositions(const float* matrix, const u8* vertices, u32 stride, u32 components,
+                        u32 count, float* out_positions, u8* out_outcodes)
+{
+#ifdef _M_X86
+  // out = col0 * x + col1 * y + col2 * z + col3, for all four components at once.
+  const __m128 col0 = _mm_setr_ps(matrix[0], matrix[4], matrix[8], matrix[12]);
+  const __m128 col1 = _mm_setr_ps(matrix[1], matrix[5], matrix[9], matrix[13]);
+  const __m128 col2 = _mm_setr_ps(matrix[2], matrix[6], matrix[10], matrix[14]);
+  const __m128 col3 = _mm_setr_ps(matrix[3], matrix[7], matrix[11], matrix[15]);
+#endif
+
+  for (u32 i = 0; i < count; i++, vertices += stride, out_positions += 4)
+  {
+    float pos[3] = {};
+    std::memcpy(pos, vertices, sizeof(float) * components);
+
+#ifdef _M_X86
+    __m128 out = _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(pos[0])), col3);
+    out = _mm_add_ps(out, _mm_mul_ps(col1, _mm_set1_ps(pos[1])));
+    out = _mm_add_ps(out, _mm_mul_ps(col2, _mm_set1_ps(pos[2])));
+    _mm_storeu_ps(out_positions, out);
+#else
+    for (int row = 0; row < 4; row++)
+    {
+      out_positions[row] = matrix[row * 4 + 0] * pos[0] + matrix[row * 4 + 1] * pos[1] +
+                           matrix[row * 4 + 2] * pos[2] + matrix[row * 4 + 3];
+    }
+#endif
+
+    const float x = out_positions[0];
+    const float y = out_positions[1];
+    const float w = out_positions[3];
+    out_outcodes[i] = (x > w ? CLIP_POS_X : 0) | (x < -w ? CLIP_NEG_X : 0) |
+                      (y > w ? CLIP_POS_Y : 0) | (y < -w ? CLIP_NEG_Y : 0);
+  }
+}
+}  // Anonymous namespace
+
+void VertexManagerBase::CullPrimitives(const NativeVertexFormat* format)
+{
+  if (m_current_primitive_type != PrimitiveType::Triangles &&
+      m_current_primitive_type != PrimitiveType::TriangleStrip)
+  {
+    return;
+  }
+
+  // Wireframe draws the edges of degenerate triangles, and stereoscopy shifts the vertices of
+  // each eye after the transform, so neither can be predicted here.
+  if (g_ActiveConfig.bWireFrame || g_ActiveConfig.stereo_mode != StereoMode::Off)
+    return;
+
+  const PortableVertexDeclaration& vert_decl = format->GetVertexDeclaration();
+  const u32 num_vertices = IndexGenerator::GetNumVerts();
+  const u32 num_indices = IndexGenerator::GetIndexLen();
+  if (num_indices == 0 || !vert_decl.position.enable || vert_decl.position.type != VAR_FLOAT)
+    return;
+
+  // Transform each vertex once, as most are shared by several triangles. Consecutive vertices
+  // usually use the same position matrix, so the combined matrix is only rebuilt when it changes.
+  m_cull_positions.resize(num_vertices * 4);
+  m_cull_outcodes.resize(num_vertices);
+  const u8* vertices = m_cull_vertex_buffer.data();
+  const u32 stride = vert_decl.stride;
+  const u32 global_mtx_idx = g_main_cp_state.matrix_index_a.PosNormalMtxIdx;
+  alignas(16) float matrix[16];
+  for (u32 first = 0; first < num_vertices;)
+  {
+    const u32 mtx_idx =
+        vert_decl.posmtx.enable ? vertices[first * stride + vert_decl.posmtx.offset] :
+                                  global_mtx_idx;
+    u32 last = first + 1;
+    if (vert_decl.posmtx.enable)
+    {
+      while (last < num_vertices && vertices[last * stride + vert_decl.posmtx.offset] == mtx_idx)
+        last++;
+    }
+    else
+    {
+      last = num_vertices;
+    }
+
+    VertexShaderManager::GetClipSpaceMatrix(matrix, mtx_idx);
+    TransformPositions(matrix, vertices + first * stride + vert_decl.position.offset, stride,
+                       vert_decl.position.components, last - first,
+                       &m_cull_positions[first * 4], &m_cull_outcodes[first]);
+    first = last;
+  }
+
+  // Facing is only tested for the usual viewport orientation, as a mirrored viewport flips the
+  // winding of everything drawn by the backend.
+  const bool test_facing = xfmem.viewport.wd > 0 && xfmem.viewport.ht < 0;
+  // As in the software renderer, back-face culling removes triangles with a positive normal.
+  const bool cull_positive = (bpmem.genMode.cullmode & GenMode::CULL_BACK) != 0;
+  const bool cull_negative = (bpmem.genMode.cullmode & GenMode::CULL_FRONT) != 0;
+  int num_rejected = 0;
+  int num_culled = 0;
+  const auto is_visible = [&](u32 i0, u32 i1, u32 i2) {
+    if (m_cull_outcodes[i0] & m_cull_outcodes[i1] & m_cull_outcodes[i2])
+    {
+      num_rejected++;
+      return false;
+    }
+
+    const float* v0 = &m_cull_positions[i0 * 4];
+    const float* v1 = &m_cull_positions[i1 * 4];
+    const float* v2 = &m_cull_positions[i2 * 4];
+
+    // Triangles crossing the near plane are clipped by the GPU, and keep their facing.
+    if (v0[3] <= 0.0f || v1[3] <= 0.0f || v2[3] <= 0.0f)
+      return true;
+
+    const float normal_z = (v0[0] * v2[3] - v2[0] * v0[3]) * v1[1] +
+                           (v2[0] * v0[1] - v0[0] * v2[1]) * v1[3] +
+                           (v2[1] * v0[3] - v0[1] * v2[3]) * v1[0];
+    if (normal_z == 0.0f ||
+        (test_facing && ((cull_positive && normal_z > 0.0f) || (cull_negative && normal_z < 0.0f))))
+    {
+      num_culled++;
+      return false;
+    }
+
+    return true;
+  };
+
+  // Compact the index buffer in place. With primitive restart, every primitive is a strip
+  // terminated by a restart index, which is kept unless all of its triangles are culled.
+  u16* const indices = m_cull_index_buffer.data();
+  u32 out_pos = 0;
+  if (m_current_primitive_type == PrimitiveType::TriangleStrip)
+  {
+    u32 strip_start = 0;
+    for (u32 i = 0; i <= num_indices; i++)
+    {
+      if (i < num_indices && indices[i] != UINT16_MAX)
+        continue;
+
+      // Every other triangle of a strip has its winding reversed.
+      const u32 strip_length = i - strip_start;
+      bool visible = false;
+      for (u32 j = 0; j + 2 < strip_length && !visible; j++)
+      {
+        const u16* tri = &indices[strip_start + j];
+        visible = (j & 1) ? is_visible(tri[1], tri[0], tri[2]) : is_visible(tri[0], tri[1], tri[2]);
+      }
+
+      // Copy the strip along with its restart index, if it has one.
+      const u32 copy_length = std::min(strip_length + 1, num_indices - strip_start);
+      if (visible)
+      {
+        std::memmove(&indices[out_pos], &indices[strip_start], copy_length * sizeof(u16));
+        out_pos += copy_length;
+      }
+      strip_start = i + 1;
+    }
+  }
+  else
+  {
+    for (u32 i = 0; i + 2 < num_indices; i += 3)
+    {
+      if (!is_visible(indices[i], indices[i + 1], indices[i + 2]))
+        continue;
+
+      indices[out_pos++] = indices[i];
+      indices[out_pos++] = indices[i + 1];
+      indices[out_pos++] = indices[i + 2];
+    }
+  }
+
+  IndexGenerator::SetIndexLen(out_pos);
+  ADDSTAT(g_stats.this_frame.num_triangles_rejected, num_rejected);
+  ADDSTAT(g_stats.this_frame.num_triangles_culled, num_culled);
+}
+
 void VertexManagerBase::UpdatePipelineConfig()
 {
   NativeVertexFormat* vertex_format = VertexLoaderManager::GetCurrentVertexFormat();
@@ -621,8 +845,10 @@ void VertexManagerBase::UpdatePipelineObject()
   if (!m_pipeline_config_changed)
     return;
 
+  TimelineProfiler::Scope timeline_scope("Shader lookup");
   m_current_pipeline_object = nullptr;
   m_pipeline_config_changed = false;
+  m_using_ubershader_fallback = false;
 
   switch (g_ActiveConfig.iShaderCompilationMode)
   {
@@ -658,6 +884,8 @@ void VertexManagerBase::UpdatePipelineObject()
       // Specialized shaders not ready, use the ubershaders.
       m_current_pipeline_object =
           g_shader_cache->GetUberPipelineForUid(m_current_uber_pipeline_config);
+      g_shader_cache->BeginUberShaderFallback(m_current_pipeline_config);
+      m_using_ubershader_fallback = true;
     }
     else
     {
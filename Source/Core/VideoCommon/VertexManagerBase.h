@@ -154,6 +154,7 @@ protected:
   const AbstractPipeline* m_current_pipeline_object = nullptr;
   PrimitiveType m_current_primitive_type = PrimitiveType::Points;
   bool m_pipeline_config_changed = true;
+  bool m_using_ubershader_fallback = false;
   bool m_rasterization_state_changed = true;
   bool m_depth_state_changed = true;
   bool m_blending_state_changed = true;
@@ -166,7 +167,21 @@ private:
   void UpdatePipelineConfig();
   void UpdatePipelineObject();
 
+  // Removes triangles which cannot produce any pixels from the current batch.
+  void CullPrimitives(const NativeVertexFormat* format);
+
   bool m_is_flushed = true;
+
+  // Batches which are culled on the CPU are built in these buffers, and copied to the GPU buffers
+  // once culled. They are only allocated when CPU culling is used.
+  std::vector<u8> m_cull_vertex_buffer;
+  std::vector<u16> m_cull_index_buffer;
+  bool m_cull_on_cpu = false;
+
+  // Clip space positions and clip plane outcodes of the current batch, used for CPU culling.
+  std::vector<float> m_cull_positions;
+  std::vector<u8> m_cull_outcodes;
+
   size_t m_flush_count_4_3 = 0;
   size_t m_flush_count_anamorphic = 0;
 
@@ -669,6 +669,30 @@ void VertexShaderManager::TransformToClipSpace(const float* data, float* out, u3
       t[0] * proj_matrix[12] + t[1] * proj_matrix[13] + t[2] * proj_matrix[14] + proj_matrix[15];
 }
 
+void VertexShaderManager::GetClipSpaceMatrix(float* out, u32 MtxIdx)
+{
+  const float* world_matrix = &xfmem.posMatrices[(MtxIdx & 0x3f) * 4];
+
+  // Use the projection that is uploaded to the vertex shader, which includes the viewport
+  // correction and any free look transformation, so that the result matches what the GPU draws.
+  // Make sure VertexShaderManager::SetConstants() has been called first.
+  float proj_matrix[16];
+  static_assert(sizeof(proj_matrix) == sizeof(constants.projection));
+  std::memcpy(proj_matrix, constants.projection.data(), sizeof(proj_matrix));
+
+  for (int row = 0; row < 4; ++row)
+  {
+    for (int col = 0; col < 4; ++col)
+    {
+      // The position matrix is 3x4, with an implicit (0, 0, 0, 1) fourth row.
+      float value = col == 3 ? proj_matrix[row * 4 + 3] : 0.0f;
+      for (int i = 0; i < 3; ++i)
+        value += proj_matrix[row * 4 + i] * world_matrix[i * 4 + col];
+      out[row * 4 + col] = value;
+    }
+  }
+}
+
 void VertexShaderManager::DoState(PointerWrap& p)
 {
   p.DoArray(g_fProjectionMatrix);
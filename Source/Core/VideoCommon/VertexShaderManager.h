@@ -43,6 +43,11 @@ public:
   //       (i.e. VertexShaderManager::SetConstants needs to be called before using this!)
   static void TransformToClipSpace(const float* data, float* out, u32 mtxIdx);
 
+  // out: 16 floats, row-major, which will be initialized with the product of the projection
+  //      matrix and the given position matrix, for transforming many vertices to clip space.
+  // NOTE: The same restrictions as TransformToClipSpace apply.
+  static void GetClipSpaceMatrix(float* out, u32 mtxIdx);
+
   static VertexShaderConstants constants;
   static bool dirty;
 };
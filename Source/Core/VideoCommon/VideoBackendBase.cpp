@@ -14,6 +14,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
 #include "Common/Logging/Log.h"
+#include "Common/Timer.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 
@@ -29,6 +30,7 @@
 
 #include "VideoCommon/AsyncRequests.h"
 #include "VideoCommon/BPStructs.h"
+#include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/Fifo.h"
@@ -166,11 +168,31 @@ u16 VideoBackendBase::Video_GetBoundingBox(int index)
     return 0;
   }
 
+  if (g_ActiveConfig.bBBoxAsyncReadback)
+  {
+    // Return the values from the last readback, and request new ones for the next read without
+    // waiting for the GPU thread. Games read all four registers at once, so only one readback
+    // is requested at a time. In single core mode the request is handled immediately.
+    if (!BoundingBox::readback_pending.exchange(true))
+    {
+      AsyncRequests::Event e;
+      e.time = 0;
+      e.type = AsyncRequests::Event::BBOX_READBACK;
+
+      // If requests are disabled, nothing will handle this one, so allow another to be made.
+      if (!AsyncRequests::GetInstance()->PushEvent(e, false))
+        BoundingBox::readback_pending = false;
+    }
+    return BoundingBox::readback_values[index];
+  }
+
+  // The time is used to measure how long the CPU thread is stalled for.
+  const u64 start_time = Common::Timer::GetTimeUs();
   Fifo::SyncGPU(Fifo::SyncGPUReason::BBox);
 
   AsyncRequests::Event e;
   u16 result;
-  e.time = 0;
+  e.time = start_time;
   e.type = AsyncRequests::Event::BBOX_READ;
   e.bbox.index = index;
   e.bbox.data = &result;
@@ -107,6 +107,16 @@ struct VideoConfig final
   std::string sDumpFormat;
   std::string sDumpPath;
   bool bInternalResolutionFrameDumps;
+  // Number of frames which can wait to be encoded before frame dumping slows down emulation.
+  int iFrameDumpQueueSize;
+  // Writes a checksum of every presented frame to a log, for comparing the output of two runs.
+  // Frames are read back at internal resolution while this is enabled, so that the checksums do
+  // not depend on the window size.
+  bool bLogFrameChecksums;
+  // Range of frames to record a timeline of GPU thread and GPU work for. Disabled when the number
+  // of frames is zero.
+  int iTimelineCaptureFirstFrame;
+  int iTimelineCaptureFrames;
   bool bFreeLook;
   bool bBorderlessFullscreen;
   bool bEnableGPUTextureDecoding;
@@ -115,8 +125,14 @@ struct VideoConfig final
   // Hacks
   bool bEFBAccessEnable;
   bool bEFBAccessDeferInvalidation;
+  // Reads the EFB tiles accessed in the previous frame along with a missing tile, so that a burst
+  // of CPU EFB reads only has to wait for the GPU once.
+  bool bEFBAccessPrefetchTiles;
   bool bPerfQueriesEnable;
   bool bBBoxEnable;
+  // Returns the last bounding box read back instead of waiting for the GPU, and requests a new
+  // readback for the next read.
+  bool bBBoxAsyncReadback;
   bool bForceProgressive;
 
   bool bEFBEmulateFormatChanges;
@@ -166,6 +182,10 @@ struct VideoConfig final
   // Currently only supported with Vulkan.
   int iCommandBufferExecuteInterval;
 
+  // Record draws within a render pass to secondary command buffers on multiple threads.
+  // Currently only supported with Vulkan.
+  bool bParallelCommandRecording;
+
   // Shader compilation settings.
   bool bWaitForShadersBeforeStarting;
   ShaderCompilationMode iShaderCompilationMode;
@@ -176,6 +196,14 @@ struct VideoConfig final
   int iShaderCompilerThreads;
   int iShaderPrecompilerThreads;
 
+  // Queue specialized pipelines which usually follow the current one before they are needed,
+  // based on the transitions recorded in previous sessions.
+  bool bPredictPipelines;
+
+  // Transform positions on the CPU to drop triangles which cannot produce any pixels before
+  // they are sent to the GPU. Only worthwhile when the GPU is the bottleneck.
+  bool bCPUCull;
+
   // Static config per API
   // TODO: Move this out of VideoConfig
   struct
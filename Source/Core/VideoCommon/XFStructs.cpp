@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/Swap.h"
@@ -23,6 +25,18 @@ static void XFMemWritten(u32 transferSize, u32 baseAddress)
   VertexShaderManager::InvalidateXFRange(baseAddress, baseAddress + transferSize);
 }
 
+// Returns true if any of the count registers starting at address would be changed by the
+// values at data_index in src. Unchanged state does not need to end the current batch.
+static bool XFRegsChanged(u32 address, int count, u32 data_index, const DataReader& src)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (((u32*)&xfmem)[address + i] != src.Peek<u32>((data_index + i) * sizeof(u32)))
+      return true;
+  }
+  return false;
+}
+
 static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
 {
   u32 address = baseAddress;
@@ -111,12 +125,15 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETVIEWPORT + 3:
     case XFMEM_SETVIEWPORT + 4:
     case XFMEM_SETVIEWPORT + 5:
-      g_vertex_manager->Flush();
-      VertexShaderManager::SetViewportChanged();
-      PixelShaderManager::SetViewportChanged();
-      GeometryShaderManager::SetViewportChanged();
-
       nextAddress = XFMEM_SETVIEWPORT + 6;
+      if (XFRegsChanged(address, std::min<int>(nextAddress - address, transferSize), dataIndex,
+                        src))
+      {
+        g_vertex_manager->Flush();
+        VertexShaderManager::SetViewportChanged();
+        PixelShaderManager::SetViewportChanged();
+        GeometryShaderManager::SetViewportChanged();
+      }
       break;
 
     case XFMEM_SETPROJECTION:
@@ -126,11 +143,14 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETPROJECTION + 4:
     case XFMEM_SETPROJECTION + 5:
     case XFMEM_SETPROJECTION + 6:
-      g_vertex_manager->Flush();
-      VertexShaderManager::SetProjectionChanged();
-      GeometryShaderManager::SetProjectionChanged();
-
       nextAddress = XFMEM_SETPROJECTION + 7;
+      if (XFRegsChanged(address, std::min<int>(nextAddress - address, transferSize), dataIndex,
+                        src))
+      {
+        g_vertex_manager->Flush();
+        VertexShaderManager::SetProjectionChanged();
+        GeometryShaderManager::SetProjectionChanged();
+      }
       break;
 
     case XFMEM_SETNUMTEXGENS:  // GXSetNumTexGens
@@ -146,10 +166,13 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETTEXMTXINFO + 5:
     case XFMEM_SETTEXMTXINFO + 6:
     case XFMEM_SETTEXMTXINFO + 7:
-      g_vertex_manager->Flush();
-      VertexShaderManager::SetTexMatrixInfoChanged(address - XFMEM_SETTEXMTXINFO);
-
       nextAddress = XFMEM_SETTEXMTXINFO + 8;
+      if (XFRegsChanged(address, std::min<int>(nextAddress - address, transferSize), dataIndex,
+                        src))
+      {
+        g_vertex_manager->Flush();
+        VertexShaderManager::SetTexMatrixInfoChanged(address - XFMEM_SETTEXMTXINFO);
+      }
       break;
 
     case XFMEM_SETPOSMTXINFO:
@@ -160,10 +183,13 @@ static void XFRegWritten(int transferSize, u32 baseAddress, DataReader src)
     case XFMEM_SETPOSMTXINFO + 5:
     case XFMEM_SETPOSMTXINFO + 6:
     case XFMEM_SETPOSMTXINFO + 7:
-      g_vertex_manager->Flush();
-      VertexShaderManager::SetTexMatrixInfoChanged(address - XFMEM_SETPOSMTXINFO);
-
       nextAddress = XFMEM_SETPOSMTXINFO + 8;
+      if (XFRegsChanged(address, std::min<int>(nextAddress - address, transferSize), dataIndex,
+                        src))
+      {
+        g_vertex_manager->Flush();
+        VertexShaderManager::SetTexMatrixInfoChanged(address - XFMEM_SETPOSMTXINFO);
+      }
       break;
 
     // --------------
@@ -235,7 +261,9 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, DataReader src)
       transferSize = 0;
     }
 
-    XFMemWritten(xfMemTransferSize, xfMemBase);
+    // Games often reload matrices which have not changed, don't split the batch for these.
+    if (XFRegsChanged(xfMemBase, xfMemTransferSize, 0, src))
+      XFMemWritten(xfMemTransferSize, xfMemBase);
     for (u32 i = 0; i < xfMemTransferSize; i++)
     {
       ((u32*)&xfmem)[xfMemBase + i] = src.Read<u32>();
@@ -0,0 +1,54 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/Crypto/SHA1.h"
+
+static const Common::SHA1::Digest EMPTY_DIGEST = {{0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b,
+                                                   0x0d, 0x32, 0x55, 0xbf, 0xef, 0x95, 0x60,
+                                                   0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09}};
+static const Common::SHA1::Digest ABC_DIGEST = {{0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81,
+                                                 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50,
+                                                 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d}};
+static const Common::SHA1::Digest TWO_BLOCK_DIGEST = {{0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2,
+                                                       0x6e, 0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51,
+                                                       0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1}};
+static const Common::SHA1::Digest MILLION_A_DIGEST = {{0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda,
+                                                       0xa4, 0xf6, 0x1e, 0xeb, 0x2b, 0xdb, 0xad,
+                                                       0x27, 0x31, 0x65, 0x34, 0x01, 0x6f}};
+
+TEST(SHA1, KnownVectors)
+{
+  EXPECT_EQ(Common::SHA1::CalculateDigest(std::string_view("")), EMPTY_DIGEST);
+  EXPECT_EQ(Common::SHA1::CalculateDigest(std::string_view("abc")), ABC_DIGEST);
+  EXPECT_EQ(Common::SHA1::CalculateDigest(
+                std::string_view("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")),
+            TWO_BLOCK_DIGEST);
+  EXPECT_EQ(Common::SHA1::CalculateDigest(std::string(1000000, 'a')), MILLION_A_DIGEST);
+}
+
+TEST(SHA1, IncrementalUpdates)
+{
+  const std::string data(1000000, 'a');
+
+  // Split the message at sizes that don't line up with the 64-byte block size
+  for (size_t piece_size : {1, 3, 63, 64, 65, 1000, 0x400})
+  {
+    std::unique_ptr<Common::SHA1::Context> context = Common::SHA1::CreateContext();
+    for (size_t i = 0; i < data.size(); i += piece_size)
+    {
+      const size_t len = std::min(piece_size, data.size() - i);
+      context->Update(reinterpret_cast<const u8*>(data.data()) + i, len);
+    }
+    EXPECT_EQ(context->Finish(), MILLION_A_DIGEST) << "piece size " << piece_size;
+  }
+}
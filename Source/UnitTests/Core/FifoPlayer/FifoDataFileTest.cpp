@@ -0,0 +1,139 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+
+namespace
+{
+// Incompressible data, so that the size of the file shows whether a block was stored twice.
+std::vector<u8> MakeData(size_t size, u32 seed)
+{
+  std::vector<u8> data(size);
+  u32 state = seed * 2654435761u + 1;
+  for (u8& byte : data)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    byte = static_cast<u8>(state);
+  }
+  return data;
+}
+
+MemoryUpdate MakeMemoryUpdate(u32 fifo_position, u32 address, std::vector<u8> data,
+                              MemoryUpdate::Type type)
+{
+  MemoryUpdate update;
+  update.fifoPosition = fifo_position;
+  update.address = address;
+  update.data = std::move(data);
+  update.type = type;
+  return update;
+}
+
+void ExpectFramesEqual(const FifoFrameInfo& expected, const FifoFrameInfo& actual)
+{
+  EXPECT_EQ(expected.fifoData, actual.fifoData);
+  EXPECT_EQ(expected.fifoStart, actual.fifoStart);
+  EXPECT_EQ(expected.fifoEnd, actual.fifoEnd);
+  ASSERT_EQ(expected.memoryUpdates.size(), actual.memoryUpdates.size());
+  for (size_t i = 0; i < expected.memoryUpdates.size(); ++i)
+  {
+    EXPECT_EQ(expected.memoryUpdates[i].fifoPosition, actual.memoryUpdates[i].fifoPosition);
+    EXPECT_EQ(expected.memoryUpdates[i].address, actual.memoryUpdates[i].address);
+    EXPECT_EQ(expected.memoryUpdates[i].type, actual.memoryUpdates[i].type);
+    EXPECT_EQ(expected.memoryUpdates[i].data, actual.memoryUpdates[i].data);
+  }
+}
+}  // namespace
+
+class FifoDataFileTest : public testing::Test
+{
+protected:
+  FifoDataFileTest() : m_temp_dir{File::CreateTempDir()} {}
+  ~FifoDataFileTest() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  std::string m_temp_dir;
+};
+
+TEST_F(FifoDataFileTest, SaveAndLoad)
+{
+  constexpr u32 NUM_FRAMES = 12;
+  constexpr size_t SHARED_UPDATE_SIZE = 64 * 1024;
+
+  auto file = std::make_unique<FifoDataFile>();
+  file->SetIsWii(true);
+  for (u32 i = 0; i < FifoDataFile::BP_MEM_SIZE; ++i)
+    file->GetBPMem()[i] = i * 3;
+  for (u32 i = 0; i < FifoDataFile::CP_MEM_SIZE; ++i)
+    file->GetCPMem()[i] = i * 5;
+  for (u32 i = 0; i < FifoDataFile::XF_MEM_SIZE; ++i)
+    file->GetXFMem()[i] = i * 7;
+  for (u32 i = 0; i < FifoDataFile::XF_REGS_SIZE; ++i)
+    file->GetXFRegs()[i] = i * 11;
+  for (u32 i = 0; i < FifoDataFile::TEX_MEM_SIZE; ++i)
+    file->GetTexMem()[i] = static_cast<u8>(i * 13);
+
+  // Every frame updates the same texture, which should only be stored once.
+  const std::vector<u8> shared_data = MakeData(SHARED_UPDATE_SIZE, 0);
+  std::vector<FifoFrameInfo> frames;
+  for (u32 i = 0; i < NUM_FRAMES; ++i)
+  {
+    FifoFrameInfo frame;
+    frame.fifoData = MakeData(100 + i * 37, i + 1);
+    frame.fifoStart = 0x1000 * i;
+    frame.fifoEnd = frame.fifoStart + static_cast<u32>(frame.fifoData.size());
+    frame.memoryUpdates.push_back(
+        MakeMemoryUpdate(0, 0x80001000, shared_data, MemoryUpdate::TEXTURE_MAP));
+    frame.memoryUpdates.push_back(
+        MakeMemoryUpdate(20, 0x80100000 + i, MakeData(32 + i, i + 100), MemoryUpdate::XF_DATA));
+    frames.push_back(frame);
+    file->AddFrame(std::move(frame));
+  }
+
+  const std::string filename = m_temp_dir + "/test.dff";
+  ASSERT_TRUE(file->Save(filename));
+
+  // Without deduplication, the shared update alone would take up this much space.
+  EXPECT_LT(File::GetSize(filename), SHARED_UPDATE_SIZE * 2);
+
+  const std::unique_ptr<FifoDataFile> loaded = FifoDataFile::Load(filename, false);
+  ASSERT_TRUE(loaded);
+  EXPECT_TRUE(loaded->GetIsWii());
+  EXPECT_TRUE(std::equal(file->GetBPMem(), file->GetBPMem() + FifoDataFile::BP_MEM_SIZE,
+                         loaded->GetBPMem()));
+  EXPECT_TRUE(std::equal(file->GetCPMem(), file->GetCPMem() + FifoDataFile::CP_MEM_SIZE,
+                         loaded->GetCPMem()));
+  EXPECT_TRUE(std::equal(file->GetXFMem(), file->GetXFMem() + FifoDataFile::XF_MEM_SIZE,
+                         loaded->GetXFMem()));
+  EXPECT_TRUE(std::equal(file->GetXFRegs(), file->GetXFRegs() + FifoDataFile::XF_REGS_SIZE,
+                         loaded->GetXFRegs()));
+  EXPECT_TRUE(std::equal(file->GetTexMem(), file->GetTexMem() + FifoDataFile::TEX_MEM_SIZE,
+                         loaded->GetTexMem()));
+
+  // Read the frames out of order, and more of them than are cached, so that frames are evicted
+  // and read from the file again.
+  ASSERT_EQ(NUM_FRAMES, loaded->GetFrameCount());
+  for (u32 pass = 0; pass < 2; ++pass)
+  {
+    for (u32 i = 0; i < NUM_FRAMES; ++i)
+    {
+      const u32 index = (i * 5 + pass) % NUM_FRAMES;
+      const std::shared_ptr<const FifoFrameInfo> frame = loaded->GetFrame(index);
+      ASSERT_TRUE(frame);
+      ExpectFramesEqual(frames[index], *frame);
+    }
+  }
+}
@@ -0,0 +1,264 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/Crypto/SHA1.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Swap.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/BCZBlob.h"
+#include "DiscIO/Blob.h"
+
+namespace
+{
+constexpr u64 CLUSTER_SIZE = 0x8000;
+constexpr u64 CLUSTER_HEADER_SIZE = 0x400;
+constexpr u64 CLUSTER_DATA_SIZE = CLUSTER_SIZE - CLUSTER_HEADER_SIZE;
+constexpr u64 CLUSTERS_PER_GROUP = 64;
+
+constexpr u64 PARTITION_OFFSET = 0x50000;
+constexpr u64 PARTITION_DATA_OFFSET = 0x20000;
+constexpr u64 PARTITION_H3_OFFSET = 0x8000;
+constexpr u64 DATA_START = PARTITION_OFFSET + PARTITION_DATA_OFFSET;
+// Two full groups and a partial one
+constexpr u64 NUM_CLUSTERS = 160;
+// Data after the partition, which is stored in a raw region
+constexpr u64 TAIL_SIZE = 0x12340;
+
+// The group whose hashes don't match its data, so that it has to be stored in a raw region
+constexpr u64 CORRUPT_GROUP = 1;
+
+void Write32(std::vector<u8>* data, u64 offset, u32 value)
+{
+  value = Common::swap32(value);
+  std::memcpy(data->data() + offset, &value, sizeof(value));
+}
+
+// Generates the H0, H1 and H2 hashes of a group, like the disc mastering tools do.
+void HashGroup(const u8* data, u64 num_clusters, u8* headers)
+{
+  for (u64 i = 0; i < num_clusters; ++i)
+  {
+    for (u64 j = 0; j < CLUSTER_DATA_SIZE / 0x400; ++j)
+    {
+      const auto h0 =
+          Common::SHA1::CalculateDigest(data + i * CLUSTER_DATA_SIZE + j * 0x400, 0x400);
+      std::copy(h0.begin(), h0.end(), headers + i * CLUSTER_HEADER_SIZE + j * h0.size());
+    }
+  }
+
+  std::array<u8, 0xA0> h2_table{};
+  for (u64 subgroup = 0; subgroup * 8 < num_clusters; ++subgroup)
+  {
+    const u64 end = std::min(subgroup * 8 + 8, num_clusters);
+    std::array<u8, 0xA0> h1_table{};
+    for (u64 i = subgroup * 8; i < end; ++i)
+    {
+      const auto h1 = Common::SHA1::CalculateDigest(headers + i * CLUSTER_HEADER_SIZE, 0x26C);
+      std::copy(h1.begin(), h1.end(), h1_table.begin() + (i - subgroup * 8) * h1.size());
+    }
+    for (u64 i = subgroup * 8; i < end; ++i)
+      std::copy(h1_table.begin(), h1_table.end(), headers + i * CLUSTER_HEADER_SIZE + 0x280);
+
+    const auto h2 = Common::SHA1::CalculateDigest(h1_table);
+    std::copy(h2.begin(), h2.end(), h2_table.begin() + subgroup * h2.size());
+  }
+
+  for (u64 i = 0; i < num_clusters; ++i)
+    std::copy(h2_table.begin(), h2_table.end(), headers + i * CLUSTER_HEADER_SIZE + 0x340);
+}
+
+// Builds a Wii disc with one partition. Its decrypted data contains all-zero, incompressible
+// and compressible areas, and one group doesn't match its hashes.
+void MakeWiiDisc(std::vector<u8>* disc, std::vector<u8>* decrypted)
+{
+  std::mt19937 rng(0);
+
+  disc->assign(DATA_START + NUM_CLUSTERS * CLUSTER_SIZE + TAIL_SIZE, 0);
+  std::memcpy(disc->data(), "RTST01", 6);
+  Write32(disc, 0x18, 0x5D1C9EA3);
+  Write32(disc, 0x40000, 1);
+  Write32(disc, 0x40004, 0x40020 >> 2);
+  Write32(disc, 0x40020, PARTITION_OFFSET >> 2);
+  for (u64 i = DATA_START + NUM_CLUSTERS * CLUSTER_SIZE; i < disc->size(); ++i)
+    (*disc)[i] = static_cast<u8>(i * 7);
+
+  std::vector<u8> ticket(sizeof(IOS::ES::Ticket));
+  Write32(&ticket, 0, 0x00010001);
+  std::memcpy(ticket.data() + 0x140, "Root-CA00000001-XS00000003", 26);
+  for (u64 i = 0; i < 16; ++i)
+    ticket[0x1BF + i] = static_cast<u8>(rng());
+  std::copy(ticket.begin(), ticket.end(), disc->begin() + PARTITION_OFFSET);
+  Write32(disc, PARTITION_OFFSET + 0x2B4, PARTITION_H3_OFFSET >> 2);
+  Write32(disc, PARTITION_OFFSET + 0x2B8, PARTITION_DATA_OFFSET >> 2);
+  Write32(disc, PARTITION_OFFSET + 0x2BC, (NUM_CLUSTERS * CLUSTER_SIZE) >> 2);
+
+  decrypted->resize(NUM_CLUSTERS * CLUSTER_DATA_SIZE);
+  for (u64 i = 0; i < decrypted->size(); ++i)
+  {
+    switch (i / 0x20000 % 4)
+    {
+    case 0:
+      (*decrypted)[i] = 0;
+      break;
+    case 1:
+      (*decrypted)[i] = static_cast<u8>(rng());
+      break;
+    default:
+      (*decrypted)[i] = static_cast<u8>(i / 13);
+      break;
+    }
+  }
+
+  const auto key = IOS::ES::TicketReader(std::move(ticket)).GetTitleKey();
+  const auto encrypt = Common::AES::CreateContextEncrypt(key.data());
+  for (u64 group = 0; group * CLUSTERS_PER_GROUP < NUM_CLUSTERS; ++group)
+  {
+    const u64 first_cluster = group * CLUSTERS_PER_GROUP;
+    const u64 num_clusters = std::min(CLUSTERS_PER_GROUP, NUM_CLUSTERS - first_cluster);
+    u8* const group_data = decrypted->data() + first_cluster * CLUSTER_DATA_SIZE;
+
+    std::vector<u8> headers(num_clusters * CLUSTER_HEADER_SIZE);
+    HashGroup(group_data, num_clusters, headers.data());
+    const auto h3 = Common::SHA1::CalculateDigest(headers.data() + 0x340, 0xA0);
+    std::copy(h3.begin(), h3.end(),
+              disc->begin() + PARTITION_OFFSET + PARTITION_H3_OFFSET + group * h3.size());
+
+    if (group == CORRUPT_GROUP)
+      group_data[0x1234] ^= 1;
+
+    for (u64 i = 0; i < num_clusters; ++i)
+    {
+      u8* const cluster = disc->data() + DATA_START + (first_cluster + i) * CLUSTER_SIZE;
+      const std::array<u8, 16> iv{};
+      encrypt->Crypt(iv.data(), headers.data() + i * CLUSTER_HEADER_SIZE, cluster,
+                     CLUSTER_HEADER_SIZE);
+      encrypt->Crypt(cluster + 0x3D0, group_data + i * CLUSTER_DATA_SIZE,
+                     cluster + CLUSTER_HEADER_SIZE, CLUSTER_DATA_SIZE);
+    }
+  }
+}
+}  // namespace
+
+class BCZTest : public testing::Test
+{
+protected:
+  BCZTest() : m_temp_dir{File::CreateTempDir()} {}
+  ~BCZTest() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  std::string m_temp_dir;
+};
+
+TEST_F(BCZTest, WiiRoundTrip)
+{
+  std::vector<u8> disc;
+  std::vector<u8> decrypted;
+  MakeWiiDisc(&disc, &decrypted);
+
+  const std::string iso_path = m_temp_dir + "/disc.iso";
+  const std::string bcz_path = m_temp_dir + "/disc.bcz";
+  ASSERT_TRUE(File::WriteStringToFile(iso_path, std::string(disc.begin(), disc.end())));
+  ASSERT_TRUE(DiscIO::ConvertToBCZ(iso_path, bcz_path, 0x10000));
+
+  // Check that the image covers everything that should be tested: partition regions, raw regions
+  // (including the group with bad hashes) and chunks that only contain zeroes in both of them.
+  {
+    File::IOFile file(bcz_path, "rb");
+    DiscIO::BCZHeader header;
+    ASSERT_TRUE(file.ReadArray(&header, 1));
+    std::vector<DiscIO::BCZPartition> partitions(header.num_partitions);
+    std::vector<DiscIO::BCZRegion> regions(header.num_regions);
+    std::vector<DiscIO::BCZChunk> chunks(header.num_chunks);
+    ASSERT_TRUE(file.Seek(header.index_offset, SEEK_SET));
+    ASSERT_TRUE(file.ReadArray(partitions.data(), partitions.size()));
+    ASSERT_TRUE(file.ReadArray(regions.data(), regions.size()));
+    ASSERT_TRUE(file.ReadArray(chunks.data(), chunks.size()));
+
+    ASSERT_EQ(1u, partitions.size());
+    EXPECT_EQ(PARTITION_OFFSET, partitions[0].partition_offset);
+
+    const u64 corrupt_group_offset = DATA_START + CORRUPT_GROUP * CLUSTERS_PER_GROUP * CLUSTER_SIZE;
+    bool corrupt_group_is_raw = false;
+    bool has_zero_raw_chunk = false;
+    bool has_zero_partition_chunk = false;
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+      const DiscIO::BCZRegion& region = regions[i];
+      const bool raw = region.partition == DiscIO::BCZRegion::RAW;
+      if (raw && region.offset <= corrupt_group_offset &&
+          corrupt_group_offset - region.offset < region.size)
+      {
+        corrupt_group_is_raw = true;
+      }
+
+      const u32 end_chunk = i + 1 < regions.size() ? regions[i + 1].first_chunk : header.num_chunks;
+      for (u32 j = region.first_chunk; j < end_chunk; ++j)
+      {
+        if (chunks[j].size == 0)
+          (raw ? has_zero_raw_chunk : has_zero_partition_chunk) = true;
+      }
+    }
+    EXPECT_TRUE(corrupt_group_is_raw);
+    EXPECT_TRUE(has_zero_raw_chunk);
+    EXPECT_TRUE(has_zero_partition_chunk);
+  }
+
+  const std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(bcz_path);
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(DiscIO::BlobType::BCZ, reader->GetBlobType());
+  EXPECT_EQ(disc.size(), reader->GetDataSize());
+  EXPECT_LT(reader->GetRawSize(), disc.size());
+  ASSERT_TRUE(reader->SupportsReadWiiDecrypted());
+
+  std::vector<u8> buffer(disc.size());
+  ASSERT_TRUE(reader->Read(0, disc.size(), buffer.data()));
+  EXPECT_TRUE(buffer == disc);
+
+  buffer.resize(decrypted.size());
+  ASSERT_TRUE(reader->ReadWiiDecrypted(0, decrypted.size(), buffer.data(), PARTITION_OFFSET));
+  EXPECT_TRUE(buffer == decrypted);
+
+  // Reads which don't line up with clusters, chunks or groups, mixing both kinds of reads
+  std::mt19937 rng(1);
+  for (int i = 0; i < 200; ++i)
+  {
+    const bool read_decrypted = i % 2 != 0;
+    const std::vector<u8>& expected = read_decrypted ? decrypted : disc;
+    const u64 offset = rng() % expected.size();
+    const u64 size = std::min<u64>(rng() % (i % 3 == 0 ? 0x30000 : 0x1000) + 1,
+                                   expected.size() - offset);
+
+    buffer.resize(size);
+    if (read_decrypted)
+      ASSERT_TRUE(reader->ReadWiiDecrypted(offset, size, buffer.data(), PARTITION_OFFSET));
+    else
+      ASSERT_TRUE(reader->Read(offset, size, buffer.data()));
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), expected.begin() + offset))
+        << (read_decrypted ? "decrypted " : "") << "offset " << offset << " size " << size;
+  }
+
+  // Sequential reads, which the read-ahead thread reads ahead of
+  reader->EnableReadAhead(0x100000, 0x40000);
+  for (u64 offset = 0; offset < decrypted.size(); offset += 0x2000)
+  {
+    const u64 size = std::min<u64>(0x2000, decrypted.size() - offset);
+    buffer.resize(size);
+    ASSERT_TRUE(reader->ReadWiiDecrypted(offset, size, buffer.data(), PARTITION_OFFSET));
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), decrypted.begin() + offset))
+        << "decrypted offset " << offset;
+  }
+}
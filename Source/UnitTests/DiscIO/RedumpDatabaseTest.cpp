@@ -0,0 +1,101 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/RedumpDatabase.h"
+
+namespace
+{
+constexpr char DAT[] = R"XML(<?xml version="1.0"?>
+<datafile>
+  <header><name>Test</name></header>
+  <game name="Other Game (USA)">
+    <rom name="other.iso" size="1459978240" crc="12345678" md5="00774016240e2794fb8b5308542cdb8b"
+         sha1="0000000000000000000000000000000000000000"/>
+  </game>
+  <game name="Broken Entry">
+    <rom name="broken.iso" crc="zz"/>
+  </game>
+  <game name="Test Game (Europe)">
+    <rom name="test.iso" size="1459978240" crc="76B1A3DA" md5="63774016240e2794fb8b5308542cdb8b"
+         sha1="ded682c72beb24e9126d32f83442bb61a78bd1d0"/>
+  </game>
+</datafile>
+)XML";
+
+const std::vector<u8> CRC32 = {0x76, 0xb1, 0xa3, 0xda};
+const std::vector<u8> MD5 = {0x63, 0x77, 0x40, 0x16, 0x24, 0x0e, 0x27, 0x94,
+                             0xfb, 0x8b, 0x53, 0x08, 0x54, 0x2c, 0xdb, 0x8b};
+const std::vector<u8> SHA1 = {0xde, 0xd6, 0x82, 0xc7, 0x2b, 0xeb, 0x24, 0xe9, 0x12, 0x6d,
+                              0x32, 0xf8, 0x34, 0x42, 0xbb, 0x61, 0xa7, 0x8b, 0xd1, 0xd0};
+}  // namespace
+
+class RedumpDatabaseTest : public testing::Test
+{
+protected:
+  RedumpDatabaseTest()
+      : m_temp_dir{File::CreateTempDir()}, m_dat_dir{m_temp_dir + "/dat/"},
+        m_index_dir{m_temp_dir + "/index/"}
+  {
+    File::CreateDir(m_dat_dir);
+    File::CreateDir(m_index_dir);
+  }
+  ~RedumpDatabaseTest() override { File::DeleteDirRecursively(m_temp_dir); }
+
+  std::string m_temp_dir;
+  std::string m_dat_dir;
+  std::string m_index_dir;
+};
+
+TEST_F(RedumpDatabaseTest, Lookup)
+{
+  ASSERT_TRUE(File::WriteStringToFile(m_dat_dir + "test.dat", DAT));
+
+  // The first load parses the DAT file and writes the index, the second one reads the index
+  for (int i = 0; i < 2; ++i)
+  {
+    const std::unique_ptr<DiscIO::RedumpDatabase> database =
+        DiscIO::RedumpDatabase::Load(m_dat_dir, m_index_dir);
+    ASSERT_TRUE(database);
+    EXPECT_TRUE(File::Exists(m_index_dir + "test.idx"));
+    EXPECT_EQ(2u, database->GetEntryCount());
+
+    DiscIO::RedumpDatabase::Result result = database->Lookup(CRC32, {}, {});
+    EXPECT_EQ(DiscIO::RedumpDatabase::Status::Match, result.status);
+    EXPECT_EQ("Test Game (Europe)", result.name);
+
+    result = database->Lookup(CRC32, MD5, SHA1);
+    EXPECT_EQ(DiscIO::RedumpDatabase::Status::Match, result.status);
+    EXPECT_EQ("Test Game (Europe)", result.name);
+
+    // The CRC32 matches, but the SHA-1 doesn't
+    std::vector<u8> bad_sha1 = SHA1;
+    bad_sha1.back() ^= 1;
+    result = database->Lookup(CRC32, MD5, bad_sha1);
+    EXPECT_EQ(DiscIO::RedumpDatabase::Status::NoMatch, result.status);
+    EXPECT_TRUE(result.name.empty());
+  }
+}
+
+TEST_F(RedumpDatabaseTest, IndexIsRebuiltWhenDatChanges)
+{
+  ASSERT_TRUE(File::WriteStringToFile(m_dat_dir + "test.dat", DAT));
+  ASSERT_TRUE(DiscIO::RedumpDatabase::Load(m_dat_dir, m_index_dir));
+
+  std::string dat = DAT;
+  dat.replace(dat.find("Test Game (Europe)"), 18, "Test Game (France)");
+  ASSERT_TRUE(File::WriteStringToFile(m_dat_dir + "test.dat", dat));
+
+  const std::unique_ptr<DiscIO::RedumpDatabase> database =
+      DiscIO::RedumpDatabase::Load(m_dat_dir, m_index_dir);
+  ASSERT_TRUE(database);
+  EXPECT_EQ("Test Game (France)", database->Lookup(CRC32, MD5, SHA1).name);
+}
@@ -0,0 +1,160 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/Event.h"
+#include "VideoCommon/AsyncShaderCompiler.h"
+
+using VideoCommon::AsyncShaderCompiler;
+
+namespace
+{
+struct TestLog
+{
+  std::mutex lock;
+  std::vector<int> compiled;
+  std::vector<int> retrieved;
+  std::vector<int> cancelled;
+};
+
+class TestWorkItem final : public AsyncShaderCompiler::WorkItem
+{
+public:
+  TestWorkItem(TestLog* log_, int id_, Common::Event* gate_ = nullptr)
+      : log(log_), id(id_), gate(gate_)
+  {
+  }
+
+  bool Compile() override
+  {
+    if (gate)
+      gate->Wait();
+
+    std::lock_guard<std::mutex> guard(log->lock);
+    log->compiled.push_back(id);
+    return true;
+  }
+
+  void Retrieve() override { log->retrieved.push_back(id); }
+  void Cancel() override { log->cancelled.push_back(id); }
+
+private:
+  TestLog* log;
+  int id;
+  Common::Event* gate;
+};
+
+constexpr size_t LaneIndex(AsyncShaderCompiler::Priority priority)
+{
+  return static_cast<size_t>(priority);
+}
+}  // namespace
+
+TEST(AsyncShaderCompiler, SynchronousWithoutWorkers)
+{
+  TestLog log;
+  AsyncShaderCompiler compiler;
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 1),
+                         AsyncShaderCompiler::Priority::Precompile);
+  EXPECT_EQ(log.compiled, std::vector<int>{1});
+  EXPECT_TRUE(compiler.HasCompletedWork());
+
+  compiler.RetrieveWorkItems();
+  EXPECT_EQ(log.retrieved, std::vector<int>{1});
+  EXPECT_FALSE(compiler.HasCompletedWork());
+}
+
+TEST(AsyncShaderCompiler, OnDemandBeforeSpeculative)
+{
+  TestLog log;
+  Common::Event gate;
+  AsyncShaderCompiler compiler;
+  ASSERT_TRUE(compiler.StartWorkerThreads(1));
+
+  // Block the only worker, then queue lower priority work before higher priority work.
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 0, &gate),
+                         AsyncShaderCompiler::Priority::OnDemand);
+  while (compiler.GetMetrics()[LaneIndex(AsyncShaderCompiler::Priority::OnDemand)].queue_depth != 0)
+    std::this_thread::yield();
+
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 3),
+                         AsyncShaderCompiler::Priority::Precompile);
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 2),
+                         AsyncShaderCompiler::Priority::UberShader);
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 1),
+                         AsyncShaderCompiler::Priority::OnDemand);
+  gate.Set();
+
+  compiler.WaitUntilCompletion();
+  compiler.StopWorkerThreads();
+  compiler.RetrieveWorkItems();
+
+  EXPECT_EQ(log.compiled, (std::vector<int>{0, 1, 2, 3}));
+  EXPECT_EQ(log.retrieved, (std::vector<int>{0, 1, 2, 3}));
+
+  const AsyncShaderCompiler::Metrics metrics = compiler.GetMetrics();
+  EXPECT_EQ(metrics[LaneIndex(AsyncShaderCompiler::Priority::OnDemand)].items_retrieved, 2u);
+  EXPECT_EQ(metrics[LaneIndex(AsyncShaderCompiler::Priority::UberShader)].items_retrieved, 1u);
+  EXPECT_EQ(metrics[LaneIndex(AsyncShaderCompiler::Priority::Precompile)].items_retrieved, 1u);
+}
+
+TEST(AsyncShaderCompiler, CancelPendingWork)
+{
+  TestLog log;
+  Common::Event gate;
+  AsyncShaderCompiler compiler;
+  ASSERT_TRUE(compiler.StartWorkerThreads(1));
+
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 0, &gate),
+                         AsyncShaderCompiler::Priority::OnDemand);
+  while (compiler.GetMetrics()[LaneIndex(AsyncShaderCompiler::Priority::OnDemand)].queue_depth != 0)
+    std::this_thread::yield();
+
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 1),
+                         AsyncShaderCompiler::Priority::OnDemand);
+  compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, 2),
+                         AsyncShaderCompiler::Priority::Precompile);
+  compiler.CancelPendingWork(AsyncShaderCompiler::Priority::Precompile);
+  gate.Set();
+
+  compiler.WaitUntilCompletion();
+  compiler.StopWorkerThreads();
+  compiler.RetrieveWorkItems();
+
+  EXPECT_EQ(log.compiled, (std::vector<int>{0, 1}));
+  EXPECT_EQ(log.cancelled, std::vector<int>{2});
+  EXPECT_EQ(
+      compiler.GetMetrics()[LaneIndex(AsyncShaderCompiler::Priority::Precompile)].items_cancelled,
+      1u);
+}
+
+TEST(AsyncShaderCompiler, ManyWorkers)
+{
+  constexpr int NUM_ITEMS = 1000;
+
+  TestLog log;
+  AsyncShaderCompiler compiler;
+  ASSERT_TRUE(compiler.StartWorkerThreads(4));
+  for (int i = 0; i < NUM_ITEMS; i++)
+  {
+    compiler.QueueWorkItem(compiler.CreateWorkItem<TestWorkItem>(&log, i),
+                           static_cast<AsyncShaderCompiler::Priority>(
+                               i % AsyncShaderCompiler::NUM_PRIORITIES));
+  }
+
+  compiler.WaitUntilCompletion();
+  compiler.StopWorkerThreads();
+  compiler.RetrieveWorkItems();
+
+  EXPECT_EQ(log.compiled.size(), static_cast<size_t>(NUM_ITEMS));
+  EXPECT_EQ(log.retrieved.size(), static_cast<size_t>(NUM_ITEMS));
+  EXPECT_FALSE(compiler.HasPendingWork());
+}
@@ -0,0 +1,123 @@
+// Copyright 2020 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/IndexGenerator.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+// Large enough for a batch of the biggest primitive with primitive restart.
+constexpr size_t INDEX_BUFFER_SIZE = 8 * 65536;
+
+std::vector<u16> GenerateIndices(bool use_simd, int primitive, u32 base_vertex, u32 num_verts)
+{
+  // No primitive generates more than three indices per vertex, plus a restart index.
+  std::vector<u16> buffer(base_vertex + num_verts * 3 + 1);
+  IndexGenerator::SetUseSIMD(use_simd);
+  IndexGenerator::Start(buffer.data());
+
+  // Offset the first vertex, so that patterns which depend on it are covered.
+  if (base_vertex > 0)
+    IndexGenerator::AddIndices(OpcodeDecoder::GX_DRAW_POINTS, base_vertex);
+  IndexGenerator::AddIndices(primitive, num_verts);
+
+  buffer.resize(IndexGenerator::GetIndexLen());
+  return buffer;
+}
+
+const int s_triangle_primitives[] = {
+    OpcodeDecoder::GX_DRAW_QUADS, OpcodeDecoder::GX_DRAW_QUADS_2,
+    OpcodeDecoder::GX_DRAW_TRIANGLES, OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP,
+    OpcodeDecoder::GX_DRAW_TRIANGLE_FAN};
+}  // namespace
+
+class IndexGeneratorTest : public testing::TestWithParam<bool>
+{
+protected:
+  void SetUp() override
+  {
+    g_Config.backend_info.bSupportsPrimitiveRestart = GetParam();
+    IndexGenerator::Init();
+  }
+
+  void TearDown() override { IndexGenerator::SetUseSIMD(true); }
+};
+INSTANTIATE_TEST_CASE_P(PrimitiveRestart, IndexGeneratorTest, testing::Bool());
+
+TEST_P(IndexGeneratorTest, SIMDMatchesScalar)
+{
+  for (int primitive : s_triangle_primitives)
+  {
+    for (u32 base_vertex : {0u, 1u, 7u, 65000u})
+    {
+      for (u32 num_verts = 0; num_verts < 200; num_verts++)
+      {
+        const std::vector<u16> scalar = GenerateIndices(false, primitive, base_vertex, num_verts);
+        const std::vector<u16> simd = GenerateIndices(true, primitive, base_vertex, num_verts);
+        ASSERT_EQ(scalar, simd) << "primitive " << primitive << ", base vertex " << base_vertex
+                                << ", " << num_verts << " vertices";
+      }
+    }
+  }
+}
+
+TEST_P(IndexGeneratorTest, StripWinding)
+{
+  const std::vector<u16> indices =
+      GenerateIndices(true, OpcodeDecoder::GX_DRAW_TRIANGLE_STRIP, 0, 20);
+  if (GetParam())
+  {
+    // Strips are passed through, terminated by a restart index.
+    ASSERT_EQ(indices.size(), 21u);
+    for (u16 i = 0; i < 20; i++)
+      EXPECT_EQ(indices[i], i);
+    EXPECT_EQ(indices[20], 0xFFFF);
+  }
+  else
+  {
+    // Every other triangle swaps its last two vertices, to keep the winding consistent.
+    ASSERT_EQ(indices.size(), 18u * 3u);
+    for (u16 i = 0; i < 18; i++)
+    {
+      const bool odd = (i & 1) != 0;
+      EXPECT_EQ(indices[i * 3 + 0], i);
+      EXPECT_EQ(indices[i * 3 + 1], odd ? i + 2 : i + 1);
+      EXPECT_EQ(indices[i * 3 + 2], odd ? i + 1 : i + 2);
+    }
+  }
+}
+
+// A benchmark rather than a test. Run it with --gtest_also_run_disabled_tests.
+TEST_P(IndexGeneratorTest, DISABLED_IndexGenerationSpeed)
+{
+  constexpr u32 NUM_VERTS = 60000;
+  constexpr int NUM_ITERATIONS = 200;
+  std::vector<u16> buffer(INDEX_BUFFER_SIZE);
+
+  for (int primitive : s_triangle_primitives)
+  {
+    for (bool use_simd : {false, true})
+    {
+      IndexGenerator::SetUseSIMD(use_simd);
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < NUM_ITERATIONS; i++)
+      {
+        IndexGenerator::Start(buffer.data());
+        IndexGenerator::AddIndices(primitive, NUM_VERTS);
+      }
+      const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+      printf("primitive: %d, simd: %d, %.2f us per batch\n", primitive, use_simd,
+             static_cast<double>(duration.count()) / NUM_ITERATIONS);
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#! /usr/bin/env python3
+
+"""
+compare-frame-checksums.py <log a> <log b>
+
+Compares two frame checksum logs, as written to Dump/Frames/framechecksums.txt
+when Settings/LogFrameChecksums is enabled in GFX.ini, and reports the first
+frame where the output of the two runs differs.
+
+Both runs should play back the same DTM movie or FIFO log with the same
+graphics settings, as the checksums depend on the output resolution.
+
+Exits with 0 if the logs match, and with 1 if they diverge.
+"""
+
+import sys
+
+def read_log(path):
+    '''Returns a list of (ticks, resolution, checksum) tuples, indexed by frame number.'''
+    frames = []
+    with open(path) as f:
+        for line_number, line in enumerate(f, 1):
+            fields = line.split()
+            if not fields:
+                continue
+            if len(fields) != 4 or int(fields[0]) != len(frames):
+                sys.stderr.write('%s:%d: malformed line\n' % (path, line_number))
+                sys.exit(2)
+            frames.append((int(fields[1]), fields[2], fields[3]))
+    return frames
+
+def compare_logs(a, b):
+    '''Returns the number of the first frame which differs, or None if the logs match.'''
+    for number, (frame_a, frame_b) in enumerate(zip(a, b)):
+        if frame_a != frame_b:
+            return number
+    if len(a) != len(b):
+        return min(len(a), len(b))
+    return None
+
+def describe_frame(frames, number):
+    if number >= len(frames):
+        return 'missing'
+    ticks, resolution, checksum = frames[number]
+    return '%s at %s, %d ticks' % (checksum, resolution, ticks)
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+
+    a, b = read_log(sys.argv[1]), read_log(sys.argv[2])
+    number = compare_logs(a, b)
+    if number is None:
+        print('Logs match (%d frames)' % len(a))
+        return 0
+
+    print('First divergent frame: %d' % number)
+    print('    %s: %s' % (sys.argv[1], describe_frame(a, number)))
+    print('    %s: %s' % (sys.argv[2], describe_frame(b, number)))
+    if number < min(len(a), len(b)) and a[number][0] != b[number][0]:
+        print('The frames were presented at different times, so emulation timing diverged.')
+    return 1
+
+if __name__ == '__main__':
+    sys.exit(main())